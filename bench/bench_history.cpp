@@ -0,0 +1,121 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/history.hpp>
+#include <lib/history_tree_node.hpp>
+#include <lib/tree_statistics.hpp>
+
+using namespace TreeAndHistoryTraversal;
+using namespace History;
+using namespace HistoryTreeNode;
+
+/**
+ * Every symbol is legal until the history reaches maxDepth, so the full tree
+ * has alphabetSize^maxDepth terminals.
+ */
+class BenchStringHistory : public StringHistory {
+ public:
+  BenchStringHistory(size_t alphabetSize, size_t maxDepth)
+      : StringHistory::StringHistory(alphabet(alphabetSize)),
+        maxDepth_(maxDepth) {}
+  virtual ~BenchStringHistory() {}
+  virtual BenchStringHistory* clone() const override {
+    return new BenchStringHistory(*this);
+  }
+
+  virtual bool suffixIsLegal(const std::string&) const override {
+    return state_.size() < maxDepth_;
+  }
+
+ protected:
+  static std::vector<std::string> alphabet(size_t alphabetSize) {
+    std::vector<std::string> symbols;
+    for (size_t i = 0; i < alphabetSize; ++i) {
+      symbols.push_back(std::to_string(i));
+    }
+    return symbols;
+  }
+
+ protected:
+  const size_t maxDepth_;
+};
+
+void registerBenchmarks(Bench::Suite* suite) {
+  suite->add("StringHistory::push+pop", {2, 8, 32}, [](size_t alphabetSize) {
+    std::shared_ptr<BenchStringHistory> h(
+        new BenchStringHistory(alphabetSize, 1));
+    const std::string symbol = std::to_string(alphabetSize - 1);
+    return [h, symbol]() {
+      h->push(symbol);
+      h->pop();
+    };
+  });
+  // Size is the depth at which a 4-symbol history is cloned. The clone
+  // pushes once, which copies the state it shares.
+  suite->add("StringHistory::clone+push", {2, 8, 32}, [](size_t depth) {
+    std::shared_ptr<BenchStringHistory> h(new BenchStringHistory(4, depth));
+    for (size_t i = 0; i < depth - 1; ++i) {
+      h->push("0");
+    }
+    return [h]() {
+      std::unique_ptr<BenchStringHistory> clone(h->clone());
+      clone->push("3");
+      Bench::doNotOptimize(clone.get());
+    };
+  });
+  suite->add("StringHistory::eachSuccessor", {2, 8, 32},
+             [](size_t alphabetSize) {
+               std::shared_ptr<BenchStringHistory> h(
+                   new BenchStringHistory(alphabetSize, 1));
+               return [h]() {
+                 size_t n = 0;
+                 h->eachSuccessor([&n](size_t, size_t) {
+                   ++n;
+                   return false;
+                 });
+                 Bench::doNotOptimize(n);
+               };
+             });
+  // The pull-based equivalent of eachSuccessor
+  suite->add("StringHistory::legalSuffixes+pushSuffix", {2, 8, 32},
+             [](size_t alphabetSize) {
+               std::shared_ptr<BenchStringHistory> h(
+                   new BenchStringHistory(alphabetSize, 1));
+               return [h]() {
+                 size_t n = 0;
+                 for (const auto suffixIndex : h->legalSuffixes()) {
+                   h->pushSuffix(suffixIndex);
+                   ++n;
+                   h->pop();
+                 }
+                 Bench::doNotOptimize(n);
+               };
+             });
+  // Size is the depth of a complete 4-ary tree
+  suite->add("PreorderHistoryTreeTraversal::computeValue", {2, 4, 6, 8},
+             [](size_t depth) {
+               std::shared_ptr<PreorderHistoryTreeTraversal<std::string>>
+                   traversal(new PreorderHistoryTreeTraversal<std::string>(
+                       new BenchStringHistory(4, depth)));
+               return [traversal]() { traversal->computeValue(); };
+             });
+  // Size is the depth of a complete 4-ary tree. The sampled profile follows
+  // 64 paths whatever the depth.
+  suite->add("TreeStatistics::profile", {4, 6, 8}, [](size_t depth) {
+    std::shared_ptr<BenchStringHistory> root(new BenchStringHistory(4, depth));
+    return [root]() {
+      Bench::doNotOptimize(TreeStatistics::profile(*root).numNodes());
+    };
+  });
+  suite->add("TreeStatistics::profile/sampled", {4, 6, 8}, [](size_t depth) {
+    std::shared_ptr<BenchStringHistory> root(new BenchStringHistory(4, depth));
+    return [root]() {
+      Bench::doNotOptimize(
+          TreeStatistics::profile(*root, TreeStatistics::Options(1, 1, 64))
+              .numNodes());
+    };
+  });
+}
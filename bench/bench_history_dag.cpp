@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/history_dag.hpp>
+#include <lib/poker.hpp>
+#include <lib/tree_node.hpp>
+
+using namespace TreeAndHistoryTraversal;
+
+typedef HistoryDag::Dag<std::string, double> LeducDag;
+
+static std::shared_ptr<LeducDag> leducDag() {
+  Poker::LeducHoldemHistory root;
+  return std::make_shared<LeducDag>(HistoryDag::build<std::string, double>(
+      &root, [&root](History::History<std::string>*) {
+        return root.utility(0);
+      }));
+}
+
+/**
+ * Expands the DAG back into the tree that it stands for.
+ */
+static TreeNode::TreeNode<double>* expand(
+    const LeducDag& dag,
+    size_t node,
+    const std::function<double(double&&)>& combiner) {
+  if (dag.isTerminal(node)) {
+    return new TreeNode::StoredTerminalNode<double>(dag.terminalValues[node]);
+  }
+  auto interior = new TreeNode::StoredInteriorNode<double>(combiner);
+  for (size_t a = 0; a < dag.numChildren(node); ++a) {
+    interior->addChild(expand(dag, dag.child(node, a), combiner));
+  }
+  return interior;
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  // Sizes are node counts; both sum every leaf below each node.
+  const auto dag = leducDag();
+  fprintf(stderr, "Leduc hold'em: %s\n", dag->report().c_str());
+  suite->add("StoredInteriorNode::value/leduc", {dag->numTreeNodes},
+             [dag](size_t) {
+    std::shared_ptr<double> sum(new double(0.0));
+    std::shared_ptr<TreeNode::TreeNode<double>> root(
+        expand(*dag, dag->root(),
+               [sum](double&& childValue) { return *sum += childValue; }));
+    return [root]() { Bench::doNotOptimize(root->value()); };
+  });
+  suite->add("HistoryDag::Dag::evaluate/leduc", {dag->numNodes()},
+             [dag](size_t) {
+    return [dag]() {
+      Bench::doNotOptimize(
+          dag->evaluate([](size_t, const std::vector<double>& childValues) {
+            double total = 0.0;
+            for (const auto v : childValues) {
+              total += v;
+            }
+            return total;
+          }));
+    };
+  });
+  suite->add("HistoryDag::build/kuhn", {58}, [](size_t) {
+    return []() {
+      Poker::KuhnPokerHistory root;
+      Bench::doNotOptimize(HistoryDag::build<std::string, double>(
+                               &root, [&root](History::History<std::string>*) {
+                                 return root.utility(0);
+                               }).numNodes());
+    };
+  });
+}
@@ -0,0 +1,68 @@
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/info_set_index.hpp>
+#include <lib/poker.hpp>
+#include <lib/sequence_form.hpp>
+
+using namespace TreeAndHistoryTraversal;
+
+static std::shared_ptr<std::vector<std::string>> leducNames() {
+  Poker::LeducHoldemHistory root;
+  const auto game = SequenceForm::compile(&root);
+  return std::make_shared<std::vector<std::string>>(game.infoSetNames[0]);
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  // Each op looks up the row of one of Leduc hold'em's information sets.
+  suite->add("InfoSetIndex::PerfectHashIndex/leduc", {0}, [](size_t) {
+    const auto names = leducNames();
+    auto index = std::make_shared<InfoSetIndex::PerfectHashIndex>(*names);
+    auto i = std::make_shared<size_t>(0);
+    return [names, index, i]() {
+      *i = (*i + 1) % names->size();
+      Bench::doNotOptimize((*index)[(*names)[*i]]);
+    };
+  });
+  suite->add("InfoSetIndex::ShardedIndex/leduc", {0}, [](size_t) {
+    const auto names = leducNames();
+    auto index = std::make_shared<InfoSetIndex::ShardedIndex>();
+    for (const auto& name : *names) {
+      (*index)[name];
+    }
+    auto i = std::make_shared<size_t>(0);
+    return [names, index, i]() {
+      *i = (*i + 1) % names->size();
+      Bench::doNotOptimize((*index)[(*names)[*i]]);
+    };
+  });
+  // The unordered_map that SequenceForm::compile indexes with
+  suite->add("std::unordered_map::find/leduc", {0}, [](size_t) {
+    const auto names = leducNames();
+    auto index = std::make_shared<std::unordered_map<std::string, size_t>>();
+    for (size_t I = 0; I < names->size(); ++I) {
+      index->emplace((*names)[I], I);
+    }
+    auto i = std::make_shared<size_t>(0);
+    return [names, index, i]() {
+      *i = (*i + 1) % names->size();
+      Bench::doNotOptimize(index->find((*names)[*i])->second);
+    };
+  });
+  // Size is the number of keys
+  suite->add("InfoSetIndex::PerfectHashIndex::PerfectHashIndex",
+             {1 << 10, 1 << 16}, [](size_t numKeys) {
+               auto keys = std::make_shared<std::vector<std::string>>();
+               for (size_t k = 0; k < numKeys; ++k) {
+                 keys->push_back("I" + std::to_string(k));
+               }
+               return [keys]() {
+                 Bench::doNotOptimize(
+                     InfoSetIndex::PerfectHashIndex(*keys).size());
+               };
+             });
+}
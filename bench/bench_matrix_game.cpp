@@ -0,0 +1,69 @@
+#include <memory>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/matrix_game.hpp>
+#include <lib/policy_generator.hpp>
+
+using namespace TreeAndHistoryTraversal;
+using namespace PolicyGenerator;
+using namespace MatrixGame;
+
+static const std::vector<size_t> numActionsAtEachInfoSet{2};
+static const std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
+
+typedef Cfr<size_t, std::pair<size_t, size_t>, Numeric> MatrixGameCfr;
+
+static std::shared_ptr<MatrixGameCfr> newCfr(UpdateMode updateMode) {
+  const auto tables = []() {
+    return std::vector<
+        PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
+        new RegretMatchingTable<Numeric>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                         NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new RegretMatchingTable<Numeric>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                         NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+  };
+  return std::shared_ptr<MatrixGameCfr>(
+      new MatrixGameCfr(utilsForPlayer1, tables(), tables(), updateMode));
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  // The matrix game has a fixed size; size is the number of actions per
+  // player.
+  suite->add("Cfr::doIteration/alternating", {2}, [](size_t) {
+    auto cfr = newCfr(UpdateMode::ALTERNATING);
+    return [cfr]() { cfr->doIteration(); };
+  });
+  suite->add("Cfr::doIteration/simultaneous", {2}, [](size_t) {
+    auto cfr = newCfr(UpdateMode::SIMULTANEOUS);
+    return [cfr]() { cfr->doIteration(); };
+  });
+  suite->add("BestResponse::averageExploitability", {2}, [](size_t) {
+    std::shared_ptr<std::vector<std::vector<Numeric>>> profile(
+        new std::vector<std::vector<Numeric>>{{0.5, 0.5}, {0.25, 0.75}});
+    std::shared_ptr<BestResponse<Numeric>> br(
+        new BestResponse<Numeric>(utilsForPlayer1, *profile));
+    return [profile, br]() {
+      Bench::doNotOptimize(br->averageExploitability());
+    };
+  });
+  // Sized by samples per player
+  suite->add("SampledBestResponse::averageExploitability", {64, 1024},
+             [](size_t numSamples) {
+    std::shared_ptr<std::vector<std::vector<Numeric>>> profile(
+        new std::vector<std::vector<Numeric>>{{0.5, 0.5}, {0.25, 0.75}});
+    std::shared_ptr<Game::SampledBestResponse<MatrixGameHistory, Numeric>>
+        br(new Game::SampledBestResponse<MatrixGameHistory, Numeric>(
+            MatrixGameHistory(utilsForPlayer1), policyOf(*profile),
+            SamplingOptions(numSamples)));
+    return [profile, br]() {
+      Bench::doNotOptimize(br->averageExploitability().value);
+    };
+  });
+  suite->add("Cfr::averageExploitability", {2}, [](size_t) {
+    auto cfr = newCfr(UpdateMode::ALTERNATING);
+    cfr->doIterations(100);
+    return [cfr]() { Bench::doNotOptimize(cfr->averageExploitability()); };
+  });
+}
@@ -0,0 +1,28 @@
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+#include <bench_helper.hpp>
+
+#include <lib/multi_process.hpp>
+#include <lib/poker.hpp>
+#include <lib/sequence_form.hpp>
+
+using namespace TreeAndHistoryTraversal;
+
+void registerBenchmarks(Bench::Suite* suite) {
+  // Sizes are worker processes; compare against
+  // SequenceForm::Cfr::doIteration/leduc.
+  suite->add("MultiProcess::Cfr::doIteration/leduc", {1, 2, 4},
+             [](size_t numWorkers) {
+    Poker::LeducHoldemHistory root;
+    auto game = std::make_shared<SequenceForm::CompiledGame>(
+        SequenceForm::compile(&root));
+    auto cfr = std::make_shared<MultiProcess::Cfr>(
+        *game, numWorkers, "/tree_and_history_traversal_bench_" +
+                               std::to_string(getpid()) + "_" +
+                               std::to_string(numWorkers));
+    return [game, cfr]() { cfr->doIteration(); };
+  });
+}
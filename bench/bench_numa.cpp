@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/numa.hpp>
+#include <lib/policy_generator.hpp>
+
+using namespace TreeAndHistoryTraversal;
+
+// 128 MiB of double regrets, far past any last-level cache, in information
+// sets of four actions
+static const size_t numActionsPerInfoSet = 4;
+static const size_t numInfoSets = size_t(1) << 22;
+// Split across every thread in use, so time per op falls as nodes are added
+static const size_t numUpdates = size_t(1) << 20;
+
+struct SyntheticTable {
+  std::vector<size_t> numActionsAtEachInfoSet;
+  std::vector<size_t> numSequencesBeforeEachInfoSet;
+  std::unique_ptr<PolicyGenerator::RegretMatchingTable<>> table;
+  // The first information set in each node's partition of the table
+  std::vector<size_t> firstInfoSets;
+
+  SyntheticTable(Numa::Placement placement)
+      : numActionsAtEachInfoSet(numInfoSets, numActionsPerInfoSet),
+        numSequencesBeforeEachInfoSet(numInfoSets) {
+    for (size_t I = 0; I < numInfoSets; ++I) {
+      numSequencesBeforeEachInfoSet[I] = I * numActionsPerInfoSet;
+    }
+    const auto numSequences = numInfoSets * numActionsPerInfoSet;
+    table.reset(new PolicyGenerator::RegretMatchingTable<>(
+        numSequences, numActionsAtEachInfoSet, numSequencesBeforeEachInfoSet,
+        placement));
+    firstInfoSets = Numa::partitionInfoSets(numSequencesBeforeEachInfoSet,
+                                            numSequences, Numa::numNodes());
+  }
+};
+
+/**
+ * Threads pinned to the first numNodesUsed nodes update every action of
+ * information sets scattered over the table. Node n's threads take the
+ * partitions of nodes n, n + numNodesUsed, and so on, so only with every
+ * node in use are all of a PARTITIONED table's updates local.
+ */
+static Bench::Operation pinnedUpdates(Numa::Placement placement,
+                                      size_t numNodesUsed) {
+  auto synthetic = std::make_shared<SyntheticTable>(placement);
+  const size_t numThreadsPerNode =
+      std::max<size_t>(1, Numa::cpusByNode()[0].size());
+  return [synthetic, numNodesUsed, numThreadsPerNode]() {
+    const size_t numThreads = numNodesUsed * numThreadsPerNode;
+    Numa::runPinned(numThreadsPerNode, [&](size_t node, size_t thread) {
+      if (node >= numNodesUsed) {
+        return;
+      }
+      const auto& firstInfoSets = synthetic->firstInfoSets;
+      std::vector<std::pair<size_t, size_t>> ranges;
+      size_t numOwned = 0;
+      for (size_t part = node; part + 1 < firstInfoSets.size();
+           part += numNodesUsed) {
+        ranges.emplace_back(firstInfoSets[part], firstInfoSets[part + 1]);
+        numOwned += firstInfoSets[part + 1] - firstInfoSets[part];
+      }
+      if (numOwned == 0) {
+        return;
+      }
+      auto* table = synthetic->table.get();
+      // A large odd stride visits owned information sets out of order, so
+      // each update misses the cache.
+      size_t k = (node * numThreadsPerNode + thread) * 2654435761u % numOwned;
+      for (size_t u = 0; u < numUpdates / numThreads; ++u) {
+        k = (k + 2654435761u) % numOwned;
+        size_t offset = k;
+        size_t r = 0;
+        while (offset >= ranges[r].second - ranges[r].first) {
+          offset -= ranges[r].second - ranges[r].first;
+          ++r;
+        }
+        const size_t I = ranges[r].first + offset;
+        for (size_t a = 0; a < numActionsPerInfoSet; ++a) {
+          table->update({I, a}, 1.0);
+        }
+      }
+    });
+  };
+}
+
+static std::vector<size_t> numNodesUsed() {
+  std::vector<size_t> sizes;
+  for (size_t n = 1; n <= Numa::numNodes(); ++n) {
+    sizes.push_back(n);
+  }
+  return sizes;
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  // Sizes are the number of nodes with threads at work. Each op makes the
+  // same number of updates, so ideal scaling halves ns/op as nodes double.
+  suite->add("Numa::runPinned/updates/default", numNodesUsed(),
+             [](size_t n) {
+    return pinnedUpdates(Numa::Placement::DEFAULT, n);
+  });
+  suite->add("Numa::runPinned/updates/interleaved", numNodesUsed(),
+             [](size_t n) {
+    return pinnedUpdates(Numa::Placement::INTERLEAVED, n);
+  });
+  suite->add("Numa::runPinned/updates/partitioned", numNodesUsed(),
+             [](size_t n) {
+    return pinnedUpdates(Numa::Placement::PARTITIONED, n);
+  });
+}
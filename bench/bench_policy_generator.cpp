@@ -0,0 +1,93 @@
+#include <memory>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/policy_generator.hpp>
+
+using namespace TreeAndHistoryTraversal;
+using namespace PolicyGenerator;
+
+/**
+ * Owns the sequence layout that a table only points to.
+ */
+struct Layout {
+  Layout(size_t numInfoSets, size_t numActions)
+      : numActionsAtEachInfoSet(numInfoSets, numActions),
+        numSequencesBeforeEachInfoSet(numInfoSets) {
+    for (size_t I = 0; I < numInfoSets; ++I) {
+      numSequencesBeforeEachInfoSet[I] = I * numActions;
+    }
+  }
+  size_t numSequences() const {
+    return numActionsAtEachInfoSet.size() * numActionsAtEachInfoSet[0];
+  }
+
+  std::vector<size_t> numActionsAtEachInfoSet;
+  std::vector<size_t> numSequencesBeforeEachInfoSet;
+};
+
+static const size_t NUM_INFO_SETS = 256;
+static const std::vector<size_t> NUM_ACTIONS{2, 16, 128, 1024};
+
+template <typename Table>
+static std::shared_ptr<Table> seededTable(const Layout& layout) {
+  std::shared_ptr<Table> table(new Table(layout.numSequences(),
+                                         layout.numActionsAtEachInfoSet,
+                                         layout.numSequencesBeforeEachInfoSet));
+  for (size_t I = 0; I < NUM_INFO_SETS; ++I) {
+    for (size_t a = 0; a < layout.numActionsAtEachInfoSet[I]; ++a) {
+      table->update(std::make_pair(I, a), (a % 3) - 1.0);
+    }
+  }
+  return table;
+}
+
+template <typename Numeric>
+static void registerTableBenchmarks(Bench::Suite* suite,
+                                    const std::string& suffix) {
+  // Size is the number of actions at each information set
+  suite->add("RegretMatchingTable::policy/" + suffix, NUM_ACTIONS,
+             [](size_t numActions) {
+               std::shared_ptr<Layout> layout(
+                   new Layout(NUM_INFO_SETS, numActions));
+               auto table = seededTable<RegretMatchingTable<Numeric>>(*layout);
+               std::shared_ptr<size_t> I(new size_t(0));
+               return [layout, table, I]() {
+                 Bench::doNotOptimize(table->policy(*I));
+                 *I = (*I + 1) % NUM_INFO_SETS;
+               };
+             });
+  suite->add("RegretMatchingTable::update/" + suffix, NUM_ACTIONS,
+             [](size_t numActions) {
+               std::shared_ptr<Layout> layout(
+                   new Layout(NUM_INFO_SETS, numActions));
+               auto table = seededTable<RegretMatchingTable<Numeric>>(*layout);
+               std::shared_ptr<size_t> sequence(new size_t(0));
+               return [layout, table, sequence, numActions]() {
+                 table->update(std::make_pair(*sequence / numActions,
+                                              *sequence % numActions),
+                               0.5);
+                 *sequence = (*sequence + 1) % layout->numSequences();
+               };
+             });
+  suite->add("PerturbedPolicyRegretMatchingTable::policy/" + suffix,
+             NUM_ACTIONS, [](size_t numActions) {
+               std::shared_ptr<Layout> layout(
+                   new Layout(NUM_INFO_SETS, numActions));
+               std::shared_ptr<PerturbedPolicyRegretMatchingTable<Numeric>>
+                   table(new PerturbedPolicyRegretMatchingTable<Numeric>(
+                       layout->numSequences(), layout->numActionsAtEachInfoSet,
+                       layout->numSequencesBeforeEachInfoSet, 0.1));
+               std::shared_ptr<size_t> I(new size_t(0));
+               return [layout, table, I]() {
+                 Bench::doNotOptimize(table->policy(*I));
+                 *I = (*I + 1) % NUM_INFO_SETS;
+               };
+             });
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  registerTableBenchmarks<double>(suite, "double");
+  registerTableBenchmarks<float>(suite, "float");
+}
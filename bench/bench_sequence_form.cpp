@@ -0,0 +1,131 @@
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/game_history.hpp>
+#include <lib/info_set_index.hpp>
+#include <lib/matrix_game.hpp>
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+
+using namespace TreeAndHistoryTraversal;
+using namespace SequenceForm;
+
+static const std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
+
+static std::shared_ptr<CompiledGame> matchingPennies() {
+  MatrixGame::MatrixGameHistory root(utilsForPlayer1);
+  return std::make_shared<CompiledGame>(compile(&root));
+}
+
+template <typename RootHistory>
+static std::shared_ptr<CompiledGame> compiled() {
+  RootHistory root;
+  return std::make_shared<CompiledGame>(compile(&root));
+}
+
+/**
+ * Times op and reports cfr's memory after it has run.
+ */
+static Bench::MeasuredOperation withMemoryOf(std::shared_ptr<Cfr<>> cfr,
+                                             Bench::Operation op) {
+  return {op, [cfr]() { return cfr->memoryUsage(); }};
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  // Each iteration updates both players, so compare against two of the
+  // matrix game's alternating iterations.
+  suite->addWithMemory("SequenceForm::Cfr::doIteration/matching_pennies",
+                       {2}, [](size_t) {
+    auto game = matchingPennies();
+    auto cfr = Bench::newCfr<Cfr>(*game);
+    return withMemoryOf(cfr, [game, cfr]() { cfr->doIteration(); });
+  });
+  suite->add("SequenceForm::compile/matching_pennies", {2}, [](size_t) {
+    return []() {
+      MatrixGame::MatrixGameHistory root(utilsForPlayer1);
+      Bench::doNotOptimize(compile(&root).numNodes());
+    };
+  });
+  suite->add("SequenceForm::CompiledGame::load/matching_pennies", {2},
+             [](size_t) {
+    std::ostringstream image;
+    matchingPennies()->save(image);
+    auto bytes = std::make_shared<std::string>(image.str());
+    return [bytes]() {
+      std::istringstream in(*bytes);
+      Bench::doNotOptimize(CompiledGame::load(in).numNodes());
+    };
+  });
+  suite->addWithMemory("SequenceForm::Cfr::doIteration/kuhn", {58},
+                       [](size_t) {
+    auto game = compiled<Poker::KuhnPokerHistory>();
+    auto cfr = Bench::newCfr<Cfr>(*game);
+    return withMemoryOf(cfr, [game, cfr]() { cfr->doIteration(); });
+  });
+  suite->addWithMemory("SequenceForm::Cfr::doIteration/leduc", {9457},
+                       [](size_t) {
+    auto game = compiled<Poker::LeducHoldemHistory>();
+    auto cfr = Bench::newCfr<Cfr>(*game);
+    return withMemoryOf(cfr, [game, cfr]() { cfr->doIteration(); });
+  });
+  // Sizes are depth limits; the first round ends within six edges.
+  suite->addWithMemory("SequenceForm::Cfr::doIteration/leduc_depth_limited",
+                       {4, 6}, [](size_t maxDepth) {
+    auto game = compiled<Poker::LeducHoldemHistory>();
+    auto uniform = Bench::newCfr<Cfr>(*game);
+    auto estimator = std::make_shared<DepthLimit::TableEstimator<
+        std::vector<double>>>(nodeValues(*game, uniform->strategyProfile()));
+    auto cfr = Bench::newCfr<Cfr>(*game, DepthLimit::Limits(maxDepth),
+                                  estimator.get());
+    return withMemoryOf(cfr,
+                        [game, estimator, cfr]() { cfr->doIteration(); });
+  });
+  suite->add("SequenceForm::BestResponse::averageExploitability/leduc",
+             {9457}, [](size_t) {
+    auto game = compiled<Poker::LeducHoldemHistory>();
+    auto cfr = Bench::newCfr<Cfr>(*game);
+    cfr->doIterations(10);
+    auto profile = std::make_shared<std::vector<std::vector<double>>>(
+        cfr->strategyProfile());
+    return [game, profile]() {
+      Bench::doNotOptimize(
+          BestResponse<>(*game, *profile).averageExploitability());
+    };
+  });
+  // Sized by samples per player. Needs no compiled game, only a policy.
+  suite->add("Game::SampledBestResponse::averageExploitability/leduc",
+             {64, 1024}, [](size_t numSamples) {
+    auto game = compiled<Poker::LeducHoldemHistory>();
+    auto cfr = Bench::newCfr<Cfr>(*game);
+    cfr->doIterations(10);
+    const auto profile = cfr->strategyProfile();
+    const auto indices = std::make_shared<
+        std::vector<InfoSetIndex::PerfectHashIndex>>(
+        InfoSetIndex::indexInfoSets(*game));
+    const Game::Policy policy = [game, profile, indices](
+        size_t player, const std::string& name) {
+      const auto I = (*indices)[player][name];
+      const auto* sigma_I =
+          &profile[player][game->numSequencesBeforeEachInfoSet[player][I]];
+      return std::vector<double>(
+          sigma_I, sigma_I + game->numActionsAtEachInfoSet[player][I]);
+    };
+    auto br = std::make_shared<
+        Game::SampledBestResponse<Poker::LeducHoldemHistory>>(
+        Poker::LeducHoldemHistory(), policy,
+        Game::SamplingOptions(numSamples));
+    return [br]() {
+      Bench::doNotOptimize(br->averageExploitability().value);
+    };
+  });
+  suite->add("SequenceForm::compile/kuhn", {58}, [](size_t) {
+    return []() {
+      Poker::KuhnPokerHistory root;
+      Bench::doNotOptimize(compile(&root).numNodes());
+    };
+  });
+}
@@ -0,0 +1,52 @@
+#include <memory>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+#include <lib/serving.hpp>
+
+using namespace TreeAndHistoryTraversal;
+
+static std::shared_ptr<SequenceForm::Cfr<>> solvedLeduc(
+    std::shared_ptr<SequenceForm::CompiledGame>* game) {
+  Poker::LeducHoldemHistory root;
+  *game = std::make_shared<SequenceForm::CompiledGame>(
+      SequenceForm::compile(&root));
+  auto cfr = Bench::newCfr<SequenceForm::Cfr>(**game);
+  cfr->doIterations(10);
+  return cfr;
+}
+
+static Bench::Setup lookups(Serving::Quantization quantization) {
+  return [quantization](size_t) {
+    std::shared_ptr<SequenceForm::CompiledGame> game;
+    auto cfr = solvedLeduc(&game);
+    auto table =
+        std::make_shared<Serving::PolicyTable>(cfr->servingTable(quantization));
+    auto I = std::make_shared<size_t>(0);
+    return [game, cfr, table, I]() {
+      *I = (*I + 1) % table->numInfoSets(0);
+      Bench::doNotOptimize(table->policy(0, *I).sample(0.5));
+    };
+  };
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  // Sizes are bytes per probability; compare against strategyProfile().
+  suite->add("Serving::PolicyTable::policy/leduc", {4},
+             lookups(Serving::Quantization::FLOAT32));
+  suite->add("Serving::PolicyTable::policy/leduc_uint16", {2},
+             lookups(Serving::Quantization::UINT16));
+  suite->add("Serving::PolicyTable::policy/leduc_uint8", {1},
+             lookups(Serving::Quantization::UINT8));
+  suite->add("SequenceForm::Cfr::strategyProfile/leduc", {8}, [](size_t) {
+    std::shared_ptr<SequenceForm::CompiledGame> game;
+    auto cfr = solvedLeduc(&game);
+    return [game, cfr]() {
+      Bench::doNotOptimize(cfr->strategyProfile()[0][0]);
+    };
+  });
+}
@@ -0,0 +1,43 @@
+#include <memory>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/tree_node.hpp>
+
+using namespace TreeAndHistoryTraversal;
+using namespace TreeNode;
+
+static TreeNode<double>* completeTree(
+    size_t branchingFactor,
+    size_t depth,
+    const std::function<double(double&&)>& combiner) {
+  if (depth == 0) {
+    return new StoredTerminalNode<double>(1.0);
+  }
+  auto node = new StoredInteriorNode<double>(combiner);
+  for (size_t i = 0; i < branchingFactor; ++i) {
+    node->addChild(completeTree(branchingFactor, depth - 1, combiner));
+  }
+  return node;
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  for (const size_t branchingFactor : {2, 8}) {
+    // Size is the depth of the tree
+    const std::vector<size_t> depths =
+        (branchingFactor == 2) ? std::vector<size_t>{4, 10, 16}
+                               : std::vector<size_t>{2, 4, 6};
+    suite->add("StoredInteriorNode::value/branching=" +
+                   std::to_string(branchingFactor),
+               depths, [branchingFactor](size_t depth) {
+                 std::shared_ptr<double> sum(new double(0.0));
+                 std::shared_ptr<TreeNode<double>> root(completeTree(
+                     branchingFactor, depth,
+                     [sum](double&& childValue) {
+                       return *sum += childValue;
+                     }));
+                 return [root]() { Bench::doNotOptimize(root->value()); };
+               });
+  }
+}
@@ -0,0 +1,42 @@
+#include <memory>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/vector_form.hpp>
+
+using namespace TreeAndHistoryTraversal;
+using namespace VectorForm;
+
+template <typename RootHistory>
+static std::shared_ptr<PublicTree> compiled() {
+  RootHistory root;
+  return std::make_shared<PublicTree>(compile(&root));
+}
+
+/**
+ * Times op and reports cfr's memory after it has run.
+ */
+static Bench::MeasuredOperation withMemoryOf(std::shared_ptr<Cfr<>> cfr,
+                                             Bench::Operation op) {
+  return {op, [cfr]() { return cfr->memoryUsage(); }};
+}
+
+void registerBenchmarks(Bench::Suite* suite) {
+  // Sizes are public tree nodes; compare against SequenceForm's iterations
+  // on the full game trees.
+  suite->addWithMemory("VectorForm::Cfr::doIteration/kuhn", {9},
+                       [](size_t) {
+    auto tree = compiled<Poker::KuhnPokerPublicHistory>();
+    auto cfr = Bench::newCfr<Cfr>(*tree);
+    return withMemoryOf(cfr, [tree, cfr]() { cfr->doIteration(); });
+  });
+  suite->addWithMemory("VectorForm::Cfr::doIteration/leduc", {240},
+                       [](size_t) {
+    auto tree = compiled<Poker::LeducHoldemPublicHistory>();
+    auto cfr = Bench::newCfr<Cfr>(*tree);
+    return withMemoryOf(cfr, [tree, cfr]() { cfr->doIteration(); });
+  });
+}
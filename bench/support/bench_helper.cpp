@@ -0,0 +1,307 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <bench_helper.hpp>
+
+#include <lib/profiling.hpp>
+
+static std::atomic<size_t> allocationCount(0);
+
+void* operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace TreeAndHistoryTraversal {
+namespace Bench {
+
+size_t numAllocations() {
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+std::vector<Result> Suite::run(double minSeconds,
+                               const std::string& filter) const {
+  std::vector<Result> results;
+  Profiling::Profiler profiler;
+  if (!profiler.hasHardwareCounters()) {
+    fprintf(stderr, "Hardware counters unavailable; timing only\n");
+  }
+  for (const auto& c : cases_) {
+    if (c.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    for (const auto size : c.sizes) {
+      const auto measured = c.setup(size);
+      const auto& op = measured.operation;
+      op();  // Warm up caches and any lazily allocated state
+
+      size_t iterations = 1;
+      double seconds = 0.0;
+      size_t allocations = 0;
+      Profiling::Sample sample;
+      while (true) {
+        const auto allocationsBefore = numAllocations();
+        profiler.start();
+        for (size_t i = 0; i < iterations; ++i) {
+          op();
+        }
+        sample = profiler.stop();
+        seconds = sample.seconds;
+        allocations = numAllocations() - allocationsBefore;
+        if (seconds >= minSeconds) {
+          break;
+        }
+        iterations *= (seconds > 0.0 && seconds * 10 < minSeconds) ? 10 : 2;
+      }
+
+      Result r;
+      r.name = c.name;
+      r.size = size;
+      r.iterations = iterations;
+      r.nsPerOp = seconds * 1e9 / iterations;
+      r.opsPerSec = iterations / seconds;
+      r.allocsPerOp = static_cast<double>(allocations) / iterations;
+      r.hasHardwareCounters = sample.hasHardwareCounters;
+      r.cyclesPerOp = static_cast<double>(sample.cycles) / iterations;
+      r.instructionsPerOp =
+          static_cast<double>(sample.instructions) / iterations;
+      r.cacheMissesPerOp = static_cast<double>(sample.cacheMisses) / iterations;
+      r.branchMissesPerOp =
+          static_cast<double>(sample.branchMisses) / iterations;
+      r.hasMemoryUsage = static_cast<bool>(measured.memoryUsage);
+      r.liveBytes = 0;
+      r.peakBytes = 0;
+      if (r.hasMemoryUsage) {
+        const auto usage = measured.memoryUsage();
+        r.liveBytes = usage.liveBytes;
+        r.peakBytes = usage.peakBytes;
+      }
+      results.push_back(r);
+      fprintf(stderr,
+              "%-52s %8zu %14.1lf ns/op %14.0lf ops/s %8.2lf allocs/op\n",
+              r.name.c_str(), r.size, r.nsPerOp, r.opsPerSec, r.allocsPerOp);
+      if (r.hasHardwareCounters) {
+        fprintf(stderr,
+                "%-52s %8s %14.0lf cycles %8.2lf IPC %10.2lf cache-misses "
+                "%10.2lf branch-misses\n",
+                "", "", r.cyclesPerOp, r.instructionsPerOp / r.cyclesPerOp,
+                r.cacheMissesPerOp, r.branchMissesPerOp);
+      }
+      if (r.hasMemoryUsage) {
+        fprintf(stderr, "%-52s %8s %14zu live bytes %14zu peak bytes\n", "",
+                "", r.liveBytes, r.peakBytes);
+      }
+    }
+  }
+  return results;
+}
+
+std::string toJson(const std::vector<Result>& results) {
+  // One benchmark per line keeps the files diffable and easy to parse.
+  std::ostringstream json;
+  json << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    char line[512];
+    snprintf(line, sizeof(line),
+             "    {\"name\": \"%s\", \"size\": %zu, \"iterations\": %zu, "
+             "\"ns_per_op\": %.3lf, \"ops_per_sec\": %.3lf, "
+             "\"allocs_per_op\": %.3lf",
+             r.name.c_str(), r.size, r.iterations, r.nsPerOp, r.opsPerSec,
+             r.allocsPerOp);
+    json << line;
+    if (r.hasHardwareCounters) {
+      snprintf(line, sizeof(line),
+               ", \"cycles_per_op\": %.3lf, \"instructions_per_op\": %.3lf, "
+               "\"cache_misses_per_op\": %.3lf, "
+               "\"branch_misses_per_op\": %.3lf",
+               r.cyclesPerOp, r.instructionsPerOp, r.cacheMissesPerOp,
+               r.branchMissesPerOp);
+      json << line;
+    }
+    if (r.hasMemoryUsage) {
+      snprintf(line, sizeof(line), ", \"live_bytes\": %zu, \"peak_bytes\": %zu",
+               r.liveBytes, r.peakBytes);
+      json << line;
+    }
+    json << "}" << ((i + 1 < results.size()) ? "," : "") << "\n";
+  }
+  json << "  ]\n}\n";
+  return json.str();
+}
+
+static bool fieldAfter(const std::string& line,
+                       const std::string& key,
+                       std::string* value) {
+  const auto keyStart = line.find("\"" + key + "\": ");
+  if (keyStart == std::string::npos) {
+    return false;
+  }
+  auto valueStart = keyStart + key.size() + 4;
+  if (line[valueStart] == '"') {
+    ++valueStart;
+    *value = line.substr(valueStart, line.find('"', valueStart) - valueStart);
+  } else {
+    *value = line.substr(valueStart,
+                         line.find_first_of(",}", valueStart) - valueStart);
+  }
+  return true;
+}
+
+std::vector<Result> fromJson(const std::string& json) {
+  std::vector<Result> results;
+  std::istringstream lines(json);
+  std::string line;
+  while (std::getline(lines, line)) {
+    Result r = Result();
+    std::string size, iterations, nsPerOp, opsPerSec, allocsPerOp;
+    if (fieldAfter(line, "name", &r.name) && fieldAfter(line, "size", &size) &&
+        fieldAfter(line, "iterations", &iterations) &&
+        fieldAfter(line, "ns_per_op", &nsPerOp) &&
+        fieldAfter(line, "ops_per_sec", &opsPerSec) &&
+        fieldAfter(line, "allocs_per_op", &allocsPerOp)) {
+      r.size = std::stoul(size);
+      r.iterations = std::stoul(iterations);
+      r.nsPerOp = std::stod(nsPerOp);
+      r.opsPerSec = std::stod(opsPerSec);
+      r.allocsPerOp = std::stod(allocsPerOp);
+      std::string count;
+      if (fieldAfter(line, "cycles_per_op", &count)) {
+        r.hasHardwareCounters = true;
+        r.cyclesPerOp = std::stod(count);
+      }
+      if (fieldAfter(line, "instructions_per_op", &count)) {
+        r.instructionsPerOp = std::stod(count);
+      }
+      if (fieldAfter(line, "cache_misses_per_op", &count)) {
+        r.cacheMissesPerOp = std::stod(count);
+      }
+      if (fieldAfter(line, "branch_misses_per_op", &count)) {
+        r.branchMissesPerOp = std::stod(count);
+      }
+      if (fieldAfter(line, "live_bytes", &count)) {
+        r.hasMemoryUsage = true;
+        r.liveBytes = std::stoul(count);
+      }
+      if (fieldAfter(line, "peak_bytes", &count)) {
+        r.peakBytes = std::stoul(count);
+      }
+      results.push_back(r);
+    }
+  }
+  return results;
+}
+
+size_t compare(const std::vector<Result>& results,
+               const std::vector<Result>& baseline,
+               double maxRegression) {
+  size_t numRegressions = 0;
+  for (const auto& r : results) {
+    for (const auto& b : baseline) {
+      if (b.name != r.name || b.size != r.size) {
+        continue;
+      }
+      const double change = r.nsPerOp / b.nsPerOp - 1.0;
+      const bool regressed = change > maxRegression;
+      numRegressions += regressed;
+      fprintf(stderr, "%-52s %8zu %14.1lf -> %14.1lf ns/op %+8.1lf%%%s\n",
+              r.name.c_str(), r.size, b.nsPerOp, r.nsPerOp, change * 100,
+              regressed ? "  REGRESSION" : "");
+      if (r.hasHardwareCounters && b.hasHardwareCounters) {
+        // Tells regressions in memory behaviour apart from extra work.
+        fprintf(stderr,
+                "%-52s %8s %+13.1lf%% cycles %+9.1lf%% instructions "
+                "%+9.1lf%% cache-misses\n",
+                "", "", (r.cyclesPerOp / b.cyclesPerOp - 1.0) * 100,
+                (r.instructionsPerOp / b.instructionsPerOp - 1.0) * 100,
+                (r.cacheMissesPerOp / b.cacheMissesPerOp - 1.0) * 100);
+      }
+    }
+  }
+  return numRegressions;
+}
+}
+}
+
+static std::string readFile(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "Unable to read \"%s\"\n", path.c_str());
+    exit(EXIT_FAILURE);
+  }
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+int main(int argc, char** argv) {
+  using namespace TreeAndHistoryTraversal::Bench;
+
+  std::string jsonPath = "";
+  std::string baselinePath = "";
+  std::string filter = "";
+  double minSeconds = 0.2;
+  double maxRegression = 0.1;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (i + 1 >= argc) {
+      fprintf(stderr, "Missing value for \"%s\"\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+    if (arg == "--json") {
+      jsonPath = argv[++i];
+    } else if (arg == "--baseline") {
+      baselinePath = argv[++i];
+    } else if (arg == "--filter") {
+      filter = argv[++i];
+    } else if (arg == "--min-time") {
+      minSeconds = std::stod(argv[++i]);
+    } else if (arg == "--max-regression") {
+      maxRegression = std::stod(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--json PATH] [--baseline PATH] [--filter NAME] "
+              "[--min-time SECONDS] [--max-regression FRACTION]\n",
+              argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  Suite suite;
+  registerBenchmarks(&suite);
+  const auto results = suite.run(minSeconds, filter);
+
+  const auto json = toJson(results);
+  if (jsonPath.empty()) {
+    printf("%s", json.c_str());
+  } else {
+    std::ofstream(jsonPath) << json;
+  }
+
+  if (!baselinePath.empty()) {
+    const auto numRegressions =
+        compare(results, fromJson(readFile(baselinePath)), maxRegression);
+    if (numRegressions > 0) {
+      fprintf(stderr, "%zu benchmark(s) regressed by more than %.1lf%%\n",
+              numRegressions, maxRegression * 100);
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
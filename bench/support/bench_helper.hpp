@@ -0,0 +1,153 @@
+#ifndef __BENCH_HELPER__
+#define __BENCH_HELPER__
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <lib/memory_accounting.hpp>
+#include <lib/policy_generator.hpp>
+
+namespace TreeAndHistoryTraversal {
+namespace Bench {
+
+/**
+ * Times repeated calls to the operation returned by a benchmark's setup
+ * function. Setup runs once per size and is not timed.
+ */
+typedef std::function<void()> Operation;
+typedef std::function<Operation(size_t size)> Setup;
+
+/**
+ * An operation with a report of the memory held by the state that it works
+ * on, such as a solver's tables, read once timing is done.
+ */
+struct MeasuredOperation {
+  Operation operation;
+  std::function<MemoryAccounting::Usage()> memoryUsage;
+};
+typedef std::function<MeasuredOperation(size_t size)> MeasuredSetup;
+
+struct Result {
+  std::string name;
+  size_t size;
+  size_t iterations;
+  double nsPerOp;
+  double opsPerSec;
+  double allocsPerOp;
+  // Zero unless hardware counters could be opened; see profiling.hpp.
+  bool hasHardwareCounters;
+  double cyclesPerOp;
+  double instructionsPerOp;
+  double cacheMissesPerOp;
+  double branchMissesPerOp;
+  // Zero unless the case reports memory usage
+  bool hasMemoryUsage;
+  size_t liveBytes;
+  size_t peakBytes;
+};
+
+class Suite {
+ public:
+  Suite() {}
+
+  void add(const std::string& name,
+           const std::vector<size_t>& sizes,
+           Setup setup) {
+    addWithMemory(name, sizes, [setup](size_t size) {
+      return MeasuredOperation{setup(size), nullptr};
+    });
+  }
+  void addWithMemory(const std::string& name,
+                     const std::vector<size_t>& sizes,
+                     MeasuredSetup setup) {
+    cases_.push_back({name, sizes, setup});
+  }
+
+  /**
+   * Runs every case whose name contains filter, repeating each operation
+   * until at least minSeconds have elapsed.
+   */
+  std::vector<Result> run(double minSeconds, const std::string& filter) const;
+
+ private:
+  struct Case {
+    std::string name;
+    std::vector<size_t> sizes;
+    MeasuredSetup setup;
+  };
+  std::vector<Case> cases_;
+};
+
+/**
+ * Keeps the compiler from discarding a result that is otherwise unused.
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Heap allocations made by this process so far.
+ */
+size_t numAllocations();
+
+/**
+ * One regret matching table per player, laid out by game's information
+ * sets. game may be a SequenceForm::CompiledGame or a VectorForm::PublicTree.
+ */
+template <typename Numeric, typename Game>
+std::vector<PolicyGenerator::PolicyGenerator<size_t,
+                                             std::pair<size_t, size_t>,
+                                             Numeric>*>
+newRegretTables(const Game& game) {
+  std::vector<PolicyGenerator::PolicyGenerator<
+      size_t, std::pair<size_t, size_t>, Numeric>*>
+      profile;
+  for (size_t player = 0; player < game.numActionsAtEachInfoSet.size();
+       ++player) {
+    profile.push_back(new PolicyGenerator::RegretMatchingTable<Numeric>(
+        game.numSequences(player), game.numActionsAtEachInfoSet[player],
+        game.numSequencesBeforeEachInfoSet[player]));
+  }
+  return profile;
+}
+
+/**
+ * A Solver, such as SequenceForm::Cfr or VectorForm::Cfr, with fresh regret
+ * and average strategy tables, shared so that operations can capture it.
+ * args follow the tables in Solver's constructor.
+ */
+template <template <typename> class Solver,
+          typename Numeric = double,
+          typename Game,
+          typename... Args>
+std::shared_ptr<Solver<Numeric>> newCfr(const Game& game, Args&&... args) {
+  return std::make_shared<Solver<Numeric>>(
+      game, newRegretTables<Numeric>(game), newRegretTables<Numeric>(game),
+      std::forward<Args>(args)...);
+}
+
+std::string toJson(const std::vector<Result>& results);
+std::vector<Result> fromJson(const std::string& json);
+
+/**
+ * Prints each result next to its baseline and returns the number of results
+ * that are slower than their baseline by more than maxRegression, a
+ * fraction of the baseline time.
+ */
+size_t compare(const std::vector<Result>& results,
+               const std::vector<Result>& baseline,
+               double maxRegression);
+}
+}
+
+/**
+ * Defined by each benchmark file.
+ */
+void registerBenchmarks(TreeAndHistoryTraversal::Bench::Suite* suite);
+
+#endif
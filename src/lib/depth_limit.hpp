@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Bounds on how far a traversal expands, and the estimators that stand in
+ * for the subtrees it leaves unexpanded.
+ */
+namespace DepthLimit {
+/**
+ * A non-terminal node becomes a leaf when it is maxDepth edges below the
+ * root, or when maxNodes nodes have already been visited in the same pass.
+ * Nodes are visited in preorder, so a node budget expands the leftmost
+ * subtrees first.
+ */
+struct Limits {
+  size_t maxDepth;
+  size_t maxNodes;
+
+  Limits(size_t maxDepth = SIZE_MAX, size_t maxNodes = SIZE_MAX)
+      : maxDepth(maxDepth), maxNodes(maxNodes) {}
+
+  bool isUnlimited() const {
+    return maxDepth == SIZE_MAX && maxNodes == SIZE_MAX;
+  }
+  bool reached(size_t depth, size_t numNodesVisited) const {
+    return depth >= maxDepth || numNodesVisited >= maxNodes;
+  }
+};
+
+/**
+ * One player's part of a Value: an entry of a vector of values by player,
+ * or the whole of a scalar value.
+ */
+template <typename Value>
+struct PlayerValue {
+  typedef Value type;
+  static const type& of(const Value& value, size_t) { return value; }
+};
+template <typename Numeric>
+struct PlayerValue<std::vector<Numeric>> {
+  typedef Numeric type;
+  static const type& of(const std::vector<Numeric>& values, size_t player) {
+    return values[player];
+  }
+};
+
+/**
+ * Values a node in place of the subtree below it. Estimators are only
+ * read, so one may be shared by any number of traversals.
+ */
+template <typename Node, typename Value>
+class LeafEstimator {
+ protected:
+  LeafEstimator() {}
+
+ public:
+  virtual ~LeafEstimator() {}
+  virtual Value estimate(const Node& node) const = 0;
+  /**
+   * player's part of estimate(node). Estimators that can read it without
+   * building the whole Value should override this, since traversals call
+   * it once per leaf.
+   */
+  virtual typename PlayerValue<Value>::type estimate(const Node& node,
+                                                     size_t player) const {
+    return PlayerValue<Value>::of(estimate(node), player);
+  }
+};
+
+/**
+ * A heuristic given as a function.
+ */
+template <typename Node, typename Value>
+class FunctionEstimator : public LeafEstimator<Node, Value> {
+ public:
+  FunctionEstimator(std::function<Value(const Node& node)> estimateFn)
+      : LeafEstimator<Node, Value>(), estimateFn_(estimateFn) {}
+  virtual ~FunctionEstimator() {}
+
+  using LeafEstimator<Node, Value>::estimate;
+  virtual Value estimate(const Node& node) const override {
+    return estimateFn_(node);
+  }
+
+ protected:
+  std::function<Value(const Node& node)> estimateFn_;
+};
+
+/**
+ * Cached values for nodes numbered from zero, such as those computed from
+ * an earlier solution.
+ */
+template <typename Value>
+class TableEstimator : public LeafEstimator<size_t, Value> {
+ public:
+  TableEstimator(std::vector<Value>&& valuesByNode)
+      : LeafEstimator<size_t, Value>(), table_(std::move(valuesByNode)) {}
+  virtual ~TableEstimator() {}
+
+  virtual Value estimate(const size_t& node) const override {
+    return table_[node];
+  }
+  virtual typename PlayerValue<Value>::type estimate(
+      const size_t& node,
+      size_t player) const override {
+    return PlayerValue<Value>::of(table_[node], player);
+  }
+
+ protected:
+  std::vector<Value> table_;
+};
+}
+}
@@ -0,0 +1,505 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace TreeAndHistoryTraversal {
+namespace Game {
+/**
+ * The actor at histories where chance, rather than a player, chooses the
+ * next symbol.
+ */
+enum : size_t { CHANCE = SIZE_MAX - 1 };
+
+template <typename HistoryType>
+class GameHistory : public HistoryType {
+ protected:
+  template <typename... SuperclassArgs>
+  GameHistory(SuperclassArgs&&... args)
+      : HistoryType(std::forward<SuperclassArgs>(args)...) {}
+
+ public:
+  virtual ~GameHistory() {}
+
+  /**
+   * A player index, or CHANCE.
+   */
+  virtual size_t actor() const = 0;
+  virtual size_t numPlayers() const { return 2; }
+  /**
+   * At chance histories, the probability of the legalSuffixIndex'th legal
+   * suffix. Uniform unless overridden.
+   */
+  virtual double chanceProbability(size_t) const {
+    return 1.0 / this->numSuccessors();
+  }
+  /**
+   * At chance histories, pushes the outcome found by inverting the
+   * cumulative distribution at uniformDraw, in [0, 1), calls doFn with its
+   * legal suffix index and probability, then pops it. Returns what doFn
+   * returned.
+   */
+  bool sampleSuccessor(
+      double uniformDraw,
+      std::function<bool(size_t legalSuffixIndex, double probability)> doFn) {
+    typedef decltype(this->last()) Symbol;
+
+    const auto numOutcomes = this->numSuccessors();
+    // The last outcome absorbs any rounding in the cumulative sum.
+    size_t outcome = numOutcomes - 1;
+    double cumulativeProb = 0.0;
+    for (size_t a = 0; a + 1 < numOutcomes; ++a) {
+      cumulativeProb += chanceProbability(a);
+      if (uniformDraw < cumulativeProb) {
+        outcome = a;
+        break;
+      }
+    }
+    const double prob = chanceProbability(outcome);
+    bool shouldBreak = false;
+    this->eachLegalSuffix(
+        [&](Symbol&& suffix, size_t, size_t legalSuffixIndex) {
+          if (legalSuffixIndex != outcome) {
+            return false;
+          }
+          this->push(std::move(suffix));
+          shouldBreak = doFn(outcome, prob);
+          this->pop();
+          return true;
+        });
+    return shouldBreak;
+  }
+  /**
+   * Names the actor's information set. Histories that the actor cannot
+   * tell apart must return the same name, and others must not.
+   */
+  virtual std::string informationSet() const = 0;
+  /**
+   * The given player's payoff. Only defined at terminal histories.
+   */
+  virtual double utility(size_t player) const = 0;
+};
+
+/**
+ * The public part of a two-player game in which chance deals each player a
+ * private state before play and every later event is public. Pushing
+ * symbols only ever advances the public history, so one traversal covers
+ * every deal at once, carrying a vector over private states wherever a
+ * GameHistory traversal would branch on chance.
+ */
+template <typename HistoryType>
+class PublicGameHistory : public HistoryType {
+ protected:
+  template <typename... SuperclassArgs>
+  PublicGameHistory(SuperclassArgs&&... args)
+      : HistoryType(std::forward<SuperclassArgs>(args)...) {}
+
+ public:
+  virtual ~PublicGameHistory() {}
+
+  /**
+   * A player index, or CHANCE for public chance events.
+   */
+  virtual size_t actor() const = 0;
+  virtual size_t numPrivateStates(size_t player) const = 0;
+  /**
+   * Names the actor's information set when it holds privateState.
+   */
+  virtual std::string informationSet(size_t privateState) const = 0;
+  /**
+   * The probability that chance deals these private states and makes every
+   * public chance choice in this history. Public chance histories therefore
+   * need no probabilities of their own.
+   */
+  virtual double chanceProbability(size_t privateState0,
+                                   size_t privateState1) const = 0;
+  /**
+   * The given player's payoff when the players hold these private states.
+   * Only defined at terminal histories.
+   */
+  virtual double utility(size_t player,
+                         size_t privateState0,
+                         size_t privateState1) const = 0;
+};
+
+/**
+ * The actor's probability of each legal action at an information set.
+ */
+typedef std::function<std::vector<double>(size_t player,
+                                          const std::string& informationSet)>
+    Policy;
+
+namespace Detail {
+template <typename HistoryType>
+void addExpectedUtilities(PublicGameHistory<HistoryType>* history,
+                          const Policy& policy,
+                          std::vector<std::vector<double>>* reachProbs,
+                          std::vector<double>* values) {
+  auto& reach = *reachProbs;
+  if (!history->hasSuccessors()) {
+    for (size_t s0 = 0; s0 < reach[0].size(); ++s0) {
+      for (size_t s1 = 0; s1 < reach[1].size(); ++s1) {
+        const double prob =
+            reach[0][s0] * reach[1][s1] * history->chanceProbability(s0, s1);
+        if (prob > 0) {
+          for (size_t player = 0; player < 2; ++player) {
+            (*values)[player] += prob * history->utility(player, s0, s1);
+          }
+        }
+      }
+    }
+    return;
+  }
+  const auto actor = history->actor();
+  if (actor == CHANCE) {
+    history->eachSuccessor([&](size_t, size_t) {
+      addExpectedUtilities(history, policy, reachProbs, values);
+      return false;
+    });
+    return;
+  }
+  const auto actorReach = reach[actor];
+  std::vector<std::vector<double>> sigma(actorReach.size());
+  for (size_t s = 0; s < actorReach.size(); ++s) {
+    sigma[s] = policy(actor, history->informationSet(s));
+  }
+  history->eachSuccessor([&](size_t, size_t a) {
+    for (size_t s = 0; s < actorReach.size(); ++s) {
+      reach[actor][s] = actorReach[s] * sigma[s][a];
+    }
+    addExpectedUtilities(history, policy, reachProbs, values);
+    return false;
+  });
+  reach[actor] = actorReach;
+}
+}
+
+/**
+ * Each player's expected utility under policy, from one traversal of the
+ * public tree.
+ */
+template <typename HistoryType>
+std::vector<double> expectedUtilities(PublicGameHistory<HistoryType>* root,
+                                      const Policy& policy) {
+  std::vector<std::vector<double>> reachProbs{
+      std::vector<double>(root->numPrivateStates(0), 1.0),
+      std::vector<double>(root->numPrivateStates(1), 1.0)};
+  std::vector<double> values(2, 0.0);
+  Detail::addExpectedUtilities(root, policy, &reachProbs, &values);
+  return values;
+}
+
+/**
+ * A point estimate with a symmetric confidence interval.
+ */
+template <typename Numeric = Utils::Numeric>
+struct Estimate {
+  Numeric value;
+  Numeric standardError;
+  Numeric lower;
+  Numeric upper;
+  size_t numSamples;
+};
+
+struct SamplingOptions {
+  // Sampled plays per player
+  size_t numSamples;
+  size_t numThreads;
+  // Draws are a function of (seed, sample, depth) alone, so estimates are
+  // reproducible regardless of numThreads
+  uint64_t seed;
+  // Half-width of the confidence interval in standard errors
+  double numStandardErrors;
+
+  SamplingOptions(size_t numSamples = 1000,
+                  size_t numThreads = 1,
+                  uint64_t seed = 0,
+                  double numStandardErrors = 1.96)
+      : numSamples(numSamples),
+        numThreads(numThreads),
+        seed(seed),
+        numStandardErrors(numStandardErrors) {}
+};
+
+/**
+ * Estimates best response values from sampled plays instead of traversing
+ * every history, so that games too large for an exact best response can
+ * still be checked.
+ *
+ * Each sample walks one history from the root, drawing chance outcomes and
+ * the other players' actions from policy. Even samples choose the
+ * responder's action at each of its information sets, deepest first, so
+ * that every choice is made knowing the choices below it: a sample draws
+ * the responder's earlier actions uniformly, weighting by the inverse of
+ * their probability, and tries every action at the information set being
+ * decided against the same draws. Odd samples evaluate the chosen
+ * strategy. Keeping the two halves apart makes the value estimate unbiased
+ * for the chosen strategy, so it can only underestimate the true best
+ * response value, and only by the chance that sampling chose wrongly.
+ *
+ * Information sets are ranked by the number of responder choices before
+ * them, which perfect recall makes the same for all of their histories.
+ * Each rank takes one pass over the even samples.
+ */
+template <typename HistoryType, typename Numeric = Utils::Numeric>
+class SampledBestResponse {
+ public:
+  typedef std::unordered_map<std::string, size_t> Choices;
+
+  // Action values are summed within blocks of this many samples, then
+  // across blocks in order, so that choices do not depend on numThreads
+  static const size_t BLOCK_SIZE = 256;
+
+  SampledBestResponse(const HistoryType& root,
+                      const Policy& policy,
+                      const SamplingOptions& options = SamplingOptions())
+      : root_(root.clone()), policy_(policy), options_(options) {
+    assert(options_.numSamples >= 2);
+    assert(options_.numThreads >= 1);
+  }
+  virtual ~SampledBestResponse() {}
+
+  virtual std::vector<Estimate<Numeric>> valueProfile() const {
+    std::vector<Estimate<Numeric>> estimates;
+    for (size_t i = 0; i < root_->numPlayers(); ++i) {
+      estimates.push_back(evaluate(i, bestResponse(i)));
+    }
+    return estimates;
+  }
+
+  virtual Estimate<Numeric> averageExploitability() const {
+    const auto values = valueProfile();
+    Estimate<Numeric> e;
+    e.value = 0.0;
+    double variance = 0.0;
+    e.numSamples = 0;
+    for (const auto& v : values) {
+      e.value += v.value / values.size();
+      variance += v.standardError * v.standardError;
+      e.numSamples += v.numSamples;
+    }
+    e.standardError = std::sqrt(variance) / values.size();
+    e.lower = e.value - options_.numStandardErrors * e.standardError;
+    e.upper = e.value + options_.numStandardErrors * e.standardError;
+    return e;
+  }
+
+  /**
+   * The responder's action, by legal successor index, at each of its
+   * information sets that the even samples reached. Others take their
+   * first action.
+   */
+  virtual Choices bestResponse(size_t responder) const {
+    Choices choices;
+    Pass pass{responder, NO_RANK, false, &choices};
+    size_t numRanks = 0;
+    for (const auto& blockResult : eachSelectionBlock(pass)) {
+      numRanks = std::max(numRanks, blockResult.numRanks);
+    }
+    for (size_t rank = numRanks; rank-- > 0;) {
+      pass.rank = rank;
+      std::unordered_map<std::string, std::vector<Numeric>> totals;
+      for (const auto& blockResult : eachSelectionBlock(pass)) {
+        for (const auto& entry : blockResult.actionTotals) {
+          auto& total = totals[entry.first];
+          total.resize(entry.second.size(), 0.0);
+          Utils::axpy(Numeric(1.0), entry.second.data(), total.size(),
+                      total.data());
+        }
+      }
+      for (const auto& entry : totals) {
+        choices[entry.first] =
+            Utils::argmax(entry.second.data(), entry.second.size());
+      }
+    }
+    return choices;
+  }
+
+ protected:
+  static const size_t NO_RANK = SIZE_MAX;
+
+  /**
+   * Responder information sets of the given rank record the sampled value
+   * of each action; those of lower rank draw an action uniformly and those
+   * of higher rank follow choices. Evaluation follows choices everywhere.
+   */
+  struct Pass {
+    size_t responder;
+    size_t rank;
+    bool isEvaluating;
+    const Choices* choices;
+  };
+  struct BlockResult {
+    std::unordered_map<std::string, std::vector<Numeric>> actionTotals;
+    size_t numRanks = 0;
+    std::vector<Numeric> values;
+  };
+
+  size_t numBlocks() const {
+    return (options_.numSamples + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  }
+
+  /**
+   * Runs doFn on every block of samples, spread across threads, each with
+   * its own copy of the root.
+   */
+  std::vector<BlockResult> eachBlock(
+      std::function<void(HistoryType* h, size_t sample, BlockResult* result)>
+          doFn,
+      size_t firstSample) const {
+    std::vector<BlockResult> results(numBlocks());
+    const auto numThreads = std::min(options_.numThreads, results.size());
+    const auto run = [&](size_t thread) {
+      std::unique_ptr<HistoryType> h(root_->clone());
+      for (size_t b = thread; b < results.size(); b += numThreads) {
+        const auto end = std::min(options_.numSamples, (b + 1) * BLOCK_SIZE);
+        for (size_t sample = b * BLOCK_SIZE + firstSample; sample < end;
+             sample += 2) {
+          doFn(h.get(), sample, &results[b]);
+        }
+      }
+    };
+    std::vector<std::thread> others;
+    for (size_t thread = 1; thread < numThreads; ++thread) {
+      others.emplace_back(run, thread);
+    }
+    run(0);
+    for (auto& other : others) {
+      other.join();
+    }
+    return results;
+  }
+  std::vector<BlockResult> eachSelectionBlock(const Pass& pass) const {
+    return eachBlock(
+        [this, &pass](HistoryType* h, size_t sample, BlockResult* result) {
+          sampledUtility(h, pass, sample, 0, 0, 1.0, result);
+        },
+        0);
+  }
+
+  Estimate<Numeric> evaluate(size_t responder, const Choices& choices) const {
+    const Pass pass{responder, NO_RANK, true, &choices};
+    double total = 0.0;
+    double totalSquares = 0.0;
+    size_t n = 0;
+    for (const auto& blockResult : eachBlock(
+             [this, &pass](HistoryType* h, size_t sample,
+                           BlockResult* result) {
+               result->values.push_back(
+                   sampledUtility(h, pass, sample, 0, 0, 1.0, result));
+             },
+             1)) {
+      for (const auto v : blockResult.values) {
+        total += v;
+        totalSquares += v * v;
+        ++n;
+      }
+    }
+    const double mean = total / n;
+    const double variance =
+        n > 1 ? std::max(0.0, (totalSquares - n * mean * mean) / (n - 1))
+              : 0.0;
+
+    Estimate<Numeric> e;
+    e.value = mean;
+    e.standardError = std::sqrt(variance / n);
+    e.lower = e.value - options_.numStandardErrors * e.standardError;
+    e.upper = e.value + options_.numStandardErrors * e.standardError;
+    e.numSamples = options_.numSamples;
+    return e;
+  }
+
+  /**
+   * The responder's utility for one sampled play. Draws at the same depth
+   * of the same sample agree whatever the responder does. Only meaningful
+   * below the information sets that try every action. weight is the
+   * inverse probability of the responder's drawn actions so far.
+   */
+  Numeric sampledUtility(HistoryType* h,
+                         const Pass& pass,
+                         size_t sample,
+                         size_t depth,
+                         size_t rank,
+                         double weight,
+                         BlockResult* result) const {
+    if (!h->hasSuccessors()) {
+      return h->utility(pass.responder);
+    }
+    const auto actor = h->actor();
+    const double uniform = Utils::randomUniform(options_.seed, sample, depth);
+    Numeric u = 0.0;
+    if (actor == CHANCE) {
+      h->sampleSuccessor(uniform, [&](size_t, double) {
+        u = sampledUtility(h, pass, sample, depth + 1, rank, weight, result);
+        return false;
+      });
+      return u;
+    }
+
+    size_t chosen = 0;
+    if (actor != pass.responder) {
+      chosen = sampleAction(policy_(actor, h->informationSet()), uniform);
+    } else {
+      result->numRanks = std::max(result->numRanks, rank + 1);
+      const auto I = h->informationSet();
+      const auto numActions = h->numSuccessors();
+      if (pass.isEvaluating || rank > pass.rank) {
+        const auto found = pass.choices->find(I);
+        chosen = found == pass.choices->end() ? 0 : found->second;
+      } else if (rank < pass.rank) {
+        chosen = std::min(numActions - 1,
+                          static_cast<size_t>(uniform * numActions));
+        weight *= numActions;
+      } else {
+        auto& actionTotals = result->actionTotals[I];
+        actionTotals.resize(numActions, 0.0);
+        h->eachSuccessor([&](size_t, size_t legalSuccessorIndex) {
+          actionTotals[legalSuccessorIndex] +=
+              weight * sampledUtility(h, pass, sample, depth + 1, rank + 1,
+                                      weight, result);
+          return false;
+        });
+        return 0.0;
+      }
+      ++rank;
+    }
+    h->eachSuccessor([&](size_t, size_t legalSuccessorIndex) {
+      if (legalSuccessorIndex != chosen) {
+        return false;
+      }
+      u = sampledUtility(h, pass, sample, depth + 1, rank, weight, result);
+      return true;
+    });
+    return u;
+  }
+
+  static size_t sampleAction(const std::vector<double>& sigma_I,
+                             double uniform) {
+    double cumulative = 0.0;
+    for (size_t a = 0; a + 1 < sigma_I.size(); ++a) {
+      cumulative += sigma_I[a];
+      if (uniform < cumulative) {
+        return a;
+      }
+    }
+    return sigma_I.size() - 1;
+  }
+
+ protected:
+  std::unique_ptr<HistoryType> root_;
+  const Policy policy_;
+  const SamplingOptions options_;
+};
+}
+}
@@ -1,15 +1,63 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <exception>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
 #include <cpp_utilities/src/lib/memory.h>
 
+#include "instrumentation.hpp"
+#include "memory_accounting.hpp"
+
 namespace TreeAndHistoryTraversal {
 namespace History {
 
+/**
+ * The suffix index of every legal suffix, in legal suffix order, gathered
+ * in one call into a fixed array. Loops over it need no callbacks, so
+ * callers can gather children first and run their per-action arithmetic
+ * as one tight loop.
+ */
+class LegalSuffixes {
+ public:
+  enum : size_t { CAPACITY = 64 };
+
+  LegalSuffixes() : size_(0) {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  /**
+   * The suffix index of the legalSuffixIndex'th legal suffix.
+   */
+  size_t operator[](size_t legalSuffixIndex) const {
+    assert(legalSuffixIndex < size_);
+    return suffixIndices_[legalSuffixIndex];
+  }
+  const uint32_t* begin() const { return suffixIndices_; }
+  const uint32_t* end() const { return suffixIndices_ + size_; }
+
+  void push_back(size_t suffixIndex) {
+    if (size_ == CAPACITY || suffixIndex > UINT32_MAX) {
+      throw std::runtime_error("More than " + std::to_string(CAPACITY) +
+                               " legal suffixes, or a suffix index past "
+                               "32 bits");
+    }
+    suffixIndices_[size_++] = static_cast<uint32_t>(suffixIndex);
+  }
+
+ protected:
+  size_t size_;
+  uint32_t suffixIndices_[CAPACITY];
+};
+
 template <typename Symbol>
 class ActionSet {
  protected:
@@ -50,6 +98,33 @@ class ActionSet {
     });
     return n;
   }
+  /**
+   * Pull-based enumeration of the legal suffixes, counted as a successor
+   * enumeration. Throws if there are more than LegalSuffixes::CAPACITY.
+   */
+  virtual LegalSuffixes legalSuffixes() const {
+    Instrumentation::countSuccessorEnumeration();
+    LegalSuffixes legal;
+    eachLegalSuffix([&legal](Symbol&&, size_t suffixIndex, size_t) {
+      legal.push_back(suffixIndex);
+      return false;
+    });
+    return legal;
+  }
+  /**
+   * The suffix that eachSuffix gives at suffixIndex.
+   */
+  virtual Symbol suffix(size_t suffixIndex) const {
+    Symbol found;
+    eachSuffix([&found, suffixIndex](Symbol&& candidate, size_t i) {
+      if (i != suffixIndex) {
+        return false;
+      }
+      found = std::move(candidate);
+      return true;
+    });
+    return found;
+  }
 };
 
 /**
@@ -68,6 +143,30 @@ class History : public ActionSet<Symbol> {
   virtual void push(Symbol suffix) = 0;
   virtual void pop() = 0;
   virtual Symbol last() const = 0;
+  virtual MemoryAccounting::Usage memoryUsage() const {
+    return MemoryAccounting::Usage(sizeof(*this));
+  }
+  /**
+   * A history at the same place in the tree that is pushed and popped
+   * independently of this one, so that another thread can traverse the
+   * subtree below it. Histories that cannot be copied throw.
+   */
+  virtual History<Symbol>* clone() const {
+    throw std::runtime_error("This history cannot be cloned");
+  }
+  /**
+   * Pushes the suffix at suffixIndex, which must be legal, as those from
+   * legalSuffixes() are, without checking it. For example,
+   *
+   *   for (const auto suffixIndex : h->legalSuffixes()) {
+   *     h->pushSuffix(suffixIndex);
+   *     ...
+   *     h->pop();
+   *   }
+   */
+  virtual void pushSuffix(size_t suffixIndex) {
+    pushLegalSuffix(this->suffix(suffixIndex), suffixIndex);
+  }
 
   /**
    * Breaks when true is returned from the closure and returns true itself
@@ -75,29 +174,191 @@ class History : public ActionSet<Symbol> {
    */
   bool eachSuccessor(std::function<bool(size_t successorIndex,
                                         size_t legalSuffixIndex)> doFn) {
+    Instrumentation::countSuccessorEnumeration();
     return this->eachLegalSuffix([&doFn, this](
         Symbol&& suffix, size_t suffixIndex, size_t legalSuffixIndex) {
-      push(std::move(suffix));
+      pushLegalSuffix(std::move(suffix), suffixIndex);
       const bool shouldBreak = doFn(suffixIndex, legalSuffixIndex);
       pop();
       return shouldBreak;
     });
   }
+
+ protected:
+  /**
+   * Pushes the suffix that eachSuffix gave at suffixIndex, which is already
+   * known to be legal, so histories may skip the checks that push makes.
+   */
+  virtual void pushLegalSuffix(Symbol&& suffix, size_t suffixIndex) {
+    (void)suffixIndex;
+    push(std::move(suffix));
+  }
+};
+
+/**
+ * A sequence of strings from a fixed alphabet, stored as indices into it.
+ * Copies share one buffer until either pushes, and pops never copy, so a
+ * copy costs a reference count increment and a push after it copies at
+ * most the indices themselves.
+ *
+ * Copying marks both the copy and the original as sharing, and a sharing
+ * sequence moves to a buffer of its own before it next pushes, so no
+ * buffer is ever written while another sequence can read it. Copies may
+ * therefore be pushed and popped on different threads. As with any
+ * container, a sequence must not be copied or read while it is being
+ * pushed or popped.
+ */
+class StringSequence {
+ public:
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef std::string value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const std::string* pointer;
+    typedef const std::string& reference;
+
+    const_iterator(const StringSequence* sequence, size_t i)
+        : sequence_(sequence), i_(i) {}
+
+    reference operator*() const { return (*sequence_)[i_]; }
+    pointer operator->() const { return &(*sequence_)[i_]; }
+    const_iterator& operator++() {
+      ++i_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator before = *this;
+      ++i_;
+      return before;
+    }
+    bool operator==(const const_iterator& other) const {
+      return i_ == other.i_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return i_ != other.i_;
+    }
+
+   protected:
+    const StringSequence* sequence_;
+    size_t i_;
+  };
+
+  StringSequence(std::shared_ptr<const std::vector<std::string>> alphabet)
+      : alphabet_(alphabet),
+        indices_(std::make_shared<std::vector<uint16_t>>()),
+        size_(0),
+        ownsIndices_(true) {
+    if (alphabet_->size() > UINT16_MAX + size_t(1)) {
+      throw std::invalid_argument("StringSequence alphabets are limited to " +
+                                  std::to_string(UINT16_MAX + 1) +
+                                  " strings");
+    }
+  }
+  StringSequence(const StringSequence& other)
+      : alphabet_(other.alphabet_),
+        indices_(other.indices_),
+        size_(other.size_),
+        ownsIndices_(false) {
+    other.ownsIndices_.store(false, std::memory_order_relaxed);
+  }
+  StringSequence& operator=(const StringSequence& other) {
+    if (this != &other) {
+      other.ownsIndices_.store(false, std::memory_order_relaxed);
+      alphabet_ = other.alphabet_;
+      indices_ = other.indices_;
+      size_ = other.size_;
+      ownsIndices_.store(false, std::memory_order_relaxed);
+    }
+    return *this;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const std::string& operator[](size_t i) const {
+    assert(i < size_);
+    return (*alphabet_)[(*indices_)[i]];
+  }
+  const std::string& back() const { return (*this)[size_ - 1]; }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+  const std::vector<std::string>& alphabet() const { return *alphabet_; }
+
+  /**
+   * The index of symbol in the alphabet, or SIZE_MAX if it is not there.
+   */
+  size_t find(const std::string& symbol) const {
+    const auto& alphabet = *alphabet_;
+    for (size_t i = 0; i < alphabet.size(); ++i) {
+      // Symbols are short, so most are ruled out without a comparison call.
+      if (alphabet[i].size() == symbol.size() &&
+          (symbol.empty() || alphabet[i][0] == symbol[0]) &&
+          alphabet[i] == symbol) {
+        return i;
+      }
+    }
+    return SIZE_MAX;
+  }
+
+  void push_back(size_t symbolIndex) {
+    assert(symbolIndex < alphabet_->size());
+    if (!ownsIndices_.load(std::memory_order_relaxed)) {
+      auto own = std::make_shared<std::vector<uint16_t>>();
+      own->reserve(std::max(indices_->capacity(), size_ + 1));
+      own->assign(indices_->begin(), indices_->begin() + size_);
+      indices_ = own;
+      ownsIndices_.store(true, std::memory_order_relaxed);
+    }
+    // Indices past size_ are left by pops and are no longer shared.
+    if (size_ < indices_->size()) {
+      (*indices_)[size_] = static_cast<uint16_t>(symbolIndex);
+    } else {
+      indices_->push_back(static_cast<uint16_t>(symbolIndex));
+    }
+    ++size_;
+  }
+  void pop_back() {
+    assert(size_ > 0);
+    --size_;
+  }
+
+  /**
+   * The alphabet and the index buffer are counted in full even while
+   * copies share them.
+   */
+  MemoryAccounting::Usage memoryUsage() const {
+    return MemoryAccounting::ofStrings(*alphabet_) +
+           MemoryAccounting::ofContainer(*indices_) +
+           MemoryAccounting::Usage(0, 2);
+  }
+
+ protected:
+  std::shared_ptr<const std::vector<std::string>> alphabet_;
+  std::shared_ptr<std::vector<uint16_t>> indices_;
+  // Of indices_, which may hold more, left by pops or for the copies
+  // sharing it
+  size_t size_;
+  // Whether indices_ has never been given to another sequence. Cleared by
+  // copying rather than read from the reference count, whose loads do not
+  // order this thread's writes after other threads' reads.
+  mutable std::atomic<bool> ownsIndices_;
 };
 
 class StringHistory : public History<std::string> {
  protected:
   StringHistory(std::vector<std::string>&& allLegalStrings)
-      : state_(), allLegalStrings_(allLegalStrings) {}
+      : state_(std::make_shared<const std::vector<std::string>>(
+            std::move(allLegalStrings))) {}
 
  public:
   virtual ~StringHistory() {}
 
   virtual bool eachSuffix(std::function<bool(std::string&& suffix,
                                              size_t suffixIndex)> doFn) const {
-    for (size_t candidateIndex = 0; candidateIndex < allLegalStrings_.size();
+    const auto& allLegalStrings = state_.alphabet();
+    for (size_t candidateIndex = 0; candidateIndex < allLegalStrings.size();
          ++candidateIndex) {
-      const auto& candidate = allLegalStrings_[candidateIndex];
+      const auto& candidate = allLegalStrings[candidateIndex];
       if (!suffixIsLegal(candidate)) {
         continue;
       }
@@ -109,17 +370,44 @@ class StringHistory : public History<std::string> {
     return false;
   }
   virtual void push(std::string suffix) {
-    if (!suffixIsLegal(suffix)) {
+    const size_t symbolIndex = state_.find(suffix);
+    if (symbolIndex == SIZE_MAX || !suffixIsLegal(suffix)) {
       throw std::runtime_error("Illegal StringHistory suffix, \"" + suffix +
                                "\", for prefix, \"" + toString() + "\"");
     }
-    state_.emplace_back(suffix);
+    state_.push_back(symbolIndex);
+  }
+  virtual void pushSuffix(size_t suffixIndex) override {
+    assert(suffixIsLegal(state_.alphabet()[suffixIndex]));
+    state_.push_back(suffixIndex);
   }
   virtual void pop() { state_.pop_back(); }
   virtual std::string last() const { return isEmpty() ? "" : state_.back(); }
+  virtual LegalSuffixes legalSuffixes() const override {
+    Instrumentation::countSuccessorEnumeration();
+    LegalSuffixes legal;
+    const auto& allLegalStrings = state_.alphabet();
+    for (size_t i = 0; i < allLegalStrings.size(); ++i) {
+      if (suffixIsLegal(allLegalStrings[i])) {
+        legal.push_back(i);
+      }
+    }
+    return legal;
+  }
+  virtual std::string suffix(size_t suffixIndex) const override {
+    return state_.alphabet()[suffixIndex];
+  }
+  /**
+   * The state buffer keeps its capacity through pops, so this is also the
+   * peak for the deepest history reached so far. Clones share the alphabet
+   * and, until they push, the state buffer, so their sums overcount.
+   */
+  virtual MemoryAccounting::Usage memoryUsage() const override {
+    return MemoryAccounting::Usage(sizeof(*this)) + state_.memoryUsage();
+  }
   virtual bool isEmpty() const { return state_.empty(); }
   virtual bool hasSuccessors() const {
-    for (const auto& s : allLegalStrings_) {
+    for (const auto& s : state_.alphabet()) {
       if (suffixIsLegal(s)) {
         return true;
       }
@@ -139,8 +427,15 @@ class StringHistory : public History<std::string> {
   }
 
  protected:
-  std::vector<std::string> state_;
-  std::vector<std::string> allLegalStrings_;
+  virtual void pushLegalSuffix(std::string&& suffix,
+                               size_t suffixIndex) override {
+    assert(state_.alphabet()[suffixIndex] == suffix);
+    (void)suffix;
+    state_.push_back(suffixIndex);
+  }
+
+ protected:
+  StringSequence state_;
 };
 }
 }
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cassert>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "history.hpp"
+#include "instrumentation.hpp"
+
+namespace TreeAndHistoryTraversal {
+/**
+ * History trees with structurally identical subtrees merged into one shared
+ * node, so that evaluators visit each distinct subtree once per pass.
+ */
+namespace HistoryDag {
+/**
+ * Two subtrees share a node when they have the same terminal value, or the
+ * same suffixes leading to the same shared children. Nodes are numbered so
+ * that every node's children precede it, which makes the root the last.
+ */
+template <typename Symbol, typename Value>
+struct Dag {
+  // By node, plus one past the last: where its children start in children,
+  // in legal suffix order. Terminals have none.
+  std::vector<size_t> childrenBegin;
+  std::vector<size_t> children;
+  // Parallel to children: the suffix that leads to each child
+  std::vector<Symbol> suffixes;
+  // By node: each terminal's value, or Value() at interior nodes
+  std::vector<Value> terminalValues;
+  // The number of nodes in the tree that the DAG stands for
+  size_t numTreeNodes = 0;
+  size_t numTreeEdges = 0;
+
+  size_t numNodes() const { return terminalValues.size(); }
+  size_t root() const { return numNodes() - 1; }
+  size_t numChildren(size_t node) const {
+    return childrenBegin[node + 1] - childrenBegin[node];
+  }
+  bool isTerminal(size_t node) const { return numChildren(node) == 0; }
+  size_t child(size_t node, size_t legalSuffixIndex) const {
+    return children[childrenBegin[node] + legalSuffixIndex];
+  }
+  const Symbol& suffix(size_t node, size_t legalSuffixIndex) const {
+    return suffixes[childrenBegin[node] + legalSuffixIndex];
+  }
+
+  /**
+   * Tree nodes per DAG node. The DAG's arrays and an evaluation pass both
+   * shrink by about this factor relative to the tree.
+   */
+  double compressionRatio() const {
+    return numNodes() == 0 ? 1.0
+                           : static_cast<double>(numTreeNodes) / numNodes();
+  }
+
+  std::string report() const {
+    char line[160];
+    snprintf(line, sizeof(line),
+             "%zu tree nodes and %zu edges in %zu DAG nodes and %zu edges "
+             "(%.2fx)",
+             numTreeNodes, numTreeEdges, numNodes(), children.size(),
+             compressionRatio());
+    return line;
+  }
+
+  /**
+   * Evaluates every distinct subtree once, children first, and returns the
+   * root's value. interiorFn receives an interior node and the values of
+   * its children in legal suffix order.
+   */
+  Value evaluate(std::function<Value(
+                     size_t node, const std::vector<Value>& childValues)>
+                     interiorFn) const {
+    std::vector<Value> values(numNodes());
+    std::vector<Value> childValues;
+    for (size_t node = 0; node < numNodes(); ++node) {
+      const bool terminal = isTerminal(node);
+      Instrumentation::countNodeVisit(terminal);
+      if (terminal) {
+        values[node] = terminalValues[node];
+        continue;
+      }
+      childValues.clear();
+      for (size_t c = childrenBegin[node]; c < childrenBegin[node + 1]; ++c) {
+        childValues.push_back(values[children[c]]);
+      }
+      values[node] = interiorFn(node, childValues);
+    }
+    return values[root()];
+  }
+};
+
+namespace Detail {
+inline size_t combine(size_t seed, size_t h) {
+  return seed ^ (h + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+template <typename Symbol, typename Value>
+class Builder {
+ public:
+  typedef std::function<Value(History::History<Symbol>* history)> ValueFn;
+
+  Builder(History::History<Symbol>* root, ValueFn terminalValue)
+      : history_(root), terminalValue_(terminalValue) {
+    dag_.childrenBegin.push_back(0);
+    visit();
+  }
+
+  Dag<Symbol, Value>& dag() { return dag_; }
+
+ protected:
+  size_t visit() {
+    ++dag_.numTreeNodes;
+    if (!history_->hasSuccessors()) {
+      return intern(terminalValue_(history_), {});
+    }
+    std::vector<std::pair<Symbol, size_t>> edges;
+    history_->eachSuccessor([&](size_t, size_t) {
+      ++dag_.numTreeEdges;
+      const size_t child = visit();
+      edges.emplace_back(history_->last(), child);
+      return false;
+    });
+    return intern(Value(), edges);
+  }
+
+  /**
+   * Returns the existing node with this structure, or appends a new one.
+   */
+  size_t intern(Value&& value,
+                const std::vector<std::pair<Symbol, size_t>>& edges) {
+    size_t h = combine(std::hash<Value>()(value), edges.size());
+    for (const auto& edge : edges) {
+      h = combine(combine(h, std::hash<Symbol>()(edge.first)), edge.second);
+    }
+    const auto candidates = nodesByHash_.equal_range(h);
+    for (auto it = candidates.first; it != candidates.second; ++it) {
+      if (matches(it->second, value, edges)) {
+        return it->second;
+      }
+    }
+    const size_t node = dag_.numNodes();
+    for (const auto& edge : edges) {
+      dag_.suffixes.push_back(edge.first);
+      dag_.children.push_back(edge.second);
+    }
+    dag_.childrenBegin.push_back(dag_.children.size());
+    dag_.terminalValues.emplace_back(std::move(value));
+    nodesByHash_.emplace(h, node);
+    return node;
+  }
+
+  bool matches(size_t node,
+               const Value& value,
+               const std::vector<std::pair<Symbol, size_t>>& edges) const {
+    if (dag_.numChildren(node) != edges.size() ||
+        !(dag_.terminalValues[node] == value)) {
+      return false;
+    }
+    for (size_t a = 0; a < edges.size(); ++a) {
+      if (!(dag_.suffix(node, a) == edges[a].first) ||
+          dag_.child(node, a) != edges[a].second) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ protected:
+  History::History<Symbol>* history_;
+  ValueFn terminalValue_;
+  Dag<Symbol, Value> dag_;
+  std::unordered_multimap<size_t, size_t> nodesByHash_;
+};
+}
+
+/**
+ * Walks every history below root once, merging identical subtrees as it
+ * goes, so the DAG never holds more than its distinct nodes. terminalValue
+ * is called at each terminal history. Values and symbols must be hashable
+ * by std::hash and comparable with ==. The root is left as it was.
+ */
+template <typename Symbol, typename Value>
+Dag<Symbol, Value> build(
+    History::History<Symbol>* root,
+    typename Detail::Builder<Symbol, Value>::ValueFn terminalValue) {
+  return std::move(Detail::Builder<Symbol, Value>(root, terminalValue).dag());
+}
+}
+}
@@ -3,9 +3,11 @@
 #include <cassert>
 #include <exception>
 #include <functional>
+#include <stdexcept>
 
 #include <cpp_utilities/src/lib/memory.h>
 
+#include "depth_limit.hpp"
 #include "tree_node.hpp"
 #include "history.hpp"
 
@@ -14,17 +16,65 @@ namespace HistoryTreeNode {
 template <typename Value, typename Symbol>
 class HistoryTreeNode : public TreeNode::TreeNode<Value> {
  public:
+  typedef DepthLimit::LeafEstimator<History::History<Symbol>, Value>
+      Estimator;
+
   HistoryTreeNode(History::History<Symbol>*&& history)
-      : TreeNode::TreeNode<Value>::TreeNode(), history_(std::move(history)) {
+      : TreeNode::TreeNode<Value>::TreeNode(),
+        history_(std::move(history)),
+        estimator_(nullptr),
+        depth_(0),
+        numNodesVisited_(0) {
     assert(history_);
   }
 
   virtual ~HistoryTreeNode() { Utilities::Memory::deletePointer(history_); }
   virtual bool isTerminal() const { return !history_->hasSuccessors(); }
   virtual const History::History<Symbol>* history() const { return history_; };
+  virtual MemoryAccounting::Usage memoryUsage() const override {
+    return MemoryAccounting::Usage(sizeof(*this)) + history_->memoryUsage() +
+           MemoryAccounting::Usage(0, 1);
+  }
+
+  /**
+   * Once limits are reached, value() returns estimator's value for the
+   * current history instead of recursing below it. Each call to value()
+   * from outside a traversal starts a new node budget. estimator must
+   * outlive this node.
+   */
+  virtual void limitTraversals(const DepthLimit::Limits& limits,
+                               const Estimator* estimator) {
+    if (!limits.isUnlimited() && !estimator) {
+      throw std::invalid_argument("Limited traversals need an estimator");
+    }
+    limits_ = limits;
+    estimator_ = estimator;
+  }
+
+  virtual Value value() override {
+    if (depth_ == 0) {
+      numNodesVisited_ = 0;
+    }
+    if (estimator_ && limits_.reached(depth_, numNodesVisited_) &&
+        !isTerminal()) {
+      ++numNodesVisited_;
+      Instrumentation::countNodeVisit(true);
+      return estimator_->estimate(*history_);
+    }
+    ++numNodesVisited_;
+    ++depth_;
+    Value v = TreeNode::TreeNode<Value>::value();
+    --depth_;
+    return v;
+  }
 
  protected:
   History::History<Symbol>* history_;
+  DepthLimit::Limits limits_;
+  const Estimator* estimator_;
+  // Within the traversal in progress
+  size_t depth_;
+  size_t numNodesVisited_;
 };
 
 template <typename Symbol>
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memory_accounting.hpp"
+#include "sequence_form.hpp"
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Maps information set names, as GameHistory::informationSet gives them, to
+ * the dense rows that policy generator tables are indexed by.
+ */
+namespace InfoSetIndex {
+static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+namespace Detail {
+inline uint64_t mix(uint64_t h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+/**
+ * Eight bytes at a time, with the last word overlapping the one before it
+ * rather than a byte loop for the tail.
+ */
+inline uint64_t hash(const std::string& key) {
+  const char* p = key.data();
+  const size_t n = key.size();
+  uint64_t h = n * 0x9e3779b97f4a7c15ULL;
+  uint64_t word = 0;
+  if (n >= 8) {
+    for (size_t i = 0; i + 8 < n; i += 8) {
+      std::memcpy(&word, p + i, 8);
+      h = (h ^ word) * 0xff51afd7ed558ccdULL;
+      h ^= h >> 32;
+    }
+    std::memcpy(&word, p + n - 8, 8);
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      word |= static_cast<uint64_t>(static_cast<unsigned char>(p[i]))
+              << (8 * i);
+    }
+  }
+  return mix(h ^ word);
+}
+/**
+ * Maps a 32 bit hash onto [0, n) without a division.
+ */
+inline uint32_t reduce(uint32_t h, uint32_t n) {
+  return static_cast<uint32_t>((static_cast<uint64_t>(h) * n) >> 32);
+}
+}
+
+/**
+ * A minimal perfect hash over a fixed set of keys, built with hash and
+ * displace: keys fall into buckets of about KEYS_PER_BUCKET by one half of
+ * their hash, and each bucket, largest first, searches for a displacement
+ * that sends all of its keys to free slots. Row lookup then costs one pass
+ * over the key and two table reads, with no probing, key comparisons, or
+ * allocation.
+ *
+ * Keys are given in row order, so an index built from
+ * CompiledGame::infoSetNames[player] returns the compiled game's
+ * information set indices.
+ */
+class PerfectHashIndex {
+ public:
+  static const uint32_t KEYS_PER_BUCKET = 4;
+  // Builds fail rather than search forever
+  static const uint32_t MAX_DISPLACEMENT = 1u << 24;
+
+  explicit PerfectHashIndex(const std::vector<std::string>& keys)
+      : numBuckets_(std::max<uint32_t>(
+            1, (keys.size() + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET)),
+        numSlots_(keys.size()),
+        displacements_(numBuckets_, 0),
+        rows_(std::max<size_t>(1, keys.size()), 0),
+        keys_(keys) {
+    if (keys.size() > UINT32_MAX) {
+      throw std::runtime_error("Too many keys for a perfect hash index");
+    }
+    build();
+  }
+  PerfectHashIndex() : PerfectHashIndex(std::vector<std::string>()) {}
+
+  size_t size() const { return keys_.size(); }
+
+  /**
+   * The row of key, which must be one of the keys that the index was built
+   * from. Other keys land on an arbitrary row.
+   */
+  size_t operator[](const std::string& key) const {
+    return rows_[slot(Detail::hash(key))];
+  }
+  /**
+   * The row of key, or NOT_FOUND if the index was not built with it.
+   */
+  size_t find(const std::string& key) const {
+    const size_t row = (*this)[key];
+    return row < keys_.size() && keys_[row] == key ? row : NOT_FOUND;
+  }
+  const std::string& key(size_t row) const { return keys_[row]; }
+
+  MemoryAccounting::Usage memoryUsage() const {
+    return MemoryAccounting::Usage(sizeof(*this)) +
+           MemoryAccounting::ofContainer(displacements_) +
+           MemoryAccounting::ofContainer(rows_) +
+           MemoryAccounting::ofStrings(keys_);
+  }
+
+ protected:
+  uint32_t slot(uint64_t h) const {
+    const auto bucket = Detail::reduce(h >> 32, numBuckets_);
+    return displaced(h, displacements_[bucket]);
+  }
+  uint32_t displaced(uint64_t h, uint32_t displacement) const {
+    const uint64_t d = (h ^ displacement) * 0x9e3779b97f4a7c15ULL;
+    return Detail::reduce((d ^ (d >> 29)) >> 32, numSlots_);
+  }
+
+  void build() {
+    std::vector<uint64_t> hashes(keys_.size());
+    std::vector<std::vector<uint32_t>> buckets(numBuckets_);
+    for (uint32_t i = 0; i < keys_.size(); ++i) {
+      hashes[i] = Detail::hash(keys_[i]);
+      buckets[Detail::reduce(hashes[i] >> 32, numBuckets_)].push_back(i);
+    }
+    std::vector<uint32_t> order(numBuckets_);
+    for (uint32_t b = 0; b < numBuckets_; ++b) {
+      order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](uint32_t a, uint32_t b) {
+                       return buckets[a].size() > buckets[b].size();
+                     });
+
+    std::vector<bool> isTaken(numSlots_, false);
+    std::vector<uint32_t> slots;
+    for (const auto b : order) {
+      const auto& bucket = buckets[b];
+      if (bucket.empty()) {
+        break;
+      }
+      uint32_t displacement = 0;
+      while (!fits(bucket, hashes, displacement, isTaken, &slots)) {
+        if (++displacement == MAX_DISPLACEMENT) {
+          throw std::runtime_error(
+              "Unable to build a perfect hash index. Are the keys unique?");
+        }
+      }
+      displacements_[b] = displacement;
+      for (size_t j = 0; j < bucket.size(); ++j) {
+        isTaken[slots[j]] = true;
+        rows_[slots[j]] = bucket[j];
+      }
+    }
+  }
+  bool fits(const std::vector<uint32_t>& bucket,
+            const std::vector<uint64_t>& hashes,
+            uint32_t displacement,
+            const std::vector<bool>& isTaken,
+            std::vector<uint32_t>* slots) const {
+    slots->clear();
+    for (const auto i : bucket) {
+      const auto s = displaced(hashes[i], displacement);
+      if (isTaken[s] ||
+          std::find(slots->begin(), slots->end(), s) != slots->end()) {
+        return false;
+      }
+      slots->push_back(s);
+    }
+    return true;
+  }
+
+  const uint32_t numBuckets_;
+  const uint32_t numSlots_;
+  std::vector<uint32_t> displacements_;
+  // By slot
+  std::vector<uint32_t> rows_;
+  // By row
+  std::vector<std::string> keys_;
+};
+
+/**
+ * One index per player, giving the information set indices of game.
+ */
+inline std::vector<PerfectHashIndex> indexInfoSets(
+    const SequenceForm::CompiledGame& game) {
+  std::vector<PerfectHashIndex> indices;
+  for (size_t player = 0; player < game.numPlayers; ++player) {
+    indices.emplace_back(game.infoSetNames[player]);
+  }
+  return indices;
+}
+
+/**
+ * For games too large to enumerate up front: rows are handed out in the
+ * order that keys are first seen, by any number of threads at once. Keys
+ * are spread over shards by hash, each behind its own lock, so threads
+ * only contend when they look up keys in the same shard.
+ */
+class ShardedIndex {
+ public:
+  explicit ShardedIndex(size_t numShards = 64)
+      : numShards_(std::max<size_t>(1, numShards)),
+        shards_(new Shard[numShards_]),
+        nextRow_(0) {}
+
+  size_t size() const { return nextRow_.load(); }
+
+  /**
+   * The row of key, assigning the next free row if key is new.
+   */
+  size_t operator[](const std::string& key) {
+    auto& shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto found = shard.rows.find(key);
+    if (found != shard.rows.end()) {
+      return found->second;
+    }
+    const auto row = nextRow_++;
+    shard.rows.emplace(key, row);
+    return row;
+  }
+  /**
+   * The row of key, or NOT_FOUND if it has not been seen.
+   */
+  size_t find(const std::string& key) const {
+    auto& shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto found = shard.rows.find(key);
+    return found == shard.rows.end() ? NOT_FOUND : found->second;
+  }
+
+  /**
+   * A perfect hash index over the keys seen so far, with the same rows, for
+   * when discovery is done. Must not run alongside operator[].
+   */
+  PerfectHashIndex freeze() const {
+    std::vector<std::string> keys(size());
+    for (size_t s = 0; s < numShards_; ++s) {
+      for (const auto& entry : shards_[s].rows) {
+        keys[entry.second] = entry.first;
+      }
+    }
+    return PerfectHashIndex(keys);
+  }
+
+  MemoryAccounting::Usage memoryUsage() const {
+    MemoryAccounting::Usage usage(sizeof(*this) + numShards_ * sizeof(Shard),
+                                  1);
+    for (size_t s = 0; s < numShards_; ++s) {
+      std::lock_guard<std::mutex> lock(shards_[s].mutex);
+      const auto& rows = shards_[s].rows;
+      // One node per entry, plus the bucket array
+      usage += MemoryAccounting::Usage(
+          rows.size() * (sizeof(std::pair<const std::string, size_t>) +
+                         2 * sizeof(void*)) +
+              rows.bucket_count() * sizeof(void*),
+          rows.size() + (rows.bucket_count() > 0));
+    }
+    return usage;
+  }
+
+ protected:
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, size_t> rows;
+  };
+
+  Shard& shardOf(const std::string& key) const {
+    return shards_[Detail::hash(key) % numShards_];
+  }
+
+  const size_t numShards_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<size_t> nextRow_;
+};
+}
+}
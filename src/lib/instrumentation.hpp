@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+
+#ifdef TREE_AND_HISTORY_TRAVERSAL_INSTRUMENT
+#include <atomic>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Counts the work done by traversals and policy generators.
+ *
+ * Define TREE_AND_HISTORY_TRAVERSAL_INSTRUMENT to enable counting.
+ * Otherwise every hook is an empty inline function and snapshot() always
+ * returns zeros.
+ *
+ * Each thread increments its own counters, so counting takes no locks and
+ * shares no cache lines between threads. snapshot() merges the counters of
+ * every live thread with those of threads that have already exited.
+ */
+namespace Instrumentation {
+struct Counters {
+  size_t nodesVisited;
+  size_t terminalEvaluations;
+  size_t interiorEvaluations;
+  size_t maxDepth;
+  size_t policyCalls;
+  size_t updateCalls;
+  size_t successorEnumerations;
+
+  Counters()
+      : nodesVisited(0),
+        terminalEvaluations(0),
+        interiorEvaluations(0),
+        maxDepth(0),
+        policyCalls(0),
+        updateCalls(0),
+        successorEnumerations(0) {}
+
+  Counters& operator+=(const Counters& other) {
+    nodesVisited += other.nodesVisited;
+    terminalEvaluations += other.terminalEvaluations;
+    interiorEvaluations += other.interiorEvaluations;
+    maxDepth = maxDepth > other.maxDepth ? maxDepth : other.maxDepth;
+    policyCalls += other.policyCalls;
+    updateCalls += other.updateCalls;
+    successorEnumerations += other.successorEnumerations;
+    return *this;
+  }
+};
+
+#ifdef TREE_AND_HISTORY_TRAVERSAL_INSTRUMENT
+constexpr bool enabled = true;
+
+namespace Detail {
+/**
+ * One thread's counters. Only the owning thread writes them, so relaxed
+ * increments are enough; the atomics only make concurrent reads well
+ * defined.
+ */
+struct ThreadCounters {
+  std::atomic<size_t> nodesVisited;
+  std::atomic<size_t> terminalEvaluations;
+  std::atomic<size_t> interiorEvaluations;
+  std::atomic<size_t> maxDepth;
+  std::atomic<size_t> policyCalls;
+  std::atomic<size_t> updateCalls;
+  std::atomic<size_t> successorEnumerations;
+  size_t depth;
+
+  ThreadCounters() : depth(0) { reset(); }
+
+  void reset() {
+    nodesVisited.store(0, std::memory_order_relaxed);
+    terminalEvaluations.store(0, std::memory_order_relaxed);
+    interiorEvaluations.store(0, std::memory_order_relaxed);
+    maxDepth.store(0, std::memory_order_relaxed);
+    policyCalls.store(0, std::memory_order_relaxed);
+    updateCalls.store(0, std::memory_order_relaxed);
+    successorEnumerations.store(0, std::memory_order_relaxed);
+  }
+
+  Counters load() const {
+    Counters c;
+    c.nodesVisited = nodesVisited.load(std::memory_order_relaxed);
+    c.terminalEvaluations =
+        terminalEvaluations.load(std::memory_order_relaxed);
+    c.interiorEvaluations =
+        interiorEvaluations.load(std::memory_order_relaxed);
+    c.maxDepth = maxDepth.load(std::memory_order_relaxed);
+    c.policyCalls = policyCalls.load(std::memory_order_relaxed);
+    c.updateCalls = updateCalls.load(std::memory_order_relaxed);
+    c.successorEnumerations =
+        successorEnumerations.load(std::memory_order_relaxed);
+    return c;
+  }
+};
+
+inline void increment(std::atomic<size_t>& counter) {
+  counter.store(counter.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+}
+
+/**
+ * Every live thread's counters plus the totals of threads that have exited.
+ */
+class Registry {
+ public:
+  static Registry& instance() {
+    static Registry registry;
+    return registry;
+  }
+
+  void add(ThreadCounters* counters) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    live_.push_back(counters);
+  }
+
+  void retire(ThreadCounters* counters) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_ += counters->load();
+    for (size_t i = 0; i < live_.size(); ++i) {
+      if (live_[i] == counters) {
+        live_[i] = live_.back();
+        live_.pop_back();
+        break;
+      }
+    }
+  }
+
+  Counters snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Counters total = retired_;
+    for (const auto counters : live_) {
+      total += counters->load();
+    }
+    return total;
+  }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_ = Counters();
+    for (auto counters : live_) {
+      counters->reset();
+    }
+  }
+
+ private:
+  Registry() {}
+
+  std::mutex mutex_;
+  std::vector<ThreadCounters*> live_;
+  Counters retired_;
+};
+
+class RegisteredThreadCounters : public ThreadCounters {
+ public:
+  RegisteredThreadCounters() : ThreadCounters() {
+    Registry::instance().add(this);
+  }
+  ~RegisteredThreadCounters() { Registry::instance().retire(this); }
+};
+
+inline ThreadCounters& local() {
+  static thread_local RegisteredThreadCounters counters;
+  return counters;
+}
+}
+
+inline void countNodeVisit(bool isTerminal) {
+  auto& c = Detail::local();
+  Detail::increment(c.nodesVisited);
+  Detail::increment(isTerminal ? c.terminalEvaluations
+                               : c.interiorEvaluations);
+}
+inline void countPolicyCall() {
+  Detail::increment(Detail::local().policyCalls);
+}
+inline void countUpdateCall() {
+  Detail::increment(Detail::local().updateCalls);
+}
+inline void countSuccessorEnumeration() {
+  Detail::increment(Detail::local().successorEnumerations);
+}
+
+/**
+ * Marks one level of recursion for as long as it is in scope.
+ */
+class DepthScope {
+ public:
+  DepthScope() : counters_(Detail::local()) {
+    ++counters_.depth;
+    if (counters_.depth >
+        counters_.maxDepth.load(std::memory_order_relaxed)) {
+      counters_.maxDepth.store(counters_.depth, std::memory_order_relaxed);
+    }
+  }
+  ~DepthScope() { --counters_.depth; }
+
+ private:
+  Detail::ThreadCounters& counters_;
+};
+
+inline Counters snapshot() { return Detail::Registry::instance().snapshot(); }
+inline void reset() { Detail::Registry::instance().reset(); }
+#else
+constexpr bool enabled = false;
+
+inline void countNodeVisit(bool) {}
+inline void countPolicyCall() {}
+inline void countUpdateCall() {}
+inline void countSuccessorEnumeration() {}
+
+class DepthScope {
+ public:
+  DepthScope() {}
+};
+
+inline Counters snapshot() { return Counters(); }
+inline void reset() {}
+#endif
+}
+}
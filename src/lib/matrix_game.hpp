@@ -1,39 +1,41 @@
 #pragma once
 
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <thread>
 #include <utility>
 
+#include "game_history.hpp"
+#include "instrumentation.hpp"
 #include "history_tree_node.hpp"
 #include "history.hpp"
 #include "utils.hpp"
 #include "policy_generator.hpp"
 
 namespace TreeAndHistoryTraversal {
-namespace Game {
-template <typename HistoryType>
-class GameHistory : public HistoryType {
- protected:
-  template <typename... SuperclassArgs>
-  GameHistory(SuperclassArgs&&... args)
-      : HistoryType(std::forward<SuperclassArgs>(args)...) {}
-
- public:
-  virtual ~GameHistory() {}
-
-  virtual size_t actor() const = 0;
-};
-}
 namespace MatrixGame {
 class MatrixGameHistory : public Game::GameHistory<History::StringHistory> {
  public:
   //  @todo Provide player 1 and player 2 actions
   MatrixGameHistory(std::vector<std::string>&& actions = {"l", "L", "r", "R"})
       : Game::GameHistory<StringHistory>(
-            std::forward<std::vector<std::string>>(actions)) {}
+            std::forward<std::vector<std::string>>(actions)),
+        utilsForPlayer1_(nullptr) {}
+  /**
+   * Only histories given utilities can report them at terminals.
+   */
+  MatrixGameHistory(const std::vector<std::vector<int>>& utilsForPlayer1)
+      : MatrixGameHistory() {
+    utilsForPlayer1_ = &utilsForPlayer1;
+  }
   virtual ~MatrixGameHistory() {}
+  virtual MatrixGameHistory* clone() const override {
+    return new MatrixGameHistory(*this);
+  }
 
   virtual bool suffixIsLegal(
       const std::string& candidateString) const override {
@@ -47,59 +49,72 @@ class MatrixGameHistory : public Game::GameHistory<History::StringHistory> {
   virtual size_t legalActionIndex(size_t player) const {
     return ((action(player) == "l" || action(player) == "L") ? 0 : 1);
   }
+
+  /**
+   * Neither player sees the other's action, so each has one information
+   * set.
+   */
+  virtual std::string informationSet() const override {
+    return std::to_string(actor());
+  }
+  virtual double utility(size_t player) const override {
+    assert(utilsForPlayer1_);
+    const double u =
+        utilsForPlayer1_->at(legalActionIndex(0)).at(legalActionIndex(1));
+    return player == 0 ? u : -u;
+  }
+
+ protected:
+  const std::vector<std::vector<int>>* utilsForPlayer1_;
 };
 
-class BestResponse
-    : public HistoryTreeNode::HistoryTreeNode<std::vector<Utils::Numeric>,
+/**
+ * The state of one best response computation: the responding player, the
+ * reach probabilities accumulated along the current history, the history
+ * itself, and the best response found. The strategy profile and utilities
+ * are only read, so any number of traversals can share them across threads.
+ */
+template <typename Numeric = Utils::Numeric>
+class BestResponseTraversal
+    : public HistoryTreeNode::HistoryTreeNode<std::vector<Numeric>,
                                               std::string> {
  public:
-  BestResponse(const std::vector<std::vector<int>>& utilsForPlayer1,
-               const std::vector<std::vector<Utils::Numeric>>& stratProfile)
-      : HistoryTreeNode<std::vector<Utils::Numeric>, std::string>::
+  BestResponseTraversal(size_t responder,
+                        const std::vector<std::vector<int>>& utilsForPlayer1,
+                        const std::vector<std::vector<Numeric>>& stratProfile)
+      : HistoryTreeNode::HistoryTreeNode<std::vector<Numeric>, std::string>::
             HistoryTreeNode(static_cast<History::History<std::string>*>(
                 new MatrixGameHistory())),
         reachProbProfile_({{1.0, 1.0}, {1.0, 1.0}}),
         strategyProfile_(&stratProfile),
         brProfile_({{1.0, 0.0}, {1.0, 0.0}}),
         utilsForPlayer1_(&utilsForPlayer1),
-        i_(0) {}
-  virtual ~BestResponse() {}
-
-  virtual std::vector<Utils::Numeric> valueProfile() {
-    const auto u1Vec = value();
-    i_ = (i_ + 1) % brProfile_.size();
-    const auto u2Vec = value();
-    i_ = (i_ + 1) % brProfile_.size();
-
-    std::vector<Utils::Numeric> brValues(brProfile_.size());
-    for (size_t i = 0; i < u1Vec.size(); ++i) {
-      if (i == 0 || u1Vec[i] > brValues[0]) {
-        brValues[0] = u1Vec[i];
-      }
-      if (i == 0 || u2Vec[i] > brValues[1]) {
-        brValues[1] = u2Vec[i];
-      }
-    }
-    return brValues;
-  }
+        i_(responder) {}
+  virtual ~BestResponseTraversal() {}
 
-  virtual double averageExploitability() {
-    const auto brValues = valueProfile();
-    return (brValues[0] + brValues[1]) / 2.0;
+  /**
+   * The largest value the responder can achieve.
+   */
+  virtual Numeric bestValue() {
+    const auto values = this->value();
+    return values[Utils::argmax(values.data(), values.size())];
   }
 
-  virtual const std::vector<std::vector<Utils::Numeric>>& strategyProfile()
-      const {
+  /**
+   * Only the responder's entry is meaningful, and only after a traversal.
+   */
+  virtual const std::vector<std::vector<Numeric>>& strategyProfile() const {
     return brProfile_;
   }
 
  protected:
-  virtual std::vector<Utils::Numeric> terminalValue() override {
+  virtual std::vector<Numeric> terminalValue() override {
     int sign = 1;
     size_t not_i = 1;
     const auto myChoice =
-        static_cast<const MatrixGameHistory*>(history())->legalActionIndex(i_);
-    std::function<Utils::Numeric(size_t)> u =
+        static_cast<const MatrixGameHistory*>(this->history())
+            ->legalActionIndex(i_);
+    std::function<Numeric(size_t)> u =
         [this, &myChoice](size_t opponentChoice) {
           return utilsForPlayer1_->at(myChoice).at(opponentChoice);
         };
@@ -110,7 +125,7 @@ class BestResponse
         return utilsForPlayer1_->at(opponentChoice).at(myChoice);
       };
     }
-    std::vector<Utils::Numeric> values(reachProbProfile_[not_i].size(), 0.0);
+    std::vector<Numeric> values(reachProbProfile_[not_i].size(), 0.0);
     for (size_t opponentChoice = 0;
          opponentChoice < reachProbProfile_[not_i].size(); ++opponentChoice) {
       if (reachProbProfile_[not_i][opponentChoice] > 0.0) {
@@ -121,26 +136,27 @@ class BestResponse
     }
     return values;
   }
-  virtual std::vector<Utils::Numeric> interiorValue() override {
+  virtual std::vector<Numeric> interiorValue() override {
     const auto actor =
-        static_cast<const MatrixGameHistory*>(history())->actor();
+        static_cast<const MatrixGameHistory*>(this->history())->actor();
     const auto& sigma_I = (*strategyProfile_)[actor];
     return (actor != i_) ? opponentValue(actor, sigma_I)
                          : myValue(actor, sigma_I);
   }
 
-  virtual std::vector<Utils::Numeric> opponentValue(
+  virtual std::vector<Numeric> opponentValue(
       size_t actor,
-      const std::vector<Utils::Numeric>& sigma_I) {
-    std::vector<Utils::Numeric> counterfactualValue;
+      const std::vector<Numeric>& sigma_I) {
+    std::vector<Numeric> counterfactualValue;
     reachProbProfile_[actor] =
         Utils::copyAndReturnAfter(reachProbProfile_[actor], [&]() {
-          history_->eachSuccessor([&](size_t, size_t legalSuccessorIndex) {
+          this->history_->eachSuccessor([&](size_t,
+                                            size_t legalSuccessorIndex) {
             reachProbProfile_[actor][legalSuccessorIndex] =
                 reachProbProfile_[actor][legalSuccessorIndex] *
                 sigma_I[legalSuccessorIndex];
             if (legalSuccessorIndex == (sigma_I.size() - 1)) {
-              counterfactualValue = value();
+              counterfactualValue = this->value();
             }
             return false;
           });
@@ -148,55 +164,147 @@ class BestResponse
     return counterfactualValue;
   }
 
-  virtual std::vector<Utils::Numeric> myValue(
+  virtual std::vector<Numeric> myValue(
       size_t actor,
-      const std::vector<Utils::Numeric>& sigma_I) {
-    std::vector<Utils::Numeric> actionVals(sigma_I.size(), 0.0);
-    history_->eachSuccessor([&](size_t, size_t legalSuccessorIndex) {
-      const std::vector<Utils::Numeric> valsForAllOpponentChoices = value();
-      for (size_t i = 0; i < valsForAllOpponentChoices.size(); ++i) {
-        actionVals[legalSuccessorIndex] += valsForAllOpponentChoices[i];
-      }
+      const std::vector<Numeric>& sigma_I) {
+    std::vector<Numeric> actionVals(sigma_I.size(), 0.0);
+    this->history_->eachSuccessor([&](size_t, size_t legalSuccessorIndex) {
+      const std::vector<Numeric> valsForAllOpponentChoices = this->value();
+      actionVals[legalSuccessorIndex] = Utils::sum(
+          valsForAllOpponentChoices.data(), valsForAllOpponentChoices.size());
       return false;
     });
 
-    Utils::Numeric bestValueSoFar;
-    history_->eachLegalSuffix(
-        [&](std::string, size_t, size_t legalSuccessorIndex) {
-          if (legalSuccessorIndex == 0 ||
-              actionVals[legalSuccessorIndex] > bestValueSoFar) {
-            bestValueSoFar = actionVals[legalSuccessorIndex];
-            brProfile_[actor][legalSuccessorIndex] = 1.0;
-          } else {
-            brProfile_[actor][legalSuccessorIndex] = 0.0;
-          }
-          return false;
-        });
+    const auto bestAction = Utils::argmax(actionVals.data(), actionVals.size());
+    for (size_t a = 0; a < actionVals.size(); ++a) {
+      brProfile_[actor][a] = (a == bestAction) ? 1.0 : 0.0;
+    }
     return actionVals;
   }
 
  protected:
   // Player / action
-  std::vector<std::vector<Utils::Numeric>> reachProbProfile_;
-  const std::vector<std::vector<Utils::Numeric>>* strategyProfile_;
-  std::vector<std::vector<Utils::Numeric>> brProfile_;
+  std::vector<std::vector<Numeric>> reachProbProfile_;
+  const std::vector<std::vector<Numeric>>* strategyProfile_;
+  std::vector<std::vector<Numeric>> brProfile_;
   const std::vector<std::vector<int>>* utilsForPlayer1_;
-  size_t i_;
+  const size_t i_;
+};
+
+/**
+ * Best responses to a fixed strategy profile. Every query builds its own
+ * BestResponseTraversal per player, so a BestResponse is immutable and may
+ * be queried from several threads at once.
+ */
+template <typename Numeric = Utils::Numeric>
+class BestResponse {
+ public:
+  /**
+   * When concurrent is true, the two players' best responses are computed
+   * on separate threads. That only pays off once a traversal is much more
+   * expensive than starting a thread.
+   */
+  BestResponse(const std::vector<std::vector<int>>& utilsForPlayer1,
+               const std::vector<std::vector<Numeric>>& stratProfile,
+               bool concurrent = false)
+      : strategyProfile_(&stratProfile),
+        utilsForPlayer1_(&utilsForPlayer1),
+        concurrent_(concurrent) {}
+  virtual ~BestResponse() {}
+
+  virtual std::vector<Numeric> valueProfile() const {
+    std::vector<Numeric> brValues(strategyProfile_->size());
+    eachTraversal([&brValues](size_t i, BestResponseTraversal<Numeric>& br) {
+      brValues[i] = br.bestValue();
+    });
+    return brValues;
+  }
+
+  virtual Numeric averageExploitability() const {
+    const auto brValues = valueProfile();
+    return (brValues[0] + brValues[1]) / 2.0;
+  }
+
+  /**
+   * Each player's pure best response to the other's strategy.
+   */
+  virtual std::vector<std::vector<Numeric>> strategyProfile() const {
+    std::vector<std::vector<Numeric>> brProfile(strategyProfile_->size());
+    eachTraversal([&brProfile](size_t i, BestResponseTraversal<Numeric>& br) {
+      br.value();
+      brProfile[i] = br.strategyProfile()[i];
+    });
+    return brProfile;
+  }
+
+ protected:
+  void eachTraversal(
+      std::function<void(size_t i, BestResponseTraversal<Numeric>& br)> doFn)
+      const {
+    const auto run = [this, &doFn](size_t i) {
+      BestResponseTraversal<Numeric> br(i, *utilsForPlayer1_,
+                                        *strategyProfile_);
+      doFn(i, br);
+    };
+    if (!concurrent_) {
+      for (size_t i = 0; i < strategyProfile_->size(); ++i) {
+        run(i);
+      }
+      return;
+    }
+    std::vector<std::thread> others;
+    for (size_t i = 1; i < strategyProfile_->size(); ++i) {
+      others.emplace_back(run, i);
+    }
+    run(0);
+    for (auto& other : others) {
+      other.join();
+    }
+  }
+
+ protected:
+  const std::vector<std::vector<Numeric>>* strategyProfile_;
+  const std::vector<std::vector<int>>* utilsForPlayer1_;
+  const bool concurrent_;
 };
 
-template <typename InformationSet, typename Sequence, typename Regret>
-class Cfr
-    : public HistoryTreeNode::HistoryTreeNode<Utils::Numeric, std::string> {
+using Game::Estimate;
+using Game::SamplingOptions;
+
+/**
+ * Every player has one information set, at which it plays its row of
+ * profile.
+ */
+template <typename Numeric>
+Game::Policy policyOf(const std::vector<std::vector<Numeric>>& profile) {
+  return [profile](size_t player, const std::string&) {
+    return std::vector<double>(profile[player].begin(),
+                               profile[player].end());
+  };
+}
+
+/**
+ * ALTERNATING traverses the tree once per player per iteration and updates
+ * only that player. SIMULTANEOUS computes every player's values in a single
+ * traversal and updates all players from the same current profile.
+ */
+enum class UpdateMode { ALTERNATING, SIMULTANEOUS };
+
+template <typename InformationSet, typename Sequence, typename Numeric>
+class Cfr : public HistoryTreeNode::HistoryTreeNode<Numeric, std::string> {
  public:
   // @todo Assumes the matrix game has two actions, which should be generalized
   Cfr(const std::vector<std::vector<int>>& utilsForPlayer1,
-      std::vector<
-          PolicyGenerator::PolicyGenerator<InformationSet, Sequence, Regret>*>&&
+      std::vector<PolicyGenerator::PolicyGenerator<InformationSet,
+                                                   Sequence,
+                                                   Numeric>*>&&
           policyGeneratorProfile,
-      std::vector<
-          PolicyGenerator::PolicyGenerator<InformationSet, Sequence, Regret>*>&&
-          averageGeneratorProfile)
-      : HistoryTreeNode<Utils::Numeric, std::string>::HistoryTreeNode(
+      std::vector<PolicyGenerator::PolicyGenerator<InformationSet,
+                                                   Sequence,
+                                                   Numeric>*>&&
+          averageGeneratorProfile,
+      UpdateMode updateMode = UpdateMode::ALTERNATING)
+      : HistoryTreeNode::HistoryTreeNode<Numeric, std::string>::HistoryTreeNode(
             static_cast<History::History<std::string>*>(
                 new MatrixGameHistory())),
         reachProbProfile_({{1.0, 1.0}, {1.0, 1.0}}),
@@ -204,7 +312,18 @@ class Cfr
         cumulativeAverageStrategyProfile_(std::move(averageGeneratorProfile)),
         utilsForPlayer1_(&utilsForPlayer1),
         i_(0),
-        averageStrategyProfile_({{1.0, 0}, {1.0, 0}}) {}
+        t_(0),
+        updateMode_(updateMode),
+        averageStrategyProfile_({{1.0, 0}, {1.0, 0}}),
+        currentProfile_(policyGeneratorProfile_.size()),
+        maxNumActions_(std::max(utilsForPlayer1.size(),
+                                utilsForPlayer1.front().size())),
+        simultaneousReachProbs_((policyGeneratorProfile_.size() + 1) *
+                                policyGeneratorProfile_.size()),
+        simultaneousActionValues_(policyGeneratorProfile_.size() *
+                                  maxNumActions_ *
+                                  policyGeneratorProfile_.size()),
+        simultaneousValues_(policyGeneratorProfile_.size()) {}
   virtual ~Cfr() {
     for (auto& policyGenerator : policyGeneratorProfile_) {
       if (policyGenerator) {
@@ -225,17 +344,116 @@ class Cfr
   }
 
   virtual void doIteration() {
-    value();
-    i_ = (i_ + 1) % cumulativeAverageStrategyProfile_.size();
+    for (auto policyGenerator : policyGeneratorProfile_) {
+      policyGenerator->setIteration(t_);
+    }
+    if (updateMode_ == UpdateMode::SIMULTANEOUS) {
+      // Regrets change during the traversal, so the profile being evaluated
+      // is fixed up front.
+      const size_t numPlayers = policyGeneratorProfile_.size();
+      for (size_t player = 0; player < numPlayers; ++player) {
+        currentProfile_[player] = policyGeneratorProfile_[player]->policy(0);
+      }
+      std::fill(simultaneousReachProbs_.begin(),
+                simultaneousReachProbs_.begin() + numPlayers, Numeric(1.0));
+      simultaneousValue(currentProfile_, 0, simultaneousValues_.data());
+    } else {
+      this->value();
+      i_ = (i_ + 1) % cumulativeAverageStrategyProfile_.size();
+    }
+    ++t_;
+  }
+
+  UpdateMode updateMode() const { return updateMode_; }
+
+  /**
+   * Tables, by kind, the history, and this solver's own profiles.
+   */
+  virtual MemoryAccounting::Breakdown memoryBreakdown() const {
+    MemoryAccounting::Usage regretTables;
+    MemoryAccounting::Usage averageTables;
+    for (size_t player = 0; player < policyGeneratorProfile_.size();
+         ++player) {
+      regretTables += policyGeneratorProfile_[player]->memoryUsage() +
+                      MemoryAccounting::Usage(0, 1);
+      averageTables +=
+          cumulativeAverageStrategyProfile_[player]->memoryUsage() +
+          MemoryAccounting::Usage(0, 1);
+    }
+    const auto profiles =
+        MemoryAccounting::Usage(sizeof(*this)) +
+        MemoryAccounting::ofNested(reachProbProfile_) +
+        MemoryAccounting::ofNested(averageStrategyProfile_) +
+        MemoryAccounting::ofNested(currentProfile_) +
+        MemoryAccounting::ofContainer(simultaneousReachProbs_) +
+        MemoryAccounting::ofContainer(simultaneousActionValues_) +
+        MemoryAccounting::ofContainer(simultaneousValues_) +
+        MemoryAccounting::ofContainer(policyGeneratorProfile_) +
+        MemoryAccounting::ofContainer(cumulativeAverageStrategyProfile_);
+    return {{"regret tables", regretTables},
+            {"average tables", averageTables},
+            {"history",
+             this->history()->memoryUsage() + MemoryAccounting::Usage(0, 1)},
+            {"profiles", profiles}};
+  }
+  virtual MemoryAccounting::Usage memoryUsage() const override {
+    return MemoryAccounting::total(memoryBreakdown());
   }
 
-  virtual double averageExploitability() const {
+  /**
+   * Seeds the tables with numVirtualIterations iterations' worth of the
+   * regrets and average strategy contributions of profile, such as a prior
+   * solver's strategyProfile() on slightly different utilities. The
+   * iteration count is left as it was.
+   */
+  virtual void warmStart(const std::vector<std::vector<Numeric>>& profile,
+                         size_t numVirtualIterations) {
+    typedef PolicyGenerator::WarmStartGenerator<InformationSet, Sequence,
+                                                Numeric>
+        WarmStart;
+    auto tables = policyGeneratorProfile_;
+    auto averageTables = cumulativeAverageStrategyProfile_;
+    for (size_t player = 0; player < tables.size(); ++player) {
+      const auto policyFn = [&profile, player](const InformationSet&) {
+        return profile[player];
+      };
+      policyGeneratorProfile_[player] =
+          new WarmStart(policyFn, tables[player], numVirtualIterations);
+      cumulativeAverageStrategyProfile_[player] = new WarmStart(
+          policyFn, averageTables[player], numVirtualIterations);
+    }
+    const auto i = i_;
+    for (i_ = 0; i_ < tables.size(); ++i_) {
+      this->value();
+    }
+    i_ = i;
+    for (size_t player = 0; player < tables.size(); ++player) {
+      delete policyGeneratorProfile_[player];
+      delete cumulativeAverageStrategyProfile_[player];
+    }
+    policyGeneratorProfile_ = std::move(tables);
+    cumulativeAverageStrategyProfile_ = std::move(averageTables);
+  }
+
+  virtual Numeric averageExploitability() const {
     const auto avgStrat = strategyProfile();
-    auto br = BestResponse(*utilsForPlayer1_, avgStrat);
+    auto br = BestResponse<Numeric>(*utilsForPlayer1_, avgStrat);
     return br.averageExploitability();
   }
 
-  virtual const std::vector<std::vector<Utils::Numeric>>& strategyProfile()
+  /**
+   * A cheaper, sampled estimate of averageExploitability for frequent
+   * convergence checks.
+   */
+  virtual Estimate<Numeric> sampledAverageExploitability(
+      const SamplingOptions& options = SamplingOptions()) const {
+    return Game::SampledBestResponse<MatrixGameHistory, Numeric>(
+               MatrixGameHistory(*utilsForPlayer1_),
+               policyOf(strategyProfile()), options)
+        .averageExploitability();
+  }
+
+  virtual const std::vector<std::vector<Numeric>>& strategyProfile()
       const {
     for (size_t i = 0; i < cumulativeAverageStrategyProfile_.size(); ++i) {
       averageStrategyProfile_[i] =
@@ -245,12 +463,13 @@ class Cfr
   }
 
  protected:
-  virtual Utils::Numeric terminalValue() override {
+  virtual Numeric terminalValue() override {
     int sign = 1;
     size_t not_i = 1;
     const auto myChoice =
-        static_cast<const MatrixGameHistory*>(history())->legalActionIndex(i_);
-    std::function<Utils::Numeric(size_t)> u =
+        static_cast<const MatrixGameHistory*>(this->history())
+            ->legalActionIndex(i_);
+    std::function<Numeric(size_t)> u =
         [this, &myChoice](size_t opponentChoice) {
           return utilsForPlayer1_->at(myChoice).at(opponentChoice);
         };
@@ -261,7 +480,7 @@ class Cfr
         return utilsForPlayer1_->at(opponentChoice).at(myChoice);
       };
     }
-    Utils::Numeric value = 0.0;
+    Numeric value = 0.0;
     for (size_t opponentChoice = 0;
          opponentChoice < reachProbProfile_[not_i].size(); ++opponentChoice) {
       value +=
@@ -269,21 +488,88 @@ class Cfr
     }
     return value;
   }
-  virtual Utils::Numeric interiorValue() override {
+  virtual Numeric interiorValue() override {
     const auto actor =
-        static_cast<const MatrixGameHistory*>(history())->actor();
+        static_cast<const MatrixGameHistory*>(this->history())->actor();
     const auto sigma_I = policyGeneratorProfile_[actor]->policy(0);
     return (actor != i_) ? opponentValue(actor, sigma_I)
                          : myValue(actor, sigma_I);
   }
 
-  virtual Utils::Numeric opponentValue(
+  /**
+   * Writes every player's expected utility from the current history under
+   * sigma to values, given each player's probability of reaching it in
+   * depth's slice of simultaneousReachProbs_. Each depth has its own slices
+   * of scratch space for its children's reach and values, so traversals
+   * allocate nothing.
+   * Regrets and average strategies are updated at every decision along the
+   * way, weighted by the other players' and the actor's reach probability,
+   * respectively.
+   */
+  virtual void simultaneousValue(const std::vector<std::vector<Numeric>>& sigma,
+                                 size_t depth,
+                                 Numeric* values) {
+    Instrumentation::DepthScope depthScope;
+    const auto h = static_cast<const MatrixGameHistory*>(this->history());
+    const bool terminal = this->isTerminal();
+    Instrumentation::countNodeVisit(terminal);
+    if (terminal) {
+      const Numeric u =
+          utilsForPlayer1_->at(h->legalActionIndex(0))
+              .at(h->legalActionIndex(1));
+      values[0] = u;
+      values[1] = -u;
+      return;
+    }
+    const size_t numPlayers = policyGeneratorProfile_.size();
+    const auto actor = h->actor();
+    const auto& sigma_I = sigma[actor];
+    const Numeric* reachProbs = &simultaneousReachProbs_[depth * numPlayers];
+    Numeric* childReachProbs =
+        &simultaneousReachProbs_[(depth + 1) * numPlayers];
+    // By action, then player
+    Numeric* actionVals =
+        &simultaneousActionValues_[depth * maxNumActions_ * numPlayers];
+
+    std::copy(reachProbs, reachProbs + numPlayers, childReachProbs);
+    this->history_->eachSuccessor([&](size_t, size_t legalSuccessorIndex) {
+      childReachProbs[actor] =
+          reachProbs[actor] * sigma_I[legalSuccessorIndex];
+      simultaneousValue(sigma, depth + 1,
+                        &actionVals[legalSuccessorIndex * numPlayers]);
+      return false;
+    });
+
+    std::fill(values, values + numPlayers, Numeric(0.0));
+    for (size_t a = 0; a < sigma_I.size(); ++a) {
+      Utils::axpy(sigma_I[a], &actionVals[a * numPlayers], numPlayers,
+                  values);
+    }
+
+    Numeric opponentReachProb = 1.0;
+    for (size_t player = 0; player < numPlayers; ++player) {
+      if (player != actor) {
+        opponentReachProb *= reachProbs[player];
+      }
+    }
+    for (size_t a = 0; a < sigma_I.size(); ++a) {
+      policyGeneratorProfile_[actor]->update(
+          std::make_pair(0, a),
+          opponentReachProb *
+              (actionVals[a * numPlayers + actor] - values[actor]));
+      cumulativeAverageStrategyProfile_[actor]->update(
+          std::make_pair(0, a), reachProbs[actor] * sigma_I[a]);
+    }
+  }
+
+  virtual Numeric opponentValue(
       size_t actor,
-      const std::vector<Utils::Numeric>& sigma_I) {
-    Utils::Numeric counterfactualValue;
+      const std::vector<Numeric>& sigma_I) {
+    Numeric counterfactualValue;
     reachProbProfile_[actor] =
         Utils::copyAndReturnAfter(reachProbProfile_[actor], [&]() {
-          history_->eachSuccessor([&](size_t, size_t legalSuccessorIndex) {
+          this->history_->eachSuccessor([&](size_t,
+                                            size_t legalSuccessorIndex) {
             assert(sigma_I[legalSuccessorIndex] >= 0.0);
             reachProbProfile_[actor][legalSuccessorIndex] *=
                 sigma_I[legalSuccessorIndex];
@@ -291,7 +577,7 @@ class Cfr
                 std::make_pair(0, legalSuccessorIndex),
                 reachProbProfile_[actor][legalSuccessorIndex]);
             if (legalSuccessorIndex == reachProbProfile_.size() - 1) {
-              counterfactualValue = value();
+              counterfactualValue = this->value();
             }
             return false;
           });
@@ -299,44 +585,52 @@ class Cfr
     return counterfactualValue;
   }
 
-  virtual Utils::Numeric myValue(size_t actor,
-                                 const std::vector<Utils::Numeric>& sigma_I) {
-    std::vector<Utils::Numeric> actionVals;
-    actionVals.reserve(sigma_I.size());
-    Utils::Numeric counterfactualValue = 0.0;
+  virtual Numeric myValue(size_t actor,
+                                 const std::vector<Numeric>& sigma_I) {
+    const auto legalSuffixes = this->history_->legalSuffixes();
+    const size_t numActions = legalSuffixes.size();
+    std::vector<Numeric> actionVals(numActions);
     reachProbProfile_[actor] =
         Utils::copyAndReturnAfter(reachProbProfile_[actor], [&]() {
-          history_->eachSuccessor([&](size_t, size_t legalSuccessorIndex) {
-            reachProbProfile_[actor][legalSuccessorIndex] *=
-                sigma_I[legalSuccessorIndex];
-            actionVals.push_back(value());
-            counterfactualValue +=
-                actionVals.back() * sigma_I[legalSuccessorIndex];
-            return false;
-          });
-        });
-    history_->eachLegalSuffix(
-        [&](std::string, size_t, size_t legalSuccessorIndex) {
-          policyGeneratorProfile_[actor]->update(
-              std::make_pair(0, legalSuccessorIndex),
-              actionVals[legalSuccessorIndex] - counterfactualValue);
-          return false;
+          for (size_t a = 0; a < numActions; ++a) {
+            reachProbProfile_[actor][a] *= sigma_I[a];
+            this->history_->pushSuffix(legalSuffixes[a]);
+            actionVals[a] = this->value();
+            this->history_->pop();
+          }
         });
+    const Numeric counterfactualValue =
+        Utils::dot(actionVals.data(), sigma_I.data(), numActions);
+    for (size_t a = 0; a < numActions; ++a) {
+      policyGeneratorProfile_[actor]->update(
+          std::make_pair(0, a), actionVals[a] - counterfactualValue);
+    }
     return counterfactualValue;
   }
 
  protected:
   // Player / action
-  std::vector<std::vector<Utils::Numeric>> reachProbProfile_;
+  std::vector<std::vector<Numeric>> reachProbProfile_;
   std::vector<
-      PolicyGenerator::PolicyGenerator<InformationSet, Sequence, Regret>*>
+      PolicyGenerator::PolicyGenerator<InformationSet, Sequence, Numeric>*>
       policyGeneratorProfile_;
   std::vector<
-      PolicyGenerator::PolicyGenerator<InformationSet, Sequence, Regret>*>
+      PolicyGenerator::PolicyGenerator<InformationSet, Sequence, Numeric>*>
       cumulativeAverageStrategyProfile_;
   const std::vector<std::vector<int>>* utilsForPlayer1_;
   size_t i_;
-  mutable std::vector<std::vector<Utils::Numeric>> averageStrategyProfile_;
+  size_t t_;
+  const UpdateMode updateMode_;
+  mutable std::vector<std::vector<Numeric>> averageStrategyProfile_;
+  // The profile that a SIMULTANEOUS iteration evaluates
+  std::vector<std::vector<Numeric>> currentProfile_;
+  const size_t maxNumActions_;
+  // By depth, then player
+  std::vector<Numeric> simultaneousReachProbs_;
+  // By depth, then action, then player
+  std::vector<Numeric> simultaneousActionValues_;
+  // By player, at the root
+  std::vector<Numeric> simultaneousValues_;
 };
 
 const size_t NUM_SEQUENCES = 2;
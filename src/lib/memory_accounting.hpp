@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Bytes held by tables, histories, stored trees, and solvers, for sizing
+ * machines and choosing table precision before large runs.
+ *
+ * Counts cover the containers each component owns, by capacity, and the
+ * objects themselves. Allocations inside std::function targets and the
+ * allocator's own bookkeeping are not visible and so not counted.
+ */
+namespace MemoryAccounting {
+struct Usage {
+  size_t liveBytes;
+  // The most held at once so far. Components that never shrink report
+  // their live bytes.
+  size_t peakBytes;
+  // Heap blocks currently held
+  size_t numAllocations;
+
+  Usage(size_t liveBytes = 0, size_t numAllocations = 0)
+      : liveBytes(liveBytes),
+        peakBytes(liveBytes),
+        numAllocations(numAllocations) {}
+
+  /**
+   * Parts held at the same time add, peaks included.
+   */
+  Usage& operator+=(const Usage& other) {
+    liveBytes += other.liveBytes;
+    peakBytes += other.peakBytes;
+    numAllocations += other.numAllocations;
+    return *this;
+  }
+};
+inline Usage operator+(Usage a, const Usage& b) { return a += b; }
+
+/**
+ * Usage with peakBytes raised to at least peak.
+ */
+inline Usage withPeak(Usage usage, size_t peak) {
+  usage.peakBytes = std::max(usage.peakBytes, peak);
+  return usage;
+}
+
+template <typename Container>
+Usage ofContainer(const Container& c) {
+  return Usage(c.capacity() * sizeof(typename Container::value_type),
+               c.capacity() > 0);
+}
+
+/**
+ * Includes each string's own buffer once it outgrows the small string
+ * buffer.
+ */
+inline Usage ofStrings(const std::vector<std::string>& strings) {
+  static const size_t smallCapacity = std::string().capacity();
+  Usage usage = ofContainer(strings);
+  for (const auto& s : strings) {
+    if (s.capacity() > smallCapacity) {
+      usage += Usage(s.capacity() + 1, 1);
+    }
+  }
+  return usage;
+}
+
+template <typename Container>
+Usage ofNested(const Container& c) {
+  Usage usage = ofContainer(c);
+  for (const auto& inner : c) {
+    usage += ofContainer(inner);
+  }
+  return usage;
+}
+
+struct Component {
+  std::string name;
+  Usage usage;
+};
+typedef std::vector<Component> Breakdown;
+
+inline Usage total(const Breakdown& breakdown) {
+  Usage usage;
+  for (const auto& component : breakdown) {
+    usage += component.usage;
+  }
+  return usage;
+}
+
+/**
+ * One line per component and a total, each prefixed by prefix.
+ */
+inline std::string format(const Breakdown& breakdown,
+                          const std::string& prefix = "") {
+  std::string text;
+  char line[160];
+  auto components = breakdown;
+  components.push_back({"total", total(breakdown)});
+  for (const auto& component : components) {
+    snprintf(line, sizeof(line),
+             "%s%-20s%14zu live B%14zu peak B%10zu allocs\n",
+             prefix.c_str(), component.name.c_str(),
+             component.usage.liveBytes, component.usage.peakBytes,
+             component.usage.numAllocations);
+    text += line;
+  }
+  return text;
+}
+}
+}
@@ -0,0 +1,439 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "instrumentation.hpp"
+#include "policy_generator.hpp"
+#include "sequence_form.hpp"
+#include "utils.hpp"
+
+namespace TreeAndHistoryTraversal {
+/**
+ * CFR split across worker processes on one machine, sharing their tables
+ * through POSIX shared memory. Requires Linux.
+ */
+namespace MultiProcess {
+/**
+ * A named POSIX shared memory object, zero-filled and mapped into this
+ * process. Processes forked afterwards share the mapping. The name is
+ * unlinked on destruction.
+ */
+class SharedRegion {
+ public:
+  SharedRegion(const std::string& name, size_t numBytes)
+      : name_(name), numBytes_(numBytes), data_(nullptr) {
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      throw error("create", errno);
+    }
+    if (ftruncate(fd, numBytes) != 0) {
+      const int e = errno;
+      close(fd);
+      shm_unlink(name.c_str());
+      throw error("size", e);
+    }
+    void* data =
+        mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int e = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+      shm_unlink(name.c_str());
+      throw error("map", e);
+    }
+    data_ = data;
+  }
+  ~SharedRegion() {
+    munmap(data_, numBytes_);
+    shm_unlink(name_.c_str());
+  }
+  SharedRegion(const SharedRegion&) = delete;
+  SharedRegion& operator=(const SharedRegion&) = delete;
+
+  void* data() const { return data_; }
+  size_t numBytes() const { return numBytes_; }
+  const std::string& name() const { return name_; }
+
+ protected:
+  std::runtime_error error(const std::string& what, int e) const {
+    return std::runtime_error("Unable to " + what + " shared memory, \"" +
+                              name_ + "\": " + strerror(e));
+  }
+
+  const std::string name_;
+  const size_t numBytes_;
+  void* data_;
+};
+
+namespace Detail {
+/**
+ * Regret matching on a table that only the coordinator writes. Updates
+ * accumulate in this worker's own delta table until the coordinator merges
+ * them at the end of the phase.
+ */
+class SharedTable : public PolicyGenerator::PolicyGenerator<
+                        size_t,
+                        std::pair<size_t, size_t>,
+                        double> {
+ public:
+  SharedTable(const double* table,
+              double* delta,
+              size_t numSequences,
+              const std::vector<size_t>& numActionsAtEachInfoSet,
+              const std::vector<size_t>& numSequencesBeforeEachInfoSet)
+      : table_(table),
+        delta_(delta),
+        numSequences_(numSequences),
+        numActionsAtEachInfoSet_(&numActionsAtEachInfoSet),
+        numSequencesBeforeEachInfoSet_(&numSequencesBeforeEachInfoSet) {}
+  virtual ~SharedTable() {}
+
+  virtual std::vector<double> policy(const size_t& I) const override {
+    Instrumentation::countPolicyCall();
+    const auto numActions = (*numActionsAtEachInfoSet_)[I];
+    std::vector<double> policy_(numActions);
+    Utils::normalize(&table_[(*numSequencesBeforeEachInfoSet_)[I]],
+                     numActions, policy_.data());
+    return policy_;
+  }
+  virtual void update(const std::pair<size_t, size_t>& sequence,
+                      double value) override {
+    Instrumentation::countUpdateCall();
+    delta_[(*numSequencesBeforeEachInfoSet_)[sequence.first] +
+           sequence.second] += value;
+  }
+  virtual size_t complexity() const override { return numSequences_; }
+
+ protected:
+  const double* table_;
+  double* delta_;
+  const size_t numSequences_;
+  const std::vector<size_t>* numActionsAtEachInfoSet_;
+  const std::vector<size_t>* numSequencesBeforeEachInfoSet_;
+};
+
+struct Control {
+  // Phase t * numPlayers + i + 1 updates player i in iteration t
+  std::atomic<uint64_t> phase;
+  std::atomic<uint64_t> stop;
+  char padding[64 - 2 * sizeof(std::atomic<uint64_t>)];
+};
+
+struct WorkerSlot {
+  std::atomic<uint64_t> donePhase;
+  char padding[64 - sizeof(std::atomic<uint64_t>)];
+};
+}
+
+/**
+ * Alternating-update CFR on a compiled game whose root is a chance node.
+ * Each worker process traverses the subtrees below a fixed share of the
+ * root's outcomes and adds its regret and average strategy updates to its
+ * own delta tables. Between phases, the coordinator (the constructing
+ * process) merges the deltas into the shared tables, so the tables only
+ * ever change while every worker is idle.
+ *
+ * A worker that dies is forked again and redoes its share of the current
+ * phase, and the tables lose nothing. Workers exit on their own if the
+ * coordinator dies.
+ */
+class Cfr {
+ public:
+  /**
+   * name must be a valid shm_open name, like "/my_solve", not in use by
+   * another solver. With regretMatchingPlus, merged regrets are floored at
+   * zero.
+   */
+  Cfr(const SequenceForm::CompiledGame& game,
+      size_t numWorkers,
+      const std::string& name,
+      bool regretMatchingPlus = false)
+      : game_(&game),
+        numWorkers_(numWorkers),
+        regretMatchingPlus_(regretMatchingPlus),
+        numSequencesBeforeEachPlayer_(game.numPlayers + 1, 0),
+        region_(name, numBytes(game, numWorkers)),
+        coordinator_(getpid()),
+        pids_(numWorkers, -1),
+        averageStrategyProfile_(game.numPlayers),
+        numRestarts_(0),
+        t_(0) {
+    if (game.numNodes() == 0 || !game.isChance(0)) {
+      throw std::invalid_argument(
+          "Multi-process CFR divides the root chance node's outcomes among "
+          "workers, but the root is not a chance node");
+    }
+    if (numWorkers == 0) {
+      throw std::invalid_argument("At least one worker is required");
+    }
+    for (size_t player = 0; player < game.numPlayers; ++player) {
+      numSequencesBeforeEachPlayer_[player + 1] =
+          numSequencesBeforeEachPlayer_[player] + game.numSequences(player);
+    }
+    char* bytes = static_cast<char*>(region_.data());
+    control_ = new (bytes) Detail::Control();
+    control_->phase.store(0, std::memory_order_relaxed);
+    control_->stop.store(0, std::memory_order_relaxed);
+    slots_ = reinterpret_cast<Detail::WorkerSlot*>(bytes + sizeof(*control_));
+    for (size_t w = 0; w < numWorkers; ++w) {
+      new (&slots_[w]) Detail::WorkerSlot();
+      slots_[w].donePhase.store(0, std::memory_order_relaxed);
+    }
+    tables_ = reinterpret_cast<double*>(bytes + sizeof(*control_) +
+                                        numWorkers * sizeof(*slots_));
+    try {
+      for (size_t w = 0; w < numWorkers; ++w) {
+        pids_[w] = spawn(w);
+      }
+    } catch (...) {
+      stopWorkers();
+      throw;
+    }
+  }
+  Cfr(const Cfr&) = delete;
+  Cfr& operator=(const Cfr&) = delete;
+  virtual ~Cfr() { stopWorkers(); }
+
+  virtual void doIterations(size_t numIterations) {
+    for (size_t t = 0; t < numIterations; ++t) {
+      doIteration();
+    }
+  }
+
+  virtual void doIteration() {
+    for (size_t i = 0; i < game_->numPlayers; ++i) {
+      runPhase(t_ * game_->numPlayers + i + 1);
+    }
+    ++t_;
+  }
+
+  virtual double averageExploitability() const {
+    return SequenceForm::BestResponse<double>(*game_, strategyProfile())
+        .averageExploitability();
+  }
+
+  /**
+   * The average strategy profile, by player and sequence.
+   */
+  virtual const std::vector<std::vector<double>>& strategyProfile() const {
+    for (size_t player = 0; player < game_->numPlayers; ++player) {
+      auto& profile = averageStrategyProfile_[player];
+      profile.resize(game_->numSequences(player));
+      const double* averages = averageTable(0, player);
+      for (size_t I = 0; I < game_->numInfoSets(player); ++I) {
+        const auto base = game_->numSequencesBeforeEachInfoSet[player][I];
+        Utils::normalize(&averages[base],
+                         game_->numActionsAtEachInfoSet[player][I],
+                         &profile[base]);
+      }
+    }
+    return averageStrategyProfile_;
+  }
+
+  /**
+   * Writes the iteration count and the merged tables, which a solver on
+   * the same game can resume from with loadTables.
+   */
+  virtual void saveTables(std::ostream& out) const {
+    SequenceForm::Detail::write(out, t_);
+    SequenceForm::Detail::write(
+        out, std::vector<double>(tables_, tables_ + blockSize()));
+  }
+  virtual void loadTables(std::istream& in) {
+    const auto t = SequenceForm::Detail::readUint64(in);
+    const auto tables = SequenceForm::Detail::readDoubles(in);
+    if (tables.size() != blockSize()) {
+      throw std::runtime_error("Saved tables do not match this game");
+    }
+    std::copy(tables.begin(), tables.end(), tables_);
+    t_ = t;
+  }
+
+  size_t numWorkers() const { return numWorkers_; }
+  pid_t workerPid(size_t worker) const { return pids_[worker]; }
+  /**
+   * How many times a dead worker has been replaced.
+   */
+  size_t numRestarts() const { return numRestarts_; }
+
+ protected:
+  static size_t numBytes(const SequenceForm::CompiledGame& game,
+                         size_t numWorkers) {
+    size_t numSequences = 0;
+    for (size_t player = 0; player < game.numPlayers; ++player) {
+      numSequences += game.numSequences(player);
+    }
+    // The merged tables, then each worker's deltas
+    return sizeof(Detail::Control) + numWorkers * sizeof(Detail::WorkerSlot) +
+           (1 + numWorkers) * 2 * numSequences * sizeof(double);
+  }
+
+  /**
+   * Regrets for every player, then average strategy weights for every
+   * player.
+   */
+  size_t blockSize() const {
+    return 2 * numSequencesBeforeEachPlayer_.back();
+  }
+  // Block 0 holds the merged tables and block w + 1 worker w's deltas.
+  double* regretTable(size_t block, size_t player) const {
+    return tables_ + block * blockSize() +
+           numSequencesBeforeEachPlayer_[player];
+  }
+  double* averageTable(size_t block, size_t player) const {
+    return regretTable(block, player) + numSequencesBeforeEachPlayer_.back();
+  }
+
+  void runPhase(uint64_t phase) {
+    control_->phase.store(phase, std::memory_order_release);
+    while (true) {
+      bool allDone = true;
+      for (size_t w = 0; w < numWorkers_; ++w) {
+        if (slots_[w].donePhase.load(std::memory_order_acquire) < phase) {
+          allDone = false;
+          replaceIfDead(w, phase);
+        }
+      }
+      if (allDone) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
+    merge();
+  }
+
+  void replaceIfDead(size_t w, uint64_t phase) {
+    int status;
+    if (waitpid(pids_[w], &status, WNOHANG) != pids_[w]) {
+      return;
+    }
+    // A worker that died partway through the phase leaves partial deltas,
+    // so its replacement starts them over.
+    if (slots_[w].donePhase.load(std::memory_order_acquire) < phase) {
+      std::fill(regretTable(w + 1, 0), regretTable(w + 2, 0), 0.0);
+    }
+    ++numRestarts_;
+    pids_[w] = spawn(w);
+  }
+
+  void merge() {
+    const auto n = blockSize();
+    double* merged = tables_;
+    for (size_t w = 0; w < numWorkers_; ++w) {
+      double* delta = regretTable(w + 1, 0);
+      Utils::axpy(1.0, delta, n, merged);
+      std::fill(delta, delta + n, 0.0);
+    }
+    if (regretMatchingPlus_) {
+      const auto numRegrets = numSequencesBeforeEachPlayer_.back();
+      for (size_t k = 0; k < numRegrets; ++k) {
+        merged[k] = merged[k] > 0.0 ? merged[k] : 0.0;
+      }
+    }
+  }
+
+  pid_t spawn(size_t w) {
+    const pid_t pid = fork();
+    if (pid < 0) {
+      throw std::runtime_error(std::string("Unable to fork a worker: ") +
+                               strerror(errno));
+    }
+    if (pid == 0) {
+      // Nothing may unwind out of the child into the coordinator's code,
+      // whose cleanup would unlink the live region, so a failing worker
+      // exits to be reaped and replaced like a killed one.
+      try {
+        work(w);
+      } catch (...) {
+        _exit(1);
+      }
+      _exit(0);
+    }
+    return pid;
+  }
+
+  void work(size_t w) {
+    const auto& game = *game_;
+    std::vector<SequenceForm::Cfr<double>::Generator*> regretGenerators;
+    std::vector<SequenceForm::Cfr<double>::Generator*> averageGenerators;
+    for (size_t player = 0; player < game.numPlayers; ++player) {
+      regretGenerators.push_back(new Detail::SharedTable(
+          regretTable(0, player), regretTable(w + 1, player),
+          game.numSequences(player), game.numActionsAtEachInfoSet[player],
+          game.numSequencesBeforeEachInfoSet[player]));
+      averageGenerators.push_back(new Detail::SharedTable(
+          averageTable(0, player), averageTable(w + 1, player),
+          game.numSequences(player), game.numActionsAtEachInfoSet[player],
+          game.numSequencesBeforeEachInfoSet[player]));
+    }
+    SequenceForm::Cfr<double> cfr(game, std::move(regretGenerators),
+                                  std::move(averageGenerators));
+    std::vector<size_t> rootOutcomes;
+    for (size_t a = w; a < game.numChildren(0); a += numWorkers_) {
+      rootOutcomes.push_back(a);
+    }
+
+    auto& slot = slots_[w];
+    uint64_t lastPhase = slot.donePhase.load(std::memory_order_acquire);
+    while (true) {
+      uint64_t phase;
+      while ((phase = control_->phase.load(std::memory_order_acquire)) <=
+             lastPhase) {
+        if (control_->stop.load(std::memory_order_acquire) ||
+            getppid() != coordinator_) {
+          return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+      }
+      const auto t = (phase - 1) / game.numPlayers;
+      const auto i = (phase - 1) % game.numPlayers;
+      cfr.doPartialIteration(t, i, rootOutcomes);
+      slot.donePhase.store(phase, std::memory_order_release);
+      lastPhase = phase;
+    }
+  }
+
+  void stopWorkers() {
+    control_->stop.store(1, std::memory_order_release);
+    for (auto pid : pids_) {
+      if (pid > 0) {
+        int status;
+        waitpid(pid, &status, 0);
+      }
+    }
+  }
+
+  const SequenceForm::CompiledGame* game_;
+  const size_t numWorkers_;
+  const bool regretMatchingPlus_;
+  // By player, plus one past the last
+  std::vector<size_t> numSequencesBeforeEachPlayer_;
+  SharedRegion region_;
+  const pid_t coordinator_;
+  Detail::Control* control_;
+  Detail::WorkerSlot* slots_;
+  double* tables_;
+  std::vector<pid_t> pids_;
+  mutable std::vector<std::vector<double>> averageStrategyProfile_;
+  size_t numRestarts_;
+  size_t t_;
+};
+}
+}
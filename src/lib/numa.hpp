@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Placement of tables and threads across NUMA nodes, through Linux's
+ * sysfs, mbind, and sched_setaffinity, without libnuma.
+ *
+ * Where the topology cannot be read, everything behaves as a single node
+ * holding every CPU, and placement falls back to first touch by threads
+ * pinned to that node.
+ */
+namespace Numa {
+namespace Detail {
+/**
+ * Parses a sysfs list like "0-3,8,10-11".
+ */
+inline std::vector<size_t> parseList(const std::string& list) {
+  std::vector<size_t> values;
+  size_t i = 0;
+  while (i < list.size()) {
+    char* end;
+    const size_t first = strtoul(list.c_str() + i, &end, 10);
+    if (end == list.c_str() + i) {
+      break;
+    }
+    size_t last = first;
+    i = end - list.c_str();
+    if (i < list.size() && list[i] == '-') {
+      last = strtoul(list.c_str() + i + 1, &end, 10);
+      i = end - list.c_str();
+    }
+    for (size_t v = first; v <= last; ++v) {
+      values.push_back(v);
+    }
+    if (i < list.size() && list[i] == ',') {
+      ++i;
+    }
+  }
+  return values;
+}
+
+inline std::string readLine(const std::string& path) {
+  std::string line;
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file) {
+    return line;
+  }
+  char buffer[4096];
+  if (fgets(buffer, sizeof(buffer), file)) {
+    line = buffer;
+  }
+  fclose(file);
+  return line;
+}
+
+struct Topology {
+  // The kernel's number for each node
+  std::vector<size_t> nodeIds;
+  // By node
+  std::vector<std::vector<size_t>> cpusByNode;
+};
+
+inline Topology readTopology() {
+  Topology topology;
+  for (const auto id :
+       parseList(readLine("/sys/devices/system/node/online"))) {
+    const auto cpus = parseList(readLine("/sys/devices/system/node/node" +
+                                         std::to_string(id) + "/cpulist"));
+    // Nodes with memory but no CPUs cannot run pinned threads.
+    if (!cpus.empty()) {
+      topology.nodeIds.push_back(id);
+      topology.cpusByNode.push_back(cpus);
+    }
+  }
+  if (topology.cpusByNode.empty()) {
+    const size_t numCpus = std::max(1u, std::thread::hardware_concurrency());
+    topology.nodeIds.push_back(0);
+    topology.cpusByNode.emplace_back();
+    for (size_t cpu = 0; cpu < numCpus; ++cpu) {
+      topology.cpusByNode[0].push_back(cpu);
+    }
+  }
+  return topology;
+}
+
+inline const Topology& topology() {
+  static const auto t = readTopology();
+  return t;
+}
+}
+
+/**
+ * Each node's CPUs, read once. Nodes are indexed from zero in the order
+ * that the kernel lists them.
+ */
+inline const std::vector<std::vector<size_t>>& cpusByNode() {
+  return Detail::topology().cpusByNode;
+}
+inline size_t numNodes() { return cpusByNode().size(); }
+
+/**
+ * Restricts the calling thread to the node's CPUs. Returns false if the
+ * kernel refuses.
+ */
+inline bool pinThisThread(size_t node) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const auto cpu : cpusByNode()[node % numNodes()]) {
+    CPU_SET(cpu, &set);
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  (void)node;
+  return false;
+#endif
+}
+
+/**
+ * Runs doFn(node, thread) on numThreadsPerNode threads pinned to each node
+ * and waits for all of them.
+ */
+inline void runPinned(size_t numThreadsPerNode,
+                      std::function<void(size_t node, size_t thread)> doFn) {
+  std::vector<std::thread> threads;
+  for (size_t node = 0; node < numNodes(); ++node) {
+    for (size_t thread = 0; thread < numThreadsPerNode; ++thread) {
+      threads.emplace_back([&doFn, node, thread]() {
+        pinThisThread(node);
+        doFn(node, thread);
+      });
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+enum class Placement {
+  // Wherever the allocating thread's first touch puts it
+  DEFAULT,
+  // Pages spread round-robin across every node
+  INTERLEAVED,
+  // Contiguous ranges, one per node, each placed on its node
+  PARTITIONED
+};
+
+/**
+ * Where each node's range of a table starts, in elements.
+ */
+struct Layout {
+  Placement placement;
+  // By node, plus one past the last
+  std::vector<size_t> firstElementOnEachNode;
+
+  Layout() : placement(Placement::DEFAULT) {}
+  Layout(Placement placement_, std::vector<size_t>&& firstElementOnEachNode_)
+      : placement(placement_),
+        firstElementOnEachNode(std::move(firstElementOnEachNode_)) {}
+};
+
+/**
+ * Splits information sets into one contiguous range per node with roughly
+ * equal numbers of sequences, never splitting an information set. Returns
+ * the first information set on each node, plus one past the last.
+ */
+inline std::vector<size_t> partitionInfoSets(
+    const std::vector<size_t>& numSequencesBeforeEachInfoSet,
+    size_t numSequences,
+    size_t numNodes) {
+  std::vector<size_t> firstInfoSets(numNodes + 1,
+                                    numSequencesBeforeEachInfoSet.size());
+  size_t I = 0;
+  for (size_t node = 0; node < numNodes; ++node) {
+    const size_t target = node * numSequences / numNodes;
+    while (I < numSequencesBeforeEachInfoSet.size() &&
+           numSequencesBeforeEachInfoSet[I] < target) {
+      ++I;
+    }
+    firstInfoSets[node] = I;
+  }
+  return firstInfoSets;
+}
+
+/**
+ * A standard allocator that places its allocations according to a Layout
+ * shared by every copy. Placed allocations are whole pages from mmap.
+ */
+template <typename T>
+class Allocator {
+ public:
+  typedef T value_type;
+
+  Allocator() : layout_(defaultLayout()) {}
+  Allocator(std::shared_ptr<const Layout> layout) : layout_(layout) {}
+  template <typename U>
+  Allocator(const Allocator<U>& other) : layout_(other.layout()) {}
+
+  T* allocate(size_t n) {
+    if (layout_->placement == Placement::DEFAULT) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+#ifdef __linux__
+    const size_t numBytes = roundUpToPage(n * sizeof(T));
+    void* data = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    place(static_cast<char*>(data), numBytes);
+    return static_cast<T*>(data);
+#else
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+#endif
+  }
+
+  void deallocate(T* p, size_t n) {
+#ifdef __linux__
+    if (layout_->placement != Placement::DEFAULT) {
+      munmap(p, roundUpToPage(n * sizeof(T)));
+      return;
+    }
+#endif
+    (void)n;
+    ::operator delete(p);
+  }
+
+  const std::shared_ptr<const Layout>& layout() const { return layout_; }
+
+  template <typename U>
+  bool operator==(const Allocator<U>& other) const {
+    return layout_ == other.layout();
+  }
+  template <typename U>
+  bool operator!=(const Allocator<U>& other) const {
+    return !(*this == other);
+  }
+
+ protected:
+  static const std::shared_ptr<const Layout>& defaultLayout() {
+    static const std::shared_ptr<const Layout> layout =
+        std::make_shared<Layout>();
+    return layout;
+  }
+
+#ifdef __linux__
+  static size_t pageSize() {
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+  }
+  static size_t roundUpToPage(size_t numBytes) {
+    return (numBytes + pageSize() - 1) / pageSize() * pageSize();
+  }
+  static size_t roundDownToPage(size_t numBytes) {
+    return numBytes / pageSize() * pageSize();
+  }
+
+  static void bind(char* begin, size_t numBytes, int mode, size_t node) {
+    const auto& nodeIds = Detail::topology().nodeIds;
+    unsigned long mask = 0;
+    for (size_t i = 0; i < nodeIds.size(); ++i) {
+      if ((mode == MPOL_INTERLEAVE || i == node) &&
+          nodeIds[i] < 8 * sizeof(mask)) {
+        mask |= 1ul << nodeIds[i];
+      }
+    }
+    // Without NUMA support in the kernel, this fails and first touch
+    // decides.
+    syscall(__NR_mbind, begin, numBytes, mode, &mask, 8 * sizeof(mask), 0);
+  }
+
+  /**
+   * Binds each node's pages, then touches them from threads pinned to that
+   * node so that first touch agrees where binding is unavailable.
+   */
+  void place(char* data, size_t numBytes) const {
+    if (layout_->placement == Placement::INTERLEAVED) {
+      bind(data, numBytes, MPOL_INTERLEAVE, 0);
+      return;
+    }
+    const auto& firstElements = layout_->firstElementOnEachNode;
+    if (firstElements.size() < 2) {
+      return;
+    }
+    const size_t numParts = firstElements.size() - 1;
+    std::vector<std::pair<size_t, size_t>> ranges(numParts);
+    for (size_t part = 0; part < numParts; ++part) {
+      ranges[part].first =
+          roundDownToPage(firstElements[part] * sizeof(T));
+      ranges[part].second =
+          part + 1 == numParts
+              ? numBytes
+              : roundDownToPage(firstElements[part + 1] * sizeof(T));
+      if (ranges[part].second > ranges[part].first) {
+        bind(data + ranges[part].first,
+             ranges[part].second - ranges[part].first, MPOL_PREFERRED,
+             part % numNodes());
+      }
+    }
+    runPinned(1, [&](size_t node, size_t) {
+      for (size_t part = node; part < numParts; part += numNodes()) {
+        if (ranges[part].second > ranges[part].first) {
+          memset(data + ranges[part].first, 0,
+                 ranges[part].second - ranges[part].first);
+        }
+      }
+    });
+  }
+#endif
+
+  std::shared_ptr<const Layout> layout_;
+};
+
+/**
+ * A Layout for a table of sequences that places each node's range of
+ * information sets, as partitionInfoSets splits them, on that node.
+ */
+inline std::shared_ptr<const Layout> layoutByInfoSet(
+    Placement placement,
+    const std::vector<size_t>& numSequencesBeforeEachInfoSet,
+    size_t numSequences) {
+  std::vector<size_t> firstElements;
+  if (placement == Placement::PARTITIONED) {
+    const auto firstInfoSets = partitionInfoSets(
+        numSequencesBeforeEachInfoSet, numSequences, numNodes());
+    for (const auto I : firstInfoSets) {
+      firstElements.push_back(I < numSequencesBeforeEachInfoSet.size()
+                                  ? numSequencesBeforeEachInfoSet[I]
+                                  : numSequences);
+    }
+  }
+  return std::make_shared<Layout>(placement, std::move(firstElements));
+}
+}
+}
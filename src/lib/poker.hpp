@@ -0,0 +1,402 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game_history.hpp"
+#include "history.hpp"
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Small poker games with chance and hidden information, used as standard
+ * workloads. Player 0 acts first in every betting round.
+ */
+namespace Poker {
+namespace Detail {
+inline size_t rank(const std::string& card) {
+  switch (card[0]) {
+    case 'J':
+      return 0;
+    case 'Q':
+      return 1;
+    default:
+      return 2;
+  }
+}
+
+inline bool kuhnIsTerminal(const std::string& actions) {
+  return actions == "pp" || actions == "bp" || actions == "bb" ||
+         actions == "pbp" || actions == "pbb";
+}
+inline double kuhnUtility(const std::string& actions,
+                          size_t rank0,
+                          size_t rank1,
+                          size_t player) {
+  double u;
+  if (actions == "bp") {
+    u = 1;
+  } else if (actions == "pbp") {
+    u = -1;
+  } else {
+    const double pot = actions == "pp" ? 1 : 2;
+    u = rank0 > rank1 ? pot : -pot;
+  }
+  return player == 0 ? u : -u;
+}
+
+namespace Leduc {
+enum : size_t { MAX_RAISES = 2 };
+
+struct BettingState {
+  size_t round;
+  size_t numActionsThisRound;
+  size_t numRaisesThisRound;
+  double spent[2];
+  // 2 if no one has folded
+  size_t folder;
+  bool needsBoard;
+  bool isTerminal;
+  std::string board;
+  // Where the board is among the symbols, or SIZE_MAX before it is dealt
+  size_t boardIndex;
+
+  size_t actor() const { return numActionsThisRound % 2; }
+  bool isLegal(const std::string& action) const {
+    if (action == "f") {
+      return spent[actor()] < spent[1 - actor()];
+    }
+    if (action == "r") {
+      return numRaisesThisRound < MAX_RAISES;
+    }
+    return action == "c";
+  }
+};
+
+/**
+ * Replays symbols from begin on, where the first symbol after the first
+ * round is the board.
+ */
+template <typename Symbols>
+BettingState bettingState(const Symbols& symbols, size_t begin) {
+  BettingState b;
+  b.round = 0;
+  b.numActionsThisRound = 0;
+  b.numRaisesThisRound = 0;
+  b.spent[0] = b.spent[1] = 1;
+  b.folder = 2;
+  b.needsBoard = false;
+  b.isTerminal = false;
+  b.boardIndex = SIZE_MAX;
+  for (size_t i = begin; i < symbols.size(); ++i) {
+    const auto& s = symbols[i];
+    if (b.needsBoard) {
+      b.board = s;
+      b.boardIndex = i;
+      b.needsBoard = false;
+      continue;
+    }
+    const auto player = b.actor();
+    if (s == "f") {
+      b.folder = player;
+      b.isTerminal = true;
+      break;
+    }
+    const double highest = std::max(b.spent[0], b.spent[1]);
+    if (s == "r") {
+      b.spent[player] = highest + (b.round == 0 ? 2 : 4);
+      ++b.numRaisesThisRound;
+      ++b.numActionsThisRound;
+      continue;
+    }
+    b.spent[player] = highest;
+    if (b.numActionsThisRound++ == 0) {
+      continue;
+    }
+    if (++b.round == 2) {
+      b.isTerminal = true;
+      break;
+    }
+    b.numActionsThisRound = 0;
+    b.numRaisesThisRound = 0;
+    b.needsBoard = true;
+  }
+  return b;
+}
+
+/**
+ * Cards and boards are compared by rank alone.
+ */
+inline double utility(const BettingState& betting,
+                      const std::string& card0,
+                      const std::string& card1,
+                      size_t player) {
+  assert(betting.isTerminal);
+  if (betting.folder < 2) {
+    const auto folder = betting.folder;
+    return player == folder ? -betting.spent[folder] : betting.spent[folder];
+  }
+  const auto strength = [&betting](const std::string& card) {
+    return card[0] == betting.board[0] ? 3 : rank(card);
+  };
+  const auto s0 = strength(card0);
+  const auto s1 = strength(card1);
+  if (s0 == s1) {
+    return 0;
+  }
+  const bool player0Wins = s0 > s1;
+  return (player == 0) == player0Wins ? betting.spent[player]
+                                      : -betting.spent[player];
+}
+}
+}
+
+/**
+ * Three cards, J < Q < K, one dealt to each player. Each antes one and
+ * may bet one more, with pass (p) and bet (b) actions. Player 0's expected
+ * utility in equilibrium is -1/18.
+ */
+class KuhnPokerHistory : public Game::GameHistory<History::StringHistory> {
+ public:
+  KuhnPokerHistory()
+      : Game::GameHistory<StringHistory>(
+            std::vector<std::string>{"J", "Q", "K", "p", "b"}) {}
+  virtual ~KuhnPokerHistory() {}
+  virtual KuhnPokerHistory* clone() const override {
+    return new KuhnPokerHistory(*this);
+  }
+
+  virtual bool suffixIsLegal(
+      const std::string& candidateString) const override {
+    const bool isCard = candidateString.size() == 1 &&
+                        (candidateString == "J" || candidateString == "Q" ||
+                         candidateString == "K");
+    if (state_.size() < 2) {
+      return isCard && (isEmpty() || candidateString != state_[0]);
+    }
+    if (isCard || isTerminal()) {
+      return false;
+    }
+    return candidateString == "p" || candidateString == "b";
+  }
+  virtual size_t actor() const override {
+    return state_.size() < 2 ? Game::CHANCE : state_.size() % 2;
+  }
+
+  /**
+   * The actor's card and every action so far, like "K:pb".
+   */
+  virtual std::string informationSet() const override {
+    return state_[actor()] + ":" + actions();
+  }
+  virtual double utility(size_t player) const override {
+    assert(isTerminal());
+    return Detail::kuhnUtility(actions(), Detail::rank(state_[0]),
+                               Detail::rank(state_[1]), player);
+  }
+
+ protected:
+  std::string actions() const {
+    std::string a;
+    for (size_t i = 2; i < state_.size(); ++i) {
+      a += state_[i];
+    }
+    return a;
+  }
+  bool isTerminal() const { return Detail::kuhnIsTerminal(actions()); }
+};
+
+/**
+ * Kuhn poker's betting, with the deal carried as private states 0, 1, and
+ * 2 for J, Q, and K. Information set names match KuhnPokerHistory's.
+ */
+class KuhnPokerPublicHistory
+    : public Game::PublicGameHistory<History::StringHistory> {
+ public:
+  KuhnPokerPublicHistory()
+      : Game::PublicGameHistory<StringHistory>(
+            std::vector<std::string>{"p", "b"}) {}
+  virtual ~KuhnPokerPublicHistory() {}
+  virtual KuhnPokerPublicHistory* clone() const override {
+    return new KuhnPokerPublicHistory(*this);
+  }
+
+  virtual bool suffixIsLegal(const std::string&) const override {
+    return !Detail::kuhnIsTerminal(actions());
+  }
+  virtual size_t actor() const override { return state_.size() % 2; }
+  virtual size_t numPrivateStates(size_t) const override { return 3; }
+
+  virtual std::string informationSet(size_t privateState) const override {
+    static const char* cards[] = {"J", "Q", "K"};
+    return std::string(cards[privateState]) + ":" + actions();
+  }
+  virtual double chanceProbability(size_t privateState0,
+                                   size_t privateState1) const override {
+    return privateState0 == privateState1 ? 0.0 : 1.0 / 6;
+  }
+  virtual double utility(size_t player,
+                         size_t privateState0,
+                         size_t privateState1) const override {
+    assert(Detail::kuhnIsTerminal(actions()));
+    return Detail::kuhnUtility(actions(), privateState0, privateState1,
+                               player);
+  }
+
+ protected:
+  std::string actions() const {
+    std::string a;
+    for (const auto& s : state_) {
+      a += s;
+    }
+    return a;
+  }
+};
+
+/**
+ * Six cards, two each of J < Q < K. Each player antes one and is dealt a
+ * private card, then a betting round, a public board card, and a second
+ * betting round follow. Bets are two in the first round and four in the
+ * second, with at most two raises per round and fold (f), check or call
+ * (c), and bet or raise (r) actions. A card that pairs the board wins,
+ * then the higher card. Player 0's expected utility in equilibrium is about
+ * -0.0856.
+ */
+class LeducHoldemHistory : public Game::GameHistory<History::StringHistory> {
+ public:
+  LeducHoldemHistory()
+      : Game::GameHistory<StringHistory>(std::vector<std::string>{
+            "J0", "J1", "Q0", "Q1", "K0", "K1", "f", "c", "r"}) {}
+  virtual ~LeducHoldemHistory() {}
+  virtual LeducHoldemHistory* clone() const override {
+    return new LeducHoldemHistory(*this);
+  }
+
+  virtual bool suffixIsLegal(
+      const std::string& candidateString) const override {
+    const bool isCard = candidateString.size() == 2;
+    const auto betting = bettingState();
+    if (betting.isTerminal) {
+      return false;
+    }
+    if (state_.size() < 2 || betting.needsBoard) {
+      return isCard && std::find(state_.begin(), state_.end(),
+                                 candidateString) == state_.end();
+    }
+    return !isCard && betting.isLegal(candidateString);
+  }
+  virtual size_t actor() const override {
+    const auto betting = bettingState();
+    return (state_.size() < 2 || betting.needsBoard) ? Game::CHANCE
+                                                     : betting.actor();
+  }
+
+  /**
+   * The rank of the actor's card, then every action, with the board's rank
+   * between the rounds, like "K:rc/Q:c". Suits never matter, so hands that
+   * differ only in suit share information sets.
+   */
+  virtual std::string informationSet() const override {
+    std::string name = state_[actor()].substr(0, 1) + ":";
+    for (size_t i = 2; i < state_.size(); ++i) {
+      if (state_[i].size() == 2) {
+        name += "/" + state_[i].substr(0, 1) + ":";
+      } else {
+        name += state_[i];
+      }
+    }
+    return name;
+  }
+  virtual double utility(size_t player) const override {
+    return Detail::Leduc::utility(bettingState(), state_[0], state_[1],
+                                  player);
+  }
+
+ protected:
+  Detail::Leduc::BettingState bettingState() const {
+    return Detail::Leduc::bettingState(state_, 2);
+  }
+};
+
+/**
+ * Leduc hold'em's betting and board, with the deal carried as private
+ * states 0 through 5 for J0, J1, Q0, Q1, K0, and K1. The board is public,
+ * so it is dealt by rank alone, and information set names match
+ * LeducHoldemHistory's.
+ */
+class LeducHoldemPublicHistory
+    : public Game::PublicGameHistory<History::StringHistory> {
+ public:
+  LeducHoldemPublicHistory()
+      : Game::PublicGameHistory<StringHistory>(
+            std::vector<std::string>{"J", "Q", "K", "f", "c", "r"}) {}
+  virtual ~LeducHoldemPublicHistory() {}
+  virtual LeducHoldemPublicHistory* clone() const override {
+    return new LeducHoldemPublicHistory(*this);
+  }
+
+  virtual bool suffixIsLegal(
+      const std::string& candidateString) const override {
+    const bool isBoard = candidateString == "J" || candidateString == "Q" ||
+                         candidateString == "K";
+    const auto betting = bettingState();
+    if (betting.isTerminal) {
+      return false;
+    }
+    if (betting.needsBoard) {
+      return isBoard;
+    }
+    return !isBoard && betting.isLegal(candidateString);
+  }
+  virtual size_t actor() const override {
+    const auto betting = bettingState();
+    return betting.needsBoard ? Game::CHANCE : betting.actor();
+  }
+  virtual size_t numPrivateStates(size_t) const override { return 6; }
+
+  virtual std::string informationSet(size_t privateState) const override {
+    const auto boardIndex = bettingState().boardIndex;
+    std::string name = card(privateState).substr(0, 1) + ":";
+    for (size_t i = 0; i < state_.size(); ++i) {
+      if (i == boardIndex) {
+        name += "/" + state_[i] + ":";
+      } else {
+        name += state_[i];
+      }
+    }
+    return name;
+  }
+  virtual double chanceProbability(size_t privateState0,
+                                   size_t privateState1) const override {
+    if (privateState0 == privateState1) {
+      return 0.0;
+    }
+    const auto board = bettingState().board;
+    if (board.empty()) {
+      return 1.0 / 30;
+    }
+    const auto r = Detail::rank(board);
+    const size_t numLeft = 2 - (privateState0 / 2 == r) -
+                           (privateState1 / 2 == r);
+    return numLeft / (30.0 * 4);
+  }
+  virtual double utility(size_t player,
+                         size_t privateState0,
+                         size_t privateState1) const override {
+    return Detail::Leduc::utility(bettingState(), card(privateState0),
+                                  card(privateState1), player);
+  }
+
+ protected:
+  static std::string card(size_t privateState) {
+    static const char* cards[] = {"J0", "J1", "Q0", "Q1", "K0", "K1"};
+    return cards[privateState];
+  }
+  Detail::Leduc::BettingState bettingState() const {
+    return Detail::Leduc::bettingState(state_, 0);
+  }
+};
+}
+}
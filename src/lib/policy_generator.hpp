@@ -1,9 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <functional>
 #include <string>
 #include <vector>
 
+#include "instrumentation.hpp"
+#include "memory_accounting.hpp"
+#include "numa.hpp"
 #include "utils.hpp"
 
 namespace TreeAndHistoryTraversal {
@@ -12,7 +18,7 @@ namespace PolicyGenerator {
 template <typename InformationSet,
           typename Sequence,
           typename Value = double,
-          typename PolicyAtI = std::vector<double>>
+          typename PolicyAtI = std::vector<Value>>
 class PolicyGenerator {
  protected:
   PolicyGenerator() {}
@@ -22,47 +28,103 @@ class PolicyGenerator {
 
   virtual PolicyAtI policy(const InformationSet& I) const = 0;
   virtual void update(const Sequence& sequence, Value value) = 0;
+  /**
+   * Solvers announce each iteration before traversing so that randomized
+   * generators can key their draws on it rather than on call order.
+   */
+  virtual void setIteration(size_t) {}
   /**
    * Answers the question, "how many parameters does this generator require?"
    */
   virtual size_t complexity() const = 0;
+  /**
+   * Without a better account, each parameter is taken to be one Value.
+   */
+  virtual MemoryAccounting::Usage memoryUsage() const {
+    return MemoryAccounting::Usage(complexity() * sizeof(Value));
+  }
 };
 
 typedef double Numeric;
 
+/**
+ * Serves a fixed profile's policies in place of table's, and passes every
+ * update on to table multiplied by scale, as if it had been made that many
+ * times. Solvers warm start by running one iteration against the fixed
+ * profile through this. Does not own table.
+ */
+template <typename InformationSet,
+          typename Sequence,
+          typename Value = double,
+          typename PolicyAtI = std::vector<Value>>
+class WarmStartGenerator
+    : public PolicyGenerator<InformationSet, Sequence, Value, PolicyAtI> {
+ public:
+  WarmStartGenerator(
+      std::function<PolicyAtI(const InformationSet& I)> policyFn,
+      PolicyGenerator<InformationSet, Sequence, Value, PolicyAtI>* table,
+      Value scale)
+      : PolicyGenerator<InformationSet, Sequence, Value, PolicyAtI>(),
+        policyFn_(policyFn),
+        table_(table),
+        scale_(scale) {}
+  virtual ~WarmStartGenerator() {}
+
+  virtual PolicyAtI policy(const InformationSet& I) const override {
+    return policyFn_(I);
+  }
+  virtual void update(const Sequence& sequence, Value value) override {
+    table_->update(sequence, scale_ * value);
+  }
+  virtual void setIteration(size_t iteration) override {
+    table_->setIteration(iteration);
+  }
+  virtual size_t complexity() const override { return table_->complexity(); }
+  virtual MemoryAccounting::Usage memoryUsage() const override {
+    return MemoryAccounting::Usage(sizeof(*this));
+  }
+
+ protected:
+  std::function<PolicyAtI(const InformationSet& I)> policyFn_;
+  PolicyGenerator<InformationSet, Sequence, Value, PolicyAtI>* table_;
+  const Value scale_;
+};
+
+/**
+ * With PARTITIONED placement, the table's information sets are split
+ * across NUMA nodes as Numa::partitionInfoSets splits them, so threads
+ * pinned to a node should update that node's range.
+ */
+template <typename Numeric = double>
 class RegretMatchingTable
     : public PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric> {
  public:
-  RegretMatchingTable(size_t numSequences,
-                      const std::vector<size_t>& numActionsAtEachInfoSet,
-                      const std::vector<size_t>& numSequencesBeforeEachInfoSet)
-      : table_(numSequences, 0.0),
+  RegretMatchingTable(
+      size_t numSequences,
+      const std::vector<size_t>& numActionsAtEachInfoSet,
+      const std::vector<size_t>& numSequencesBeforeEachInfoSet,
+      Numa::Placement placement = Numa::Placement::DEFAULT)
+      : table_(numSequences,
+               0.0,
+               Numa::Allocator<Numeric>(Numa::layoutByInfoSet(
+                   placement, numSequencesBeforeEachInfoSet, numSequences))),
         numActionsAtEachInfoSet_(&numActionsAtEachInfoSet),
         numSequencesBeforeEachInfoSet_(&numSequencesBeforeEachInfoSet) {}
   virtual ~RegretMatchingTable() {}
 
   virtual std::vector<Numeric> policy(const size_t& I) const override {
-    Numeric sum = 0.0;
+    Instrumentation::countPolicyCall();
     const auto numActions = (*numActionsAtEachInfoSet_)[I];
     const auto baseIndex = (*numSequencesBeforeEachInfoSet_)[I];
 
     std::vector<Numeric> policy_(numActions);
-    for (size_t i = 0; i < numActions; ++i) {
-      sum += table_[baseIndex + i] > 0.0 ? table_[baseIndex + i] : 0.0;
-      policy_[i] = 1.0 / numActions;
-    }
-    if (sum > 0) {
-      for (size_t i = 0; i < numActions; ++i) {
-        policy_[i] =
-            table_[baseIndex + i] > 0.0 ? table_[baseIndex + i] / sum : 0.0;
-      }
-    }
-
+    Utils::normalize(&table_[baseIndex], numActions, policy_.data());
     return policy_;
   }
 
   virtual void update(const std::pair<size_t, size_t>& sequence,
                       Numeric regretValue) override {
+    Instrumentation::countUpdateCall();
     const auto infoSet = sequence.first;
     const auto action = sequence.second;
     const auto index = (*numSequencesBeforeEachInfoSet_)[infoSet] + action;
@@ -70,129 +132,163 @@ class RegretMatchingTable
   }
 
   virtual size_t complexity() const override { return table_.size(); };
+  virtual MemoryAccounting::Usage memoryUsage() const override {
+    return MemoryAccounting::Usage(sizeof(*this)) +
+           MemoryAccounting::ofContainer(table_);
+  }
 
  protected:
-  std::vector<Numeric> table_;
+  std::vector<Numeric, Numa::Allocator<Numeric>> table_;
   const std::vector<size_t>* numActionsAtEachInfoSet_;
   const std::vector<size_t>* numSequencesBeforeEachInfoSet_;
 };
 
-using AverageStrategyTable = RegretMatchingTable;
+template <typename Numeric = double>
+using AverageStrategyTable = RegretMatchingTable<Numeric>;
 
-class RegretMatchingPlusTable : public RegretMatchingTable {
+template <typename Numeric = double>
+class RegretMatchingPlusTable : public RegretMatchingTable<Numeric> {
  public:
   RegretMatchingPlusTable(
       size_t numSequences,
       const std::vector<size_t>& numActionsAtEachInfoSet,
-      const std::vector<size_t>& numSequencesBeforeEachInfoSet)
-      : RegretMatchingTable::RegretMatchingTable(
+      const std::vector<size_t>& numSequencesBeforeEachInfoSet,
+      Numa::Placement placement = Numa::Placement::DEFAULT)
+      : RegretMatchingTable<Numeric>::RegretMatchingTable(
             numSequences,
             numActionsAtEachInfoSet,
-            numSequencesBeforeEachInfoSet) {}
+            numSequencesBeforeEachInfoSet,
+            placement) {}
   virtual ~RegretMatchingPlusTable() {}
 
   virtual void update(const std::pair<size_t, size_t>& sequence,
                       Numeric regretValue) override {
+    Instrumentation::countUpdateCall();
     const auto infoSet = sequence.first;
     const auto action = sequence.second;
-    const auto index = (*numSequencesBeforeEachInfoSet_)[infoSet] + action;
-    if (table_[index] + regretValue > 0.0) {
-      table_[index] += regretValue;
+    const auto index =
+        (*this->numSequencesBeforeEachInfoSet_)[infoSet] + action;
+    if (this->table_[index] + regretValue > 0.0) {
+      this->table_[index] += regretValue;
     } else {
-      table_[index] = 0.0;
+      this->table_[index] = 0.0;
     }
   }
 };
 
-class PerturbedPolicyRegretMatchingTable : public RegretMatchingTable {
+template <typename Numeric = double>
+class PerturbedPolicyRegretMatchingTable : public RegretMatchingTable<Numeric> {
  public:
   PerturbedPolicyRegretMatchingTable(
       size_t numSequences,
       const std::vector<size_t>& numActionsAtEachInfoSet,
       const std::vector<size_t>& numSequencesBeforeEachInfoSet,
-      double noise,
+      Numeric noise,
       size_t randomSeed = 63547654)
-      : RegretMatchingTable::RegretMatchingTable(numSequences,
-                                                 numActionsAtEachInfoSet,
-                                                 numSequencesBeforeEachInfoSet),
-        randomEngine_(randomSeed),
+      : RegretMatchingTable<Numeric>::RegretMatchingTable(
+            numSequences,
+            numActionsAtEachInfoSet,
+            numSequencesBeforeEachInfoSet),
+        randomSeed_(randomSeed),
+        iteration_(0),
         noise_(noise),
         numRegretsSmallerThanNoise_(0) {}
   virtual ~PerturbedPolicyRegretMatchingTable() {}
 
+  /**
+   * The perturbation at I is a function of (seed, iteration, I) alone, so
+   * this may be called concurrently and repeated calls within an iteration
+   * agree.
+   */
   virtual std::vector<Numeric> policy(const size_t& I) const override {
-    Numeric sum = 0.0;
-    const auto numActions = (*numActionsAtEachInfoSet_)[I];
-    const auto baseIndex = (*numSequencesBeforeEachInfoSet_)[I];
+    Instrumentation::countPolicyCall();
+    const auto numActions = (*this->numActionsAtEachInfoSet_)[I];
+    const auto baseIndex = (*this->numSequencesBeforeEachInfoSet_)[I];
+    const Numeric* regrets = &this->table_[baseIndex];
 
-    std::vector<Numeric> perturbedRegrets(numActions);
+    size_t numSmallerThanNoise = 0;
     for (size_t i = 0; i < numActions; ++i) {
-      if (noise_ > std::abs(table_[baseIndex + i])) {
-        ++numRegretsSmallerThanNoise_;
+      if (noise_ > std::abs(regrets[i])) {
+        ++numSmallerThanNoise;
       }
-
-      const int noiseSign = Utils::flipCoin(0.5, &randomEngine_) ? 1 : -1;
-      perturbedRegrets[i] = table_[baseIndex + i] + noiseSign * noise_;
     }
+    numRegretsSmallerThanNoise_.fetch_add(numSmallerThanNoise,
+                                          std::memory_order_relaxed);
 
-    std::vector<Numeric> policy_(numActions);
-    for (size_t i = 0; i < numActions; ++i) {
-      sum += perturbedRegrets[i] > 0.0 ? perturbedRegrets[i] : 0.0;
-      policy_[i] = 1.0 / numActions;
-    }
-    if (sum > 0) {
-      for (size_t i = 0; i < numActions; ++i) {
-        policy_[i] =
-            perturbedRegrets[i] > 0.0 ? perturbedRegrets[i] / sum : 0.0;
-      }
-    }
+    std::vector<Numeric> noiseSigns(numActions);
+    Utils::randomSigns(randomSeed_, iteration_, I, numActions,
+                       noiseSigns.data());
+    std::vector<Numeric> perturbedRegrets(regrets, regrets + numActions);
+    Utils::axpy(noise_, noiseSigns.data(), numActions,
+                perturbedRegrets.data());
 
-    return policy_;
+    Utils::normalize(perturbedRegrets.data(), numActions,
+                     perturbedRegrets.data());
+    return perturbedRegrets;
+  }
+
+  virtual void setIteration(size_t iteration) override {
+    iteration_ = iteration;
   }
 
   virtual size_t complexity() const override {
-    return RegretMatchingTable::complexity() + 1;
+    return RegretMatchingTable<Numeric>::complexity() + 1;
   };
 
   size_t numRegretsSmallerThanNoise() const {
-    return numRegretsSmallerThanNoise_;
+    return numRegretsSmallerThanNoise_.load(std::memory_order_relaxed);
   }
 
   void clearnumRegretsSmallerThanNoise() { numRegretsSmallerThanNoise_ = 0; }
 
  protected:
-  mutable std::mt19937 randomEngine_;
-  const double noise_;
-  mutable size_t numRegretsSmallerThanNoise_;
+  const size_t randomSeed_;
+  size_t iteration_;
+  const Numeric noise_;
+  mutable std::atomic<size_t> numRegretsSmallerThanNoise_;
 };
 
-class PerturbedTableRegretMatchingTable : public RegretMatchingTable {
+template <typename Numeric = double>
+class PerturbedTableRegretMatchingTable : public RegretMatchingTable<Numeric> {
  public:
   PerturbedTableRegretMatchingTable(
       size_t numSequences,
       const std::vector<size_t>& numActionsAtEachInfoSet,
       const std::vector<size_t>& numSequencesBeforeEachInfoSet,
-      double noise)
-      : RegretMatchingTable::RegretMatchingTable(numSequences,
-                                                 numActionsAtEachInfoSet,
-                                                 numSequencesBeforeEachInfoSet),
-        randomEngine_(63547654),
+      Numeric noise,
+      size_t randomSeed = 63547654)
+      : RegretMatchingTable<Numeric>::RegretMatchingTable(
+            numSequences,
+            numActionsAtEachInfoSet,
+            numSequencesBeforeEachInfoSet),
+        randomSeed_(randomSeed),
+        iteration_(0),
         noise_(noise) {}
   virtual ~PerturbedTableRegretMatchingTable() {}
 
   virtual void update(const std::pair<size_t, size_t>& sequence,
                       Numeric regretValue) override {
-    const int noiseSign = Utils::flipCoin(0.5, &randomEngine_) ? 1 : -1;
-    RegretMatchingTable::update(sequence, regretValue + noiseSign * noise_);
+    const auto index =
+        (*this->numSequencesBeforeEachInfoSet_)[sequence.first] +
+        sequence.second;
+    Numeric noiseSign;
+    Utils::randomSigns(randomSeed_, iteration_, index, 1, &noiseSign);
+    RegretMatchingTable<Numeric>::update(sequence,
+                                         regretValue + noiseSign * noise_);
+  }
+
+  virtual void setIteration(size_t iteration) override {
+    iteration_ = iteration;
   }
 
   virtual size_t complexity() const override {
-    return RegretMatchingTable::complexity() + 1;
+    return RegretMatchingTable<Numeric>::complexity() + 1;
   };
 
  protected:
-  mutable std::mt19937 randomEngine_;
-  const double noise_;
+  const size_t randomSeed_;
+  size_t iteration_;
+  const Numeric noise_;
 };
 }
 }
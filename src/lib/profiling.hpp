@@ -0,0 +1,195 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Hardware performance counters around solver calls, read through Linux's
+ * perf_event_open.
+ *
+ * Where counters cannot be opened (not Linux, no PMU in the VM, or
+ * perf_event_paranoid forbids it), a Profiler still measures wall-clock
+ * time and reports hasHardwareCounters() == false.
+ */
+namespace Profiling {
+struct Sample {
+  size_t numCalls;
+  double seconds;
+  bool hasHardwareCounters;
+  uint64_t cycles;
+  uint64_t instructions;
+  uint64_t cacheMisses;
+  uint64_t branchMisses;
+
+  Sample()
+      : numCalls(0),
+        seconds(0.0),
+        hasHardwareCounters(false),
+        cycles(0),
+        instructions(0),
+        cacheMisses(0),
+        branchMisses(0) {}
+
+  Sample& operator+=(const Sample& other) {
+    numCalls += other.numCalls;
+    seconds += other.seconds;
+    hasHardwareCounters = hasHardwareCounters || other.hasHardwareCounters;
+    cycles += other.cycles;
+    instructions += other.instructions;
+    cacheMisses += other.cacheMisses;
+    branchMisses += other.branchMisses;
+    return *this;
+  }
+
+  double perCall(double count) const {
+    return numCalls > 0 ? count / numCalls : 0.0;
+  }
+  double instructionsPerCycle() const {
+    return cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0;
+  }
+};
+
+/**
+ * Counts the calling thread only; work done on other threads, like
+ * concurrent BestResponse traversals, shows up in wall-clock time alone.
+ *
+ * start() and stop() each make a system call, so to profile something much
+ * cheaper than a microsecond, wrap a block of calls rather than each one.
+ */
+class Profiler {
+ public:
+  Profiler() : numCounters_(0) {
+    for (size_t i = 0; i < NUM_EVENTS; ++i) {
+      fds_[i] = -1;
+    }
+    openCounters();
+  }
+  ~Profiler() { closeCounters(); }
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  bool hasHardwareCounters() const { return numCounters_ == NUM_EVENTS; }
+
+  void start() {
+#ifdef __linux__
+    if (hasHardwareCounters()) {
+      ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+    start_ = Clock::now();
+  }
+
+  /**
+   * Returns the sample since the last start() and adds it to total().
+   */
+  Sample stop() {
+    const auto end = Clock::now();
+    Sample sample;
+    sample.numCalls = 1;
+    sample.seconds = std::chrono::duration<double>(end - start_).count();
+#ifdef __linux__
+    if (hasHardwareCounters()) {
+      ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+      readCounters(&sample);
+    }
+#endif
+    total_ += sample;
+    return sample;
+  }
+
+  template <typename F>
+  Sample measure(F&& f) {
+    start();
+    f();
+    return stop();
+  }
+
+  const Sample& total() const { return total_; }
+  void clearTotal() { total_ = Sample(); }
+
+ protected:
+  typedef std::chrono::steady_clock Clock;
+  static const size_t NUM_EVENTS = 4;
+
+  void openCounters() {
+#ifdef __linux__
+    static const uint64_t events[NUM_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (size_t i = 0; i < NUM_EVENTS; ++i) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = events[i];
+      attr.disabled = (i == 0);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      fds_[i] = static_cast<int>(
+          syscall(__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0],
+                  0));
+      if (fds_[i] < 0) {
+        closeCounters();
+        return;
+      }
+      ++numCounters_;
+    }
+#endif
+  }
+
+  void closeCounters() {
+#ifdef __linux__
+    for (size_t i = 0; i < NUM_EVENTS; ++i) {
+      if (fds_[i] >= 0) {
+        close(fds_[i]);
+        fds_[i] = -1;
+      }
+    }
+#endif
+    numCounters_ = 0;
+  }
+
+#ifdef __linux__
+  void readCounters(Sample* sample) const {
+    struct {
+      uint64_t nr;
+      uint64_t timeEnabled;
+      uint64_t timeRunning;
+      uint64_t values[NUM_EVENTS];
+    } group;
+    if (read(fds_[0], &group, sizeof(group)) !=
+            static_cast<ssize_t>(sizeof(group)) ||
+        group.nr != NUM_EVENTS || group.timeRunning == 0) {
+      return;
+    }
+    // Scale up if the kernel multiplexed the group with other events.
+    const double scale =
+        static_cast<double>(group.timeEnabled) / group.timeRunning;
+    sample->hasHardwareCounters = true;
+    sample->cycles = static_cast<uint64_t>(group.values[0] * scale);
+    sample->instructions = static_cast<uint64_t>(group.values[1] * scale);
+    sample->cacheMisses = static_cast<uint64_t>(group.values[2] * scale);
+    sample->branchMisses = static_cast<uint64_t>(group.values[3] * scale);
+  }
+#endif
+
+  int fds_[NUM_EVENTS];
+  size_t numCounters_;
+  Clock::time_point start_;
+  Sample total_;
+};
+}
+}
@@ -0,0 +1,959 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "depth_limit.hpp"
+#include "game_history.hpp"
+#include "policy_generator.hpp"
+#include "serving.hpp"
+#include "utils.hpp"
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Games compiled into flat arrays, and solvers that run on them without
+ * walking a History.
+ */
+namespace SequenceForm {
+/**
+ * Nodes are numbered in preorder, so every node's descendants follow it.
+ * Information sets and sequences are numbered separately for each player,
+ * in the layout that the regret matching tables expect.
+ */
+struct CompiledGame {
+  enum : size_t { TERMINAL = SIZE_MAX, CHANCE = Game::CHANCE };
+
+  size_t numPlayers;
+
+  // By node: the acting player, CHANCE, or TERMINAL
+  std::vector<size_t> actor;
+  // By node: the actor's information set, or at terminals, the terminal's
+  // index into utilities. Unused at chance nodes.
+  std::vector<size_t> infoSet;
+  // By node, plus one past the last: where its children start in children,
+  // in legal action order. Node n's children end where node n + 1's begin.
+  std::vector<size_t> childrenBegin;
+  std::vector<size_t> children;
+  // Parallel to children: the probability of each chance outcome, or zero
+  // below player nodes
+  std::vector<double> chanceProbabilities;
+
+  // By terminal, then player
+  std::vector<double> utilities;
+
+  // By player, then information set
+  std::vector<std::vector<std::string>> infoSetNames;
+  std::vector<std::vector<size_t>> numActionsAtEachInfoSet;
+  std::vector<std::vector<size_t>> numSequencesBeforeEachInfoSet;
+
+  size_t numNodes() const { return actor.size(); }
+  bool isTerminal(size_t node) const { return actor[node] == TERMINAL; }
+  bool isChance(size_t node) const { return actor[node] == CHANCE; }
+  size_t numChildren(size_t node) const {
+    return childrenBegin[node + 1] - childrenBegin[node];
+  }
+  size_t child(size_t node, size_t action) const {
+    return children[childrenBegin[node] + action];
+  }
+  double chanceProbability(size_t node, size_t outcome) const {
+    assert(isChance(node));
+    return chanceProbabilities[childrenBegin[node] + outcome];
+  }
+  double utility(size_t node, size_t player) const {
+    assert(isTerminal(node));
+    return utilities[infoSet[node] * numPlayers + player];
+  }
+
+  size_t numInfoSets(size_t player) const {
+    return numActionsAtEachInfoSet[player].size();
+  }
+  size_t numSequences(size_t player) const {
+    return numInfoSets(player) == 0
+               ? 0
+               : numSequencesBeforeEachInfoSet[player].back() +
+                     numActionsAtEachInfoSet[player].back();
+  }
+
+  bool operator==(const CompiledGame& other) const {
+    return numPlayers == other.numPlayers && actor == other.actor &&
+           infoSet == other.infoSet && childrenBegin == other.childrenBegin &&
+           children == other.children &&
+           chanceProbabilities == other.chanceProbabilities &&
+           utilities == other.utilities &&
+           infoSetNames == other.infoSetNames &&
+           numActionsAtEachInfoSet == other.numActionsAtEachInfoSet &&
+           numSequencesBeforeEachInfoSet ==
+               other.numSequencesBeforeEachInfoSet;
+  }
+
+  /**
+   * Writes a binary image in host byte order.
+   */
+  void save(std::ostream& out) const;
+  /**
+   * Reads an image written by save, throwing std::runtime_error if it is
+   * truncated or its structure is inconsistent.
+   */
+  static CompiledGame load(std::istream& in);
+};
+
+namespace Detail {
+const char MAGIC[8] = {'T', 'A', 'H', 'T', 'S', 'F', 'G', '2'};
+
+inline void write(std::ostream& out, uint64_t x) {
+  out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+inline void write(std::ostream& out, const std::vector<size_t>& v) {
+  write(out, v.size());
+  for (auto x : v) {
+    write(out, x);
+  }
+}
+inline void write(std::ostream& out, const std::vector<double>& v) {
+  write(out, v.size());
+  out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(double));
+}
+inline void write(std::ostream& out, const std::string& s) {
+  write(out, s.size());
+  out.write(s.data(), s.size());
+}
+
+inline uint64_t readUint64(std::istream& in) {
+  uint64_t x;
+  if (!in.read(reinterpret_cast<char*>(&x), sizeof(x))) {
+    throw std::runtime_error("Truncated compiled game");
+  }
+  return x;
+}
+// Lengths come from the image, so vectors grow as their elements arrive
+// rather than being allocated up front: a corrupt length fails as a
+// truncated read instead of an enormous allocation.
+const uint64_t MAX_READ_AHEAD = 1 << 16;
+
+inline std::vector<size_t> readSizes(std::istream& in) {
+  const auto n = readUint64(in);
+  std::vector<size_t> v;
+  v.reserve(std::min(n, MAX_READ_AHEAD));
+  for (uint64_t i = 0; i < n; ++i) {
+    v.push_back(readUint64(in));
+  }
+  return v;
+}
+inline std::vector<double> readDoubles(std::istream& in) {
+  const auto n = readUint64(in);
+  std::vector<double> v;
+  while (v.size() < n) {
+    const auto begin = v.size();
+    v.resize(begin + std::min(n - begin, MAX_READ_AHEAD));
+    if (!in.read(reinterpret_cast<char*>(&v[begin]),
+                 (v.size() - begin) * sizeof(double))) {
+      throw std::runtime_error("Truncated compiled game");
+    }
+  }
+  return v;
+}
+inline std::string readString(std::istream& in) {
+  const auto n = readUint64(in);
+  std::string s;
+  while (s.size() < n) {
+    const auto begin = s.size();
+    s.resize(begin + std::min(n - begin, MAX_READ_AHEAD));
+    if (!in.read(&s[begin], s.size() - begin)) {
+      throw std::runtime_error("Truncated compiled game");
+    }
+  }
+  return s;
+}
+
+/**
+ * Throws unless game has a root, every index in game is in range, chance
+ * probabilities are finite and non-negative, and the per-player
+ * information set arrays agree, so that traversals of a loaded game can
+ * trust its structure as they do a compiled one.
+ */
+inline void checkStructure(const CompiledGame& game) {
+  const auto corrupt = []() {
+    throw std::runtime_error("Corrupt compiled game");
+  };
+  const auto numNodes = game.numNodes();
+  // Traversals start by reading the root
+  if (numNodes == 0 || game.numPlayers == 0 ||
+      game.utilities.size() % game.numPlayers != 0 ||
+      game.infoSet.size() != numNodes ||
+      game.childrenBegin.size() != numNodes + 1 ||
+      game.childrenBegin.front() != 0 ||
+      game.childrenBegin.back() != game.children.size() ||
+      game.chanceProbabilities.size() != game.children.size() ||
+      game.infoSetNames.size() != game.numPlayers ||
+      game.numActionsAtEachInfoSet.size() != game.numPlayers ||
+      game.numSequencesBeforeEachInfoSet.size() != game.numPlayers) {
+    corrupt();
+  }
+  for (size_t player = 0; player < game.numPlayers; ++player) {
+    const auto& numActions = game.numActionsAtEachInfoSet[player];
+    const auto& numSequencesBefore =
+        game.numSequencesBeforeEachInfoSet[player];
+    if (game.infoSetNames[player].size() != numActions.size() ||
+        numSequencesBefore.size() != numActions.size()) {
+      corrupt();
+    }
+    size_t numSequences = 0;
+    for (size_t I = 0; I < numActions.size(); ++I) {
+      if (numSequencesBefore[I] != numSequences) {
+        corrupt();
+      }
+      numSequences += numActions[I];
+    }
+  }
+  const auto numTerminals = game.utilities.size() / game.numPlayers;
+  for (size_t node = 0; node < numNodes; ++node) {
+    if (game.childrenBegin[node] > game.childrenBegin[node + 1]) {
+      corrupt();
+    }
+    const auto numChildren = game.numChildren(node);
+    const auto actor = game.actor[node];
+    if (actor == CompiledGame::TERMINAL) {
+      if (numChildren != 0 || game.infoSet[node] >= numTerminals) {
+        corrupt();
+      }
+    } else if (actor < game.numPlayers) {
+      if (game.infoSet[node] >= game.numInfoSets(actor) ||
+          numChildren !=
+              game.numActionsAtEachInfoSet[actor][game.infoSet[node]]) {
+        corrupt();
+      }
+    } else if (actor == CompiledGame::CHANCE) {
+      for (size_t a = 0; a < numChildren; ++a) {
+        const auto p = game.chanceProbability(node, a);
+        if (!std::isfinite(p) || p < 0.0) {
+          corrupt();
+        }
+      }
+    } else {
+      corrupt();
+    }
+    // Preorder numbering puts children after their parents, which also
+    // rules out cycles.
+    for (size_t a = 0; a < numChildren; ++a) {
+      const auto child = game.child(node, a);
+      if (child <= node || child >= numNodes) {
+        corrupt();
+      }
+    }
+  }
+}
+
+template <typename HistoryType>
+class Compiler {
+ public:
+  Compiler(Game::GameHistory<HistoryType>* root) : history_(root) {
+    const auto numPlayers = root->numPlayers();
+    game_.numPlayers = numPlayers;
+    game_.infoSetNames.resize(numPlayers);
+    game_.numActionsAtEachInfoSet.resize(numPlayers);
+    game_.numSequencesBeforeEachInfoSet.resize(numPlayers);
+    infoSetIndices_.resize(numPlayers);
+    visit();
+    game_.childrenBegin.push_back(game_.children.size());
+  }
+
+  CompiledGame& game() { return game_; }
+
+ protected:
+  void visit() {
+    game_.childrenBegin.push_back(game_.children.size());
+    if (!history_->hasSuccessors()) {
+      game_.actor.push_back(CompiledGame::TERMINAL);
+      game_.infoSet.push_back(game_.utilities.size() / game_.numPlayers);
+      for (size_t player = 0; player < game_.numPlayers; ++player) {
+        game_.utilities.push_back(history_->utility(player));
+      }
+      return;
+    }
+    const auto player = history_->actor();
+    const auto numActions = history_->numSuccessors();
+    const auto childrenBegin = game_.children.size();
+    // Reserve the children's slots so that they stay contiguous while the
+    // subtrees below append their own.
+    game_.children.resize(childrenBegin + numActions);
+    game_.chanceProbabilities.resize(childrenBegin + numActions, 0.0);
+    game_.actor.push_back(player);
+    if (player == Game::CHANCE) {
+      game_.infoSet.push_back(0);
+      for (size_t a = 0; a < numActions; ++a) {
+        game_.chanceProbabilities[childrenBegin + a] =
+            history_->chanceProbability(a);
+      }
+    } else if (player < game_.numPlayers) {
+      game_.infoSet.push_back(
+          infoSetIndex(player, history_->informationSet(), numActions));
+    } else {
+      throw std::runtime_error("Actor out of range");
+    }
+
+    history_->eachSuccessor([&](size_t, size_t legalSuffixIndex) {
+      game_.children[childrenBegin + legalSuffixIndex] = game_.numNodes();
+      visit();
+      return false;
+    });
+  }
+
+  size_t infoSetIndex(size_t player,
+                      const std::string& name,
+                      size_t numActions) {
+    auto& numActionsAtEachInfoSet = game_.numActionsAtEachInfoSet[player];
+    const auto found = infoSetIndices_[player].find(name);
+    if (found != infoSetIndices_[player].end()) {
+      if (numActionsAtEachInfoSet[found->second] != numActions) {
+        throw std::runtime_error("Information set, \"" + name +
+                                 "\", has histories with different numbers "
+                                 "of actions");
+      }
+      return found->second;
+    }
+    const auto I = numActionsAtEachInfoSet.size();
+    auto& numSequencesBefore = game_.numSequencesBeforeEachInfoSet[player];
+    numSequencesBefore.push_back(
+        I == 0 ? 0
+               : numSequencesBefore.back() + numActionsAtEachInfoSet.back());
+    numActionsAtEachInfoSet.push_back(numActions);
+    game_.infoSetNames[player].push_back(name);
+    infoSetIndices_[player].emplace(name, I);
+    return I;
+  }
+
+  Game::GameHistory<HistoryType>* history_;
+  CompiledGame game_;
+  std::vector<std::unordered_map<std::string, size_t>> infoSetIndices_;
+};
+}
+
+inline void CompiledGame::save(std::ostream& out) const {
+  out.write(Detail::MAGIC, sizeof(Detail::MAGIC));
+  Detail::write(out, numPlayers);
+  Detail::write(out, actor);
+  Detail::write(out, infoSet);
+  Detail::write(out, childrenBegin);
+  Detail::write(out, children);
+  Detail::write(out, chanceProbabilities);
+  Detail::write(out, utilities);
+  for (size_t player = 0; player < numPlayers; ++player) {
+    Detail::write(out, infoSetNames[player].size());
+    for (const auto& name : infoSetNames[player]) {
+      Detail::write(out, name);
+    }
+    Detail::write(out, numActionsAtEachInfoSet[player]);
+    Detail::write(out, numSequencesBeforeEachInfoSet[player]);
+  }
+}
+
+inline CompiledGame CompiledGame::load(std::istream& in) {
+  char magic[sizeof(Detail::MAGIC)];
+  if (!in.read(magic, sizeof(magic)) ||
+      memcmp(magic, Detail::MAGIC, sizeof(magic)) != 0) {
+    throw std::runtime_error("Not a compiled game");
+  }
+  CompiledGame game;
+  game.numPlayers = Detail::readUint64(in);
+  game.actor = Detail::readSizes(in);
+  game.infoSet = Detail::readSizes(in);
+  game.childrenBegin = Detail::readSizes(in);
+  game.children = Detail::readSizes(in);
+  game.chanceProbabilities = Detail::readDoubles(in);
+  game.utilities = Detail::readDoubles(in);
+  for (size_t player = 0; player < game.numPlayers; ++player) {
+    game.infoSetNames.emplace_back();
+    const auto numInfoSets = Detail::readUint64(in);
+    for (uint64_t I = 0; I < numInfoSets; ++I) {
+      game.infoSetNames[player].push_back(Detail::readString(in));
+    }
+    game.numActionsAtEachInfoSet.push_back(Detail::readSizes(in));
+    game.numSequencesBeforeEachInfoSet.push_back(Detail::readSizes(in));
+  }
+  Detail::checkStructure(game);
+  return game;
+}
+
+/**
+ * Walks every history below root once. root is restored before returning.
+ */
+template <typename HistoryType>
+CompiledGame compile(Game::GameHistory<HistoryType>* root) {
+  return std::move(Detail::Compiler<HistoryType>(root).game());
+}
+
+namespace Detail {
+template <typename Numeric>
+void addExpectedUtilities(const CompiledGame& game,
+                          const std::vector<std::vector<Numeric>>& profile,
+                          size_t node,
+                          Numeric reachProb,
+                          std::vector<Numeric>* values) {
+  if (game.isTerminal(node)) {
+    for (size_t player = 0; player < game.numPlayers; ++player) {
+      (*values)[player] += reachProb * game.utility(node, player);
+    }
+    return;
+  }
+  const auto actor = game.actor[node];
+  const Numeric* sigma_I = nullptr;
+  if (!game.isChance(node)) {
+    const auto I = game.infoSet[node];
+    sigma_I = &profile[actor][game.numSequencesBeforeEachInfoSet[actor][I]];
+  }
+  for (size_t a = 0; a < game.numChildren(node); ++a) {
+    const Numeric prob =
+        sigma_I ? sigma_I[a] : Numeric(game.chanceProbability(node, a));
+    if (prob > 0) {
+      addExpectedUtilities(game, profile, game.child(node, a),
+                           reachProb * prob, values);
+    }
+  }
+}
+}
+
+/**
+ * Each player's expected utility when everyone plays profile, laid out as
+ * in BestResponse.
+ */
+template <typename Numeric>
+std::vector<Numeric> expectedUtilities(
+    const CompiledGame& game,
+    const std::vector<std::vector<Numeric>>& profile) {
+  std::vector<Numeric> values(game.numPlayers, 0.0);
+  Detail::addExpectedUtilities<Numeric>(game, profile, 0, 1.0, &values);
+  return values;
+}
+
+/**
+ * Estimates the value of a node for every player, in place of the subtree
+ * below it.
+ */
+typedef DepthLimit::LeafEstimator<size_t, std::vector<double>> Estimator;
+
+/**
+ * Each player's expected utility below every node once it is reached, when
+ * everyone plays profile. Suitable for a DepthLimit::TableEstimator.
+ */
+template <typename Numeric>
+std::vector<std::vector<double>> nodeValues(
+    const CompiledGame& game,
+    const std::vector<std::vector<Numeric>>& profile) {
+  std::vector<std::vector<double>> values(
+      game.numNodes(), std::vector<double>(game.numPlayers, 0.0));
+  // Children follow their parents, so a reverse pass sees them first.
+  for (size_t node = game.numNodes(); node-- > 0;) {
+    if (game.isTerminal(node)) {
+      for (size_t player = 0; player < game.numPlayers; ++player) {
+        values[node][player] = game.utility(node, player);
+      }
+      continue;
+    }
+    const auto actor = game.actor[node];
+    const Numeric* sigma_I = nullptr;
+    if (!game.isChance(node)) {
+      sigma_I = &profile[actor][
+          game.numSequencesBeforeEachInfoSet[actor][game.infoSet[node]]];
+    }
+    for (size_t a = 0; a < game.numChildren(node); ++a) {
+      const double prob =
+          sigma_I ? sigma_I[a] : game.chanceProbability(node, a);
+      Utils::axpy(prob, values[game.child(node, a)].data(), game.numPlayers,
+                  values[node].data());
+    }
+  }
+  return values;
+}
+
+namespace Detail {
+inline void checkLimits(const DepthLimit::Limits& limits,
+                        const Estimator* estimator) {
+  if (!limits.isUnlimited() && !estimator) {
+    throw std::invalid_argument("Limited traversals need an estimator");
+  }
+}
+}
+
+/**
+ * Best responses to a profile given as each player's probability of every
+ * one of its sequences, laid out as in CompiledGame.
+ *
+ * Under limits, nodes where they are reached take estimator's values, so
+ * the responder only chooses above them and the result is a best response
+ * to the profile together with whatever continuation the estimates assume.
+ * estimator must outlive this object.
+ */
+template <typename Numeric = Utils::Numeric>
+class BestResponse {
+ public:
+  BestResponse(const CompiledGame& game,
+               const std::vector<std::vector<Numeric>>& stratProfile,
+               const DepthLimit::Limits& limits = DepthLimit::Limits(),
+               const Estimator* estimator = nullptr)
+      : game_(&game),
+        strategyProfile_(&stratProfile),
+        limits_(limits),
+        estimator_(estimator) {
+    Detail::checkLimits(limits_, estimator_);
+  }
+  virtual ~BestResponse() {}
+
+  virtual std::vector<Numeric> valueProfile() const {
+    std::vector<Numeric> brValues(game_->numPlayers);
+    for (size_t i = 0; i < game_->numPlayers; ++i) {
+      std::vector<size_t> choices;
+      brValues[i] = bestResponse(i, &choices);
+    }
+    return brValues;
+  }
+
+  virtual Numeric averageExploitability() const {
+    const auto brValues = valueProfile();
+    return Utils::sum(brValues.data(), brValues.size()) / brValues.size();
+  }
+
+  /**
+   * Each player's pure best response, in the same layout as the profile.
+   */
+  virtual std::vector<std::vector<Numeric>> strategyProfile() const {
+    std::vector<std::vector<Numeric>> brProfile(game_->numPlayers);
+    for (size_t i = 0; i < game_->numPlayers; ++i) {
+      std::vector<size_t> choices;
+      bestResponse(i, &choices);
+      brProfile[i].assign(game_->numSequences(i), 0.0);
+      for (size_t I = 0; I < choices.size(); ++I) {
+        brProfile[i][game_->numSequencesBeforeEachInfoSet[i][I] +
+                     choices[I]] = 1.0;
+      }
+    }
+    return brProfile;
+  }
+
+ protected:
+  /**
+   * Information sets are resolved from the responder's last decisions to
+   * its first. Each pass over the tree fixes the choices at one depth, given
+   * those below it, so this takes as many linear passes as the responder
+   * has decisions on its longest path, plus one.
+   */
+  Numeric bestResponse(size_t i, std::vector<size_t>* choices) const {
+    const auto& game = *game_;
+    const auto numNodes = game.numNodes();
+    std::vector<Numeric> opponentReach(numNodes, 0.0);
+    std::vector<size_t> depth(numNodes, 0);
+    std::vector<size_t> infoSetDepth(game.numInfoSets(i), 0);
+    size_t maxDepth = 0;
+    opponentReach[0] = 1.0;
+    // Under limits: which nodes are reached, the depth of each in the tree,
+    // and the estimated value of each leaf
+    const bool limited = !limits_.isUnlimited();
+    std::vector<char> reached(limited ? numNodes : 0, 0);
+    std::vector<size_t> treeDepth(limited ? numNodes : 0, 0);
+    std::unordered_map<size_t, Numeric> leafValues;
+    size_t numNodesVisited = 0;
+    if (limited) {
+      reached[0] = 1;
+    }
+    for (size_t node = 0; node < numNodes; ++node) {
+      if (limited) {
+        if (!reached[node]) {
+          continue;
+        }
+        const bool isLeaf = !game.isTerminal(node) &&
+                            limits_.reached(treeDepth[node], numNodesVisited);
+        ++numNodesVisited;
+        if (isLeaf) {
+          leafValues.emplace(
+              node, opponentReach[node] * estimator_->estimate(node, i));
+          continue;
+        }
+        for (size_t a = 0; a < game.numChildren(node); ++a) {
+          reached[game.child(node, a)] = 1;
+          treeDepth[game.child(node, a)] = treeDepth[node] + 1;
+        }
+      }
+      if (game.isTerminal(node)) {
+        continue;
+      }
+      const auto actor = game.actor[node];
+      if (game.isChance(node)) {
+        for (size_t a = 0; a < game.numChildren(node); ++a) {
+          const auto child = game.child(node, a);
+          opponentReach[child] =
+              opponentReach[node] * game.chanceProbability(node, a);
+          depth[child] = depth[node];
+        }
+        continue;
+      }
+      const auto I = game.infoSet[node];
+      const auto* sigma_I = &(*strategyProfile_)[actor][
+          game.numSequencesBeforeEachInfoSet[actor][I]];
+      if (actor == i) {
+        infoSetDepth[I] = depth[node];
+        maxDepth = std::max(maxDepth, depth[node]);
+      }
+      for (size_t a = 0; a < game.numChildren(node); ++a) {
+        const auto child = game.child(node, a);
+        opponentReach[child] =
+            opponentReach[node] * (actor == i ? 1.0 : sigma_I[a]);
+        depth[child] = depth[node] + (actor == i);
+      }
+    }
+
+    choices->assign(game.numInfoSets(i), 0);
+    std::vector<Numeric> values(numNodes, 0.0);
+    std::vector<std::vector<Numeric>> actionTotals(game.numInfoSets(i));
+    for (size_t pass = 0; pass <= maxDepth + 1; ++pass) {
+      // The depth resolved on this pass. The last pass resolves nothing and
+      // only computes the root's value from the final choices.
+      const size_t resolving = pass <= maxDepth ? maxDepth - pass : SIZE_MAX;
+      for (size_t I = 0; I < actionTotals.size(); ++I) {
+        actionTotals[I].assign(game.numActionsAtEachInfoSet[i][I], 0.0);
+      }
+      for (size_t node = numNodes; node-- > 0;) {
+        if (limited) {
+          if (!reached[node]) {
+            continue;
+          }
+          const auto leaf = leafValues.find(node);
+          if (leaf != leafValues.end()) {
+            values[node] = leaf->second;
+            continue;
+          }
+        }
+        if (game.isTerminal(node)) {
+          values[node] = opponentReach[node] * game.utility(node, i);
+          continue;
+        }
+        if (game.actor[node] != i) {
+          values[node] = 0.0;
+          for (size_t a = 0; a < game.numChildren(node); ++a) {
+            values[node] += values[game.child(node, a)];
+          }
+          continue;
+        }
+        const auto I = game.infoSet[node];
+        if (infoSetDepth[I] == resolving) {
+          for (size_t a = 0; a < game.numChildren(node); ++a) {
+            actionTotals[I][a] += values[game.child(node, a)];
+          }
+        }
+        values[node] = values[game.child(node, (*choices)[I])];
+      }
+      for (size_t I = 0; I < actionTotals.size(); ++I) {
+        if (infoSetDepth[I] == resolving) {
+          (*choices)[I] =
+              Utils::argmax(actionTotals[I].data(), actionTotals[I].size());
+        }
+      }
+    }
+    return values[0];
+  }
+
+  const CompiledGame* game_;
+  const std::vector<std::vector<Numeric>>* strategyProfile_;
+  const DepthLimit::Limits limits_;
+  const Estimator* estimator_;
+};
+
+/**
+ * Vanilla CFR over a compiled game. Every iteration updates each player in
+ * turn, with the current strategy at every information set fixed before
+ * each player's traversal.
+ *
+ * Under limits, each traversal values nodes where they are reached with
+ * estimator instead of expanding them, so information sets below those
+ * nodes are never updated. Every player traversal has its own node budget.
+ * estimator must outlive this object.
+ */
+template <typename Numeric = Utils::Numeric>
+class Cfr {
+ public:
+  typedef PolicyGenerator::PolicyGenerator<size_t,
+                                           std::pair<size_t, size_t>,
+                                           Numeric>
+      Generator;
+
+  Cfr(const CompiledGame& game,
+      std::vector<Generator*>&& policyGeneratorProfile,
+      std::vector<Generator*>&& averageGeneratorProfile,
+      const DepthLimit::Limits& limits = DepthLimit::Limits(),
+      const Estimator* estimator = nullptr)
+      : game_(&game),
+        policyGeneratorProfile_(std::move(policyGeneratorProfile)),
+        cumulativeAverageStrategyProfile_(std::move(averageGeneratorProfile)),
+        currentProfile_(game.numPlayers),
+        averageStrategyProfile_(game.numPlayers),
+        reachProbs_(game.numPlayers + 1, 1.0),
+        t_(0),
+        limits_(limits),
+        estimator_(estimator),
+        numNodesVisited_(0),
+        scratchBytes_(0),
+        peakScratchBytes_(0) {
+    Detail::checkLimits(limits_, estimator_);
+    for (size_t player = 0; player < game.numPlayers; ++player) {
+      currentProfile_[player].resize(game.numSequences(player));
+    }
+  }
+  Cfr(const Cfr&) = delete;
+  Cfr& operator=(const Cfr&) = delete;
+  virtual ~Cfr() {
+    for (auto& policyGenerator : policyGeneratorProfile_) {
+      if (policyGenerator) {
+        delete policyGenerator;
+      }
+    }
+    for (auto& policyGenerator : cumulativeAverageStrategyProfile_) {
+      if (policyGenerator) {
+        delete policyGenerator;
+      }
+    }
+  }
+
+  virtual void doIterations(size_t numIterations) {
+    for (size_t t = 0; t < numIterations; ++t) {
+      doIteration();
+    }
+  }
+
+  virtual void doIteration() {
+    for (auto policyGenerator : policyGeneratorProfile_) {
+      policyGenerator->setIteration(t_);
+    }
+    for (size_t i = 0; i < game_->numPlayers; ++i) {
+      fixProfile(policyGeneratorProfile_, &currentProfile_);
+      numNodesVisited_ = 0;
+      value(0, i, 0);
+    }
+    ++t_;
+  }
+
+  /**
+   * Player i's half of iteration t, restricted to the subtrees below the
+   * given outcomes of the root, which must be a chance node. Solvers that
+   * share tables can split an iteration this way.
+   */
+  virtual void doPartialIteration(size_t t,
+                                  size_t i,
+                                  const std::vector<size_t>& rootOutcomes) {
+    const auto& game = *game_;
+    assert(game.isChance(0));
+    for (auto policyGenerator : policyGeneratorProfile_) {
+      policyGenerator->setIteration(t);
+    }
+    fixProfile(policyGeneratorProfile_, &currentProfile_);
+    numNodesVisited_ = 1;
+    for (const auto a : rootOutcomes) {
+      reachProbs_.back() = game.chanceProbability(0, a);
+      value(game.child(0, a), i, 1);
+    }
+    reachProbs_.back() = 1.0;
+  }
+
+  /**
+   * Seeds the tables with numVirtualIterations iterations' worth of the
+   * regrets and average strategy contributions of profile, laid out as
+   * strategyProfile() is. A prior solver's strategyProfile() makes a
+   * re-solve of a slightly changed game start near that solution. The
+   * iteration count is left as it was.
+   */
+  virtual void warmStart(const std::vector<std::vector<Numeric>>& profile,
+                         size_t numVirtualIterations) {
+    typedef PolicyGenerator::WarmStartGenerator<
+        size_t, std::pair<size_t, size_t>, Numeric> WarmStart;
+    const auto& game = *game_;
+    std::vector<Generator*> tables(policyGeneratorProfile_);
+    std::vector<Generator*> averageTables(cumulativeAverageStrategyProfile_);
+    for (size_t player = 0; player < game.numPlayers; ++player) {
+      const auto policyFn = [&game, &profile, player](const size_t& I) {
+        const auto* sigma_I =
+            &profile[player][game.numSequencesBeforeEachInfoSet[player][I]];
+        return std::vector<Numeric>(
+            sigma_I, sigma_I + game.numActionsAtEachInfoSet[player][I]);
+      };
+      policyGeneratorProfile_[player] =
+          new WarmStart(policyFn, tables[player], numVirtualIterations);
+      cumulativeAverageStrategyProfile_[player] = new WarmStart(
+          policyFn, averageTables[player], numVirtualIterations);
+    }
+    fixProfile(policyGeneratorProfile_, &currentProfile_);
+    for (size_t i = 0; i < game.numPlayers; ++i) {
+      numNodesVisited_ = 0;
+      value(0, i, 0);
+    }
+    for (size_t player = 0; player < game.numPlayers; ++player) {
+      delete policyGeneratorProfile_[player];
+      delete cumulativeAverageStrategyProfile_[player];
+    }
+    policyGeneratorProfile_ = std::move(tables);
+    cumulativeAverageStrategyProfile_ = std::move(averageTables);
+  }
+
+  /**
+   * Under limits, exploitability is measured against the same estimates.
+   */
+  virtual Numeric averageExploitability() const {
+    return BestResponse<Numeric>(*game_, strategyProfile(), limits_,
+                                 estimator_)
+        .averageExploitability();
+  }
+
+  /**
+   * The average strategy profile, by player and sequence.
+   */
+  virtual const std::vector<std::vector<Numeric>>& strategyProfile() const {
+    fixProfile(cumulativeAverageStrategyProfile_, &averageStrategyProfile_);
+    return averageStrategyProfile_;
+  }
+
+  /**
+   * Tables, by kind, and this solver's own profiles and traversal scratch
+   * space. Scratch space is only held during traversals, so its peak is
+   * the most that any traversal so far has held at once.
+   */
+  virtual MemoryAccounting::Breakdown memoryBreakdown() const {
+    MemoryAccounting::Usage regretTables;
+    MemoryAccounting::Usage averageTables;
+    for (size_t player = 0; player < game_->numPlayers; ++player) {
+      regretTables += policyGeneratorProfile_[player]->memoryUsage() +
+                      MemoryAccounting::Usage(0, 1);
+      averageTables +=
+          cumulativeAverageStrategyProfile_[player]->memoryUsage() +
+          MemoryAccounting::Usage(0, 1);
+    }
+    const auto profiles =
+        MemoryAccounting::Usage(sizeof(*this)) +
+        MemoryAccounting::ofNested(currentProfile_) +
+        MemoryAccounting::ofNested(averageStrategyProfile_) +
+        MemoryAccounting::ofContainer(reachProbs_) +
+        MemoryAccounting::ofContainer(policyGeneratorProfile_) +
+        MemoryAccounting::ofContainer(cumulativeAverageStrategyProfile_);
+    return {{"regret tables", regretTables},
+            {"average tables", averageTables},
+            {"profiles", profiles},
+            {"traversal scratch",
+             MemoryAccounting::withPeak(
+                 MemoryAccounting::Usage(scratchBytes_), peakScratchBytes_)}};
+  }
+  virtual MemoryAccounting::Usage memoryUsage() const {
+    return MemoryAccounting::total(memoryBreakdown());
+  }
+
+  /**
+   * The average strategy profile, exported for serving.
+   */
+  virtual Serving::PolicyTable servingTable(
+      Serving::Quantization quantization =
+          Serving::Quantization::FLOAT32) const {
+    return Serving::PolicyTable::build(
+        strategyProfile(), game_->numSequencesBeforeEachInfoSet,
+        quantization);
+  }
+
+ protected:
+  void fixProfile(const std::vector<Generator*>& generators,
+                  std::vector<std::vector<Numeric>>* profile) const {
+    for (size_t player = 0; player < game_->numPlayers; ++player) {
+      (*profile)[player].resize(game_->numSequences(player));
+      for (size_t I = 0; I < game_->numInfoSets(player); ++I) {
+        const auto sigma_I = generators[player]->policy(I);
+        std::copy(sigma_I.begin(), sigma_I.end(),
+                  (*profile)[player].begin() +
+                      game_->numSequencesBeforeEachInfoSet[player][I]);
+      }
+    }
+  }
+
+  /**
+   * Player i's expected utility below node, depth edges below the root,
+   * weighted by the other players' and chance's reach probabilities.
+   */
+  Numeric value(size_t node, size_t i, size_t depth) {
+    const auto& game = *game_;
+    const bool terminal = game.isTerminal(node);
+    const bool isLeaf =
+        estimator_ && !terminal && limits_.reached(depth, numNodesVisited_);
+    ++numNodesVisited_;
+    if (terminal || isLeaf) {
+      Numeric opponentReachProb = 1.0;
+      for (size_t player = 0; player < reachProbs_.size(); ++player) {
+        if (player != i) {
+          opponentReachProb *= reachProbs_[player];
+        }
+      }
+      return opponentReachProb * (terminal
+                                      ? game.utility(node, i)
+                                      : estimator_->estimate(node, i));
+    }
+    if (game.isChance(node)) {
+      auto& chanceReachProb = reachProbs_.back();
+      const auto reachProb = chanceReachProb;
+      Numeric v = 0.0;
+      for (size_t a = 0; a < game.numChildren(node); ++a) {
+        chanceReachProb = reachProb * game.chanceProbability(node, a);
+        v += value(game.child(node, a), i, depth + 1);
+      }
+      chanceReachProb = reachProb;
+      return v;
+    }
+    const auto actor = game.actor[node];
+    const auto I = game.infoSet[node];
+    const auto numActions = game.numChildren(node);
+    const Numeric* sigma_I =
+        &currentProfile_[actor][game.numSequencesBeforeEachInfoSet[actor][I]];
+    const auto reachProb = reachProbs_[actor];
+
+    std::vector<Numeric> actionVals(numActions);
+    scratchBytes_ += numActions * sizeof(Numeric);
+    peakScratchBytes_ = std::max(peakScratchBytes_, scratchBytes_);
+    for (size_t a = 0; a < numActions; ++a) {
+      reachProbs_[actor] = reachProb * sigma_I[a];
+      actionVals[a] = value(game.child(node, a), i, depth + 1);
+    }
+    reachProbs_[actor] = reachProb;
+    scratchBytes_ -= numActions * sizeof(Numeric);
+
+    if (actor != i) {
+      return Utils::sum(actionVals.data(), numActions);
+    }
+    const Numeric counterfactualValue =
+        Utils::dot(actionVals.data(), sigma_I, numActions);
+    for (size_t a = 0; a < numActions; ++a) {
+      policyGeneratorProfile_[i]->update(std::make_pair(I, a),
+                                         actionVals[a] - counterfactualValue);
+      cumulativeAverageStrategyProfile_[i]->update(std::make_pair(I, a),
+                                                   reachProb * sigma_I[a]);
+    }
+    return counterfactualValue;
+  }
+
+ protected:
+  const CompiledGame* game_;
+  std::vector<Generator*> policyGeneratorProfile_;
+  std::vector<Generator*> cumulativeAverageStrategyProfile_;
+  // Player / sequence
+  std::vector<std::vector<Numeric>> currentProfile_;
+  mutable std::vector<std::vector<Numeric>> averageStrategyProfile_;
+  // By player, then chance last
+  std::vector<Numeric> reachProbs_;
+  size_t t_;
+  const DepthLimit::Limits limits_;
+  const Estimator* estimator_;
+  // Within the player traversal in progress
+  size_t numNodesVisited_;
+  size_t scratchBytes_;
+  size_t peakScratchBytes_;
+};
+}
+}
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Solved strategies exported for lookup at play time.
+ */
+namespace Serving {
+/**
+ * How each probability is stored. Quantized rows are rounded so that each
+ * row's integers sum exactly to the largest representable value.
+ */
+enum class Quantization : uint64_t { FLOAT32 = 0, UINT16 = 1, UINT8 = 2 };
+
+inline size_t bytesPerProbability(Quantization quantization) {
+  switch (quantization) {
+    case Quantization::UINT16:
+      return 2;
+    case Quantization::UINT8:
+      return 1;
+    default:
+      return 4;
+  }
+}
+
+namespace Detail {
+const char MAGIC[8] = {'T', 'A', 'H', 'T', 'P', 'O', 'L', '1'};
+const size_t CACHE_LINE = 64;
+
+inline size_t alignUp(size_t numBytes) {
+  return (numBytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+struct Header {
+  char magic[8];
+  uint64_t numPlayers;
+  uint64_t quantization;
+  uint64_t numBytes;
+};
+
+// By player, after the header's cache line
+struct PlayerEntry {
+  uint64_t numInfoSets;
+  // From the start of the table: numInfoSets + 1 uint64_t sequence
+  // offsets, then the probabilities
+  uint64_t offsetsBegin;
+  uint64_t probabilitiesBegin;
+};
+
+/**
+ * Rounds row to integers summing to maxValue, giving the leftover units to
+ * the largest remainders.
+ */
+template <typename Numeric>
+std::vector<uint64_t> quantize(const Numeric* row,
+                               size_t numActions,
+                               uint64_t maxValue) {
+  double total = 0.0;
+  for (size_t a = 0; a < numActions; ++a) {
+    total += std::max(static_cast<double>(row[a]), 0.0);
+  }
+  std::vector<uint64_t> q(numActions, 0);
+  std::vector<double> remainders(numActions, 0.0);
+  uint64_t assigned = 0;
+  for (size_t a = 0; a < numActions; ++a) {
+    const double p = std::max(static_cast<double>(row[a]), 0.0);
+    const double scaled = total > 0.0
+                              ? p / total * maxValue
+                              : static_cast<double>(maxValue) / numActions;
+    q[a] = static_cast<uint64_t>(std::floor(scaled));
+    remainders[a] = scaled - q[a];
+    assigned += q[a];
+  }
+  while (assigned < maxValue) {
+    const size_t a =
+        std::max_element(remainders.begin(), remainders.end()) -
+        remainders.begin();
+    ++q[a];
+    remainders[a] = -1.0;
+    ++assigned;
+  }
+  return q;
+}
+}
+
+/**
+ * One information set's policy, viewed in place. Valid for as long as any
+ * copy of the table it came from.
+ */
+class PolicyView {
+ public:
+  PolicyView(const char* data, size_t numActions, Quantization quantization)
+      : data_(data), numActions_(numActions), quantization_(quantization) {}
+
+  size_t size() const { return numActions_; }
+  double operator[](size_t action) const {
+    assert(action < numActions_);
+    switch (quantization_) {
+      case Quantization::UINT16: {
+        uint16_t q;
+        memcpy(&q, data_ + 2 * action, sizeof(q));
+        return q / 65535.0;
+      }
+      case Quantization::UINT8:
+        return static_cast<uint8_t>(data_[action]) / 255.0;
+      default: {
+        float p;
+        memcpy(&p, data_ + 4 * action, sizeof(p));
+        return p;
+      }
+    }
+  }
+
+  /**
+   * The action drawn by uniformDraw, in [0, 1).
+   */
+  size_t sample(double uniformDraw) const {
+    double cumulative = 0.0;
+    for (size_t a = 0; a + 1 < numActions_; ++a) {
+      cumulative += (*this)[a];
+      if (uniformDraw < cumulative) {
+        return a;
+      }
+    }
+    return numActions_ - 1;
+  }
+
+ protected:
+  const char* data_;
+  size_t numActions_;
+  Quantization quantization_;
+};
+
+/**
+ * An immutable strategy profile, indexed by player and information set,
+ * in one contiguous image with every section aligned to a cache line.
+ * Lookups allocate nothing and copies share the image, so any number of
+ * threads may read one table at once. Images are in host byte order and
+ * may be memory-mapped straight from a saved file.
+ */
+class PolicyTable {
+ public:
+  /**
+   * Lays out profile, which gives each player's probability of every one
+   * of its sequences, with each information set's sequences starting at
+   * the given offsets, as in SequenceForm::CompiledGame.
+   */
+  template <typename Numeric>
+  static PolicyTable build(
+      const std::vector<std::vector<Numeric>>& profile,
+      const std::vector<std::vector<size_t>>& numSequencesBeforeEachInfoSet,
+      Quantization quantization = Quantization::FLOAT32) {
+    const size_t numPlayers = profile.size();
+    const size_t bytesPerProb = bytesPerProbability(quantization);
+    std::vector<Detail::PlayerEntry> entries(numPlayers);
+    size_t numBytes =
+        Detail::alignUp(sizeof(Detail::Header)) +
+        Detail::alignUp(numPlayers * sizeof(Detail::PlayerEntry));
+    for (size_t player = 0; player < numPlayers; ++player) {
+      auto& entry = entries[player];
+      entry.numInfoSets = numSequencesBeforeEachInfoSet[player].size();
+      entry.offsetsBegin = numBytes;
+      numBytes += Detail::alignUp((entry.numInfoSets + 1) * sizeof(uint64_t));
+      entry.probabilitiesBegin = numBytes;
+      numBytes += Detail::alignUp(profile[player].size() * bytesPerProb);
+    }
+
+    void* memory = nullptr;
+    if (posix_memalign(&memory, Detail::CACHE_LINE, numBytes) != 0) {
+      throw std::bad_alloc();
+    }
+    char* image = static_cast<char*>(memory);
+    memset(image, 0, numBytes);
+    Detail::Header header;
+    memcpy(header.magic, Detail::MAGIC, sizeof(header.magic));
+    header.numPlayers = numPlayers;
+    header.quantization = static_cast<uint64_t>(quantization);
+    header.numBytes = numBytes;
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + Detail::alignUp(sizeof(header)), entries.data(),
+           numPlayers * sizeof(Detail::PlayerEntry));
+
+    for (size_t player = 0; player < numPlayers; ++player) {
+      const auto& entry = entries[player];
+      const auto& before = numSequencesBeforeEachInfoSet[player];
+      uint64_t* offsets =
+          reinterpret_cast<uint64_t*>(image + entry.offsetsBegin);
+      for (size_t I = 0; I < entry.numInfoSets; ++I) {
+        offsets[I] = before[I];
+      }
+      offsets[entry.numInfoSets] = profile[player].size();
+
+      char* probs = image + entry.probabilitiesBegin;
+      for (size_t I = 0; I < entry.numInfoSets; ++I) {
+        const size_t numActions = offsets[I + 1] - offsets[I];
+        const Numeric* row = &profile[player][offsets[I]];
+        char* out = probs + offsets[I] * bytesPerProb;
+        if (quantization == Quantization::FLOAT32) {
+          for (size_t a = 0; a < numActions; ++a) {
+            const float p = static_cast<float>(row[a]);
+            memcpy(out + 4 * a, &p, sizeof(p));
+          }
+          continue;
+        }
+        const auto q = Detail::quantize(
+            row, numActions,
+            quantization == Quantization::UINT16 ? 65535 : 255);
+        for (size_t a = 0; a < numActions; ++a) {
+          if (quantization == Quantization::UINT16) {
+            const uint16_t q16 = static_cast<uint16_t>(q[a]);
+            memcpy(out + 2 * a, &q16, sizeof(q16));
+          } else {
+            out[a] = static_cast<char>(static_cast<uint8_t>(q[a]));
+          }
+        }
+      }
+    }
+    return PolicyTable(std::shared_ptr<const char>(
+        image, [](const char* p) { free(const_cast<char*>(p)); }));
+  }
+
+  /**
+   * Maps a saved image read-only. Pages are loaded on first use and shared
+   * with every other process that maps the same file.
+   */
+  static PolicyTable map(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Unable to open policy table, \"" + path +
+                               "\"");
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 ||
+        static_cast<size_t>(status.st_size) < sizeof(Detail::Header)) {
+      close(fd);
+      throw std::runtime_error("Not a policy table, \"" + path + "\"");
+    }
+    const size_t numBytes = status.st_size;
+    void* data = mmap(nullptr, numBytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      throw std::runtime_error("Unable to map policy table, \"" + path +
+                               "\"");
+    }
+    return PolicyTable(std::shared_ptr<const char>(
+                           static_cast<const char*>(data),
+                           [numBytes](const char* p) {
+                             munmap(const_cast<char*>(p), numBytes);
+                           }),
+                       numBytes);
+  }
+
+  void save(std::ostream& out) const {
+    out.write(image_.get(), numBytes());
+  }
+
+  size_t numPlayers() const { return players_.size(); }
+  size_t numInfoSets(size_t player) const {
+    return players_[player].numInfoSets;
+  }
+  size_t numBytes() const { return header().numBytes; }
+  Quantization quantization() const { return quantization_; }
+
+  PolicyView policy(size_t player, size_t I) const {
+    const auto& p = players_[player];
+    assert(I < p.numInfoSets);
+    return PolicyView(p.probabilities + p.offsets[I] * bytesPerProb_,
+                      p.offsets[I + 1] - p.offsets[I], quantization_);
+  }
+
+ protected:
+  struct Player {
+    size_t numInfoSets;
+    const uint64_t* offsets;
+    const char* probabilities;
+  };
+
+  /**
+   * Checks the image against numBytesAvailable when it is known, and checks
+   * every player's offsets once here so that lookups can trust them: they
+   * start at zero, never decrease, and end within the image.
+   */
+  PolicyTable(std::shared_ptr<const char> image,
+              size_t numBytesAvailable = SIZE_MAX)
+      : image_(image) {
+    const auto& h = header();
+    if (memcmp(h.magic, Detail::MAGIC, sizeof(h.magic)) != 0 ||
+        h.numBytes > numBytesAvailable ||
+        h.quantization > static_cast<uint64_t>(Quantization::UINT8)) {
+      throw std::runtime_error("Not a policy table");
+    }
+    const size_t entriesBegin = Detail::alignUp(sizeof(Detail::Header));
+    // Bounded by division so that a corrupt count cannot overflow
+    if (h.numBytes < entriesBegin ||
+        h.numPlayers >
+            (h.numBytes - entriesBegin) / sizeof(Detail::PlayerEntry)) {
+      throw std::runtime_error("Truncated policy table");
+    }
+    quantization_ = static_cast<Quantization>(h.quantization);
+    bytesPerProb_ = bytesPerProbability(quantization_);
+    const auto* entries = reinterpret_cast<const Detail::PlayerEntry*>(
+        image_.get() + entriesBegin);
+    for (size_t player = 0; player < h.numPlayers; ++player) {
+      const auto& entry = entries[player];
+      if (entry.offsetsBegin % Detail::CACHE_LINE != 0 ||
+          entry.probabilitiesBegin % Detail::CACHE_LINE != 0) {
+        throw std::runtime_error("Corrupt policy table");
+      }
+      if (entry.offsetsBegin > h.numBytes ||
+          entry.numInfoSets >=
+              (h.numBytes - entry.offsetsBegin) / sizeof(uint64_t) ||
+          entry.probabilitiesBegin > h.numBytes) {
+        throw std::runtime_error("Truncated policy table");
+      }
+      Player p;
+      p.numInfoSets = entry.numInfoSets;
+      p.offsets =
+          reinterpret_cast<const uint64_t*>(image_.get() + entry.offsetsBegin);
+      p.probabilities = image_.get() + entry.probabilitiesBegin;
+      if (p.offsets[0] != 0) {
+        throw std::runtime_error("Corrupt policy table");
+      }
+      for (size_t I = 0; I < p.numInfoSets; ++I) {
+        if (p.offsets[I + 1] < p.offsets[I]) {
+          throw std::runtime_error("Corrupt policy table");
+        }
+      }
+      if (p.offsets[p.numInfoSets] >
+          (h.numBytes - entry.probabilitiesBegin) / bytesPerProb_) {
+        throw std::runtime_error("Truncated policy table");
+      }
+      players_.push_back(p);
+    }
+  }
+
+  const Detail::Header& header() const {
+    return *reinterpret_cast<const Detail::Header*>(image_.get());
+  }
+
+  std::shared_ptr<const char> image_;
+  Quantization quantization_;
+  size_t bytesPerProb_;
+  std::vector<Player> players_;
+};
+}
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace TreeAndHistoryTraversal {
+namespace Telemetry {
+/**
+ * A bounded single-producer, single-consumer queue. Neither side ever
+ * blocks or locks: tryPush fails when the buffer is full and tryPop fails
+ * when it is empty.
+ */
+template <typename T>
+class SpscRingBuffer {
+ public:
+  /**
+   * capacity must be a power of two.
+   */
+  SpscRingBuffer(size_t capacity)
+      : slots_(capacity),
+        mask_(capacity - 1),
+        head_(0),
+        cachedTail_(0),
+        tail_(0),
+        cachedHead_(0) {
+    if (capacity == 0 || (capacity & mask_) != 0) {
+      throw std::invalid_argument("Ring buffer capacity must be a power of 2");
+    }
+  }
+
+  size_t capacity() const { return slots_.size(); }
+
+  bool tryPush(const T& item) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ > mask_) {
+      cachedHead_ = head_.load(std::memory_order_acquire);
+      if (tail - cachedHead_ > mask_) {
+        return false;
+      }
+    }
+    slots_[tail & mask_] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPop(T* item) {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == cachedTail_) {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+      if (head == cachedTail_) {
+        return false;
+      }
+    }
+    *item = slots_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ protected:
+  std::vector<T> slots_;
+  const size_t mask_;
+
+  // The consumer's and producer's positions are padded onto separate cache
+  // lines, each with a private copy of the other side's position so that
+  // most calls touch only their own line. Padding rather than alignas keeps
+  // heap allocation within C++11's default alignment.
+  char padding0_[64];
+  std::atomic<size_t> head_;
+  size_t cachedTail_;
+  char padding1_[64 - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+  std::atomic<size_t> tail_;
+  size_t cachedHead_;
+  char padding2_[64 - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
+
+/**
+ * One point on a convergence curve.
+ */
+struct Record {
+  // Distinguishes solves that share a stream, in the order they started
+  uint32_t run;
+  uint64_t iteration;
+  double seconds;
+  double exploitability;
+  uint64_t numRegretsSmallerThanNoise;
+};
+
+enum class Format {
+  // A header line then one comma-separated line per record
+  CSV,
+  // Each record's fields back to back in declaration order, in host byte
+  // order, with no padding (36 bytes per record)
+  BINARY
+};
+
+/**
+ * Streams records to a file from a background thread, so that the solver
+ * thread calling record() never waits on I/O.
+ *
+ * If the writer falls behind and the buffer fills, records are dropped
+ * rather than blocking the solver; numDropped() reports how many.
+ */
+class Sink {
+ public:
+  Sink(const std::string& path,
+       Format format = Format::CSV,
+       size_t capacity = 1 << 16)
+      : buffer_(capacity),
+        format_(format),
+        file_(fopen(path.c_str(), format == Format::CSV ? "w" : "wb")),
+        running_(true),
+        numDropped_(0),
+        numWritten_(0) {
+    if (!file_) {
+      throw std::runtime_error("Unable to open telemetry file, \"" + path +
+                               "\"");
+    }
+    if (format_ == Format::CSV) {
+      fprintf(file_,
+              "run,iteration,seconds,exploitability,"
+              "num_regrets_smaller_than_noise\n");
+    }
+    writer_ = std::thread([this]() { writeUntilStopped(); });
+  }
+
+  /**
+   * Writes every record still buffered before closing the file.
+   */
+  virtual ~Sink() {
+    running_.store(false, std::memory_order_release);
+    writer_.join();
+    fclose(file_);
+  }
+
+  /**
+   * Only one thread may record into a given sink.
+   */
+  bool record(const Record& r) {
+    if (buffer_.tryPush(r)) {
+      return true;
+    }
+    numDropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  size_t numDropped() const {
+    return numDropped_.load(std::memory_order_relaxed);
+  }
+  size_t numWritten() const {
+    return numWritten_.load(std::memory_order_relaxed);
+  }
+
+ protected:
+  void writeUntilStopped() {
+    while (true) {
+      // Records pushed before running_ was cleared are visible to the drain
+      // that follows this load.
+      const bool stopping = !running_.load(std::memory_order_acquire);
+      const size_t n = drain();
+      if (stopping) {
+        break;
+      }
+      if (n == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    fflush(file_);
+  }
+
+  size_t drain() {
+    size_t n = 0;
+    Record r;
+    while (buffer_.tryPop(&r)) {
+      write(r);
+      ++n;
+    }
+    numWritten_.fetch_add(n, std::memory_order_relaxed);
+    return n;
+  }
+
+  void write(const Record& r) {
+    if (format_ == Format::CSV) {
+      fprintf(file_, "%u,%llu,%.9g,%.17g,%llu\n", r.run,
+              static_cast<unsigned long long>(r.iteration), r.seconds,
+              r.exploitability,
+              static_cast<unsigned long long>(r.numRegretsSmallerThanNoise));
+    } else {
+      fwrite(&r.run, sizeof(r.run), 1, file_);
+      fwrite(&r.iteration, sizeof(r.iteration), 1, file_);
+      fwrite(&r.seconds, sizeof(r.seconds), 1, file_);
+      fwrite(&r.exploitability, sizeof(r.exploitability), 1, file_);
+      fwrite(&r.numRegretsSmallerThanNoise,
+             sizeof(r.numRegretsSmallerThanNoise), 1, file_);
+    }
+  }
+
+  SpscRingBuffer<Record> buffer_;
+  const Format format_;
+  FILE* file_;
+  std::atomic<bool> running_;
+  std::atomic<size_t> numDropped_;
+  std::atomic<size_t> numWritten_;
+  std::thread writer_;
+};
+}
+}
@@ -6,6 +6,9 @@
 
 #include <cpp_utilities/src/lib/memory.h>
 
+#include "instrumentation.hpp"
+#include "memory_accounting.hpp"
+
 namespace TreeAndHistoryTraversal {
 namespace TreeNode {
 template <typename Value>
@@ -17,7 +20,13 @@ class TreeNode {
   virtual ~TreeNode() {}
   virtual bool isTerminal() const = 0;
   virtual Value value() {
-    return isTerminal() ? terminalValue() : interiorValue();
+    Instrumentation::DepthScope depth;
+    const bool terminal = isTerminal();
+    Instrumentation::countNodeVisit(terminal);
+    return terminal ? terminalValue() : interiorValue();
+  }
+  virtual MemoryAccounting::Usage memoryUsage() const {
+    return MemoryAccounting::Usage(sizeof(*this));
   }
 
  protected:
@@ -57,6 +66,9 @@ class StoredTerminalNode : public TerminalNode<Value> {
   StoredTerminalNode(Value value)
       : TerminalNode<Value>::TerminalNode(), value_(value) {}
   virtual ~StoredTerminalNode() {}
+  virtual MemoryAccounting::Usage memoryUsage() const override {
+    return MemoryAccounting::Usage(sizeof(*this));
+  }
 
  protected:
   virtual Value terminalValue() override final { return value_; }
@@ -104,6 +116,19 @@ class StoredInteriorNode : public InteriorNode<Value> {
     children_ = children;
   }
 
+  /**
+   * This node and every node below it, each of which is its own
+   * allocation.
+   */
+  virtual MemoryAccounting::Usage memoryUsage() const override {
+    auto usage = MemoryAccounting::Usage(sizeof(*this)) +
+                 MemoryAccounting::ofContainer(children_);
+    for (const auto child : children_) {
+      usage += child->memoryUsage() + MemoryAccounting::Usage(0, 1);
+    }
+    return usage;
+  }
+
  protected:
   virtual Value interiorValue() override final {
     Value toReturn;
@@ -127,7 +152,10 @@ class NoReturnTreeNode {
   virtual ~NoReturnTreeNode() {}
   virtual bool isTerminal() const = 0;
   virtual void computeValue() {
-    if (isTerminal()) {
+    Instrumentation::DepthScope depth;
+    const bool terminal = isTerminal();
+    Instrumentation::countNodeVisit(terminal);
+    if (terminal) {
       computeTerminalValue();
     } else {
       computeInteriorValue();
@@ -0,0 +1,414 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "game_history.hpp"
+#include "history.hpp"
+#include "history_tree_node.hpp"
+#include "memory_accounting.hpp"
+#include "utils.hpp"
+
+namespace TreeAndHistoryTraversal {
+/**
+ * The shape of a history tree, counted by a parallel walk or estimated from
+ * random paths, for choosing between full and sampled solvers and for
+ * sizing their tables before a run.
+ */
+namespace TreeStatistics {
+struct Options {
+  size_t numThreads;
+  // Subtrees rooted this many edges below the root are the units of work
+  // that threads claim. Deeper splits balance better on trees whose first
+  // levels branch little.
+  size_t splitDepth;
+  // Zero walks every history. Otherwise, this many random paths from the
+  // root to a terminal estimate the counts instead.
+  size_t numSamples;
+  // Draws are a function of (seed, sample, depth) alone, so estimates are
+  // reproducible regardless of numThreads
+  uint64_t seed;
+
+  Options(size_t numThreads = 1,
+          size_t splitDepth = 1,
+          size_t numSamples = 0,
+          uint64_t seed = 0)
+      : numThreads(numThreads),
+        splitDepth(splitDepth),
+        numSamples(numSamples),
+        seed(seed) {}
+};
+
+/**
+ * Counts are exact when every history was walked. Sampled counts are
+ * unbiased estimates, while the information set, sequence, and branching
+ * factor maxima only cover the histories that the samples reached.
+ */
+struct Statistics {
+  // By depth, from the root at zero
+  std::vector<double> numNodesByDepth;
+  std::vector<double> numTerminalsByDepth;
+  // The most legal successors of any node at each depth
+  std::vector<size_t> maxBranchingFactorByDepth;
+  // By number of legal successors: the interior nodes with that many
+  std::vector<double> numInteriorNodesByBranchingFactor;
+  // By player, for game histories only: distinct information sets, and the
+  // legal actions summed over them
+  std::vector<size_t> numInfoSets;
+  std::vector<size_t> numSequences;
+  // Zero when every history was walked
+  size_t numSamples = 0;
+
+  double numNodes() const { return sum(numNodesByDepth); }
+  double numTerminals() const { return sum(numTerminalsByDepth); }
+  size_t maxDepth() const {
+    return numNodesByDepth.empty() ? 0 : numNodesByDepth.size() - 1;
+  }
+  /**
+   * Successors per interior node, which is also edges per interior node.
+   */
+  double meanBranchingFactor() const {
+    const double numInteriorNodes = numNodes() - numTerminals();
+    return numInteriorNodes > 0 ? (numNodes() - 1) / numInteriorNodes : 0.0;
+  }
+
+  /**
+   * What CFR with tables of bytesPerValue values would hold: one regret
+   * and one average table over each player's sequences, plus the action
+   * values kept at every depth of the deepest path.
+   */
+  MemoryAccounting::Breakdown memoryBreakdown(
+      size_t bytesPerValue = sizeof(double)) const {
+    size_t tableBytes = 0;
+    for (const auto n : numSequences) {
+      tableBytes += n * bytesPerValue;
+    }
+    size_t scratchBytes = 0;
+    for (const auto b : maxBranchingFactorByDepth) {
+      scratchBytes += b * bytesPerValue;
+    }
+    return {
+        {"regret tables",
+         MemoryAccounting::Usage(tableBytes, numSequences.size())},
+        {"average tables",
+         MemoryAccounting::Usage(tableBytes, numSequences.size())},
+        {"traversal scratch",
+         MemoryAccounting::withPeak(MemoryAccounting::Usage(), scratchBytes)}};
+  }
+
+  std::string report() const {
+    std::string text;
+    char line[160];
+    snprintf(line, sizeof(line),
+             "%.0lf nodes, %.0lf terminals, depth %zu, %.2lf mean branching "
+             "factor%s\n",
+             numNodes(), numTerminals(), maxDepth(), meanBranchingFactor(),
+             numSamples > 0 ? " (sampled)" : "");
+    text += line;
+    for (size_t player = 0; player < numInfoSets.size(); ++player) {
+      snprintf(line, sizeof(line),
+               "player %zu: %zu information sets, %zu sequences\n", player,
+               numInfoSets[player], numSequences[player]);
+      text += line;
+    }
+    for (size_t depth = 0; depth < numNodesByDepth.size(); ++depth) {
+      snprintf(line, sizeof(line),
+               "depth %4zu: %16.0lf nodes %16.0lf terminals %6zu max "
+               "branching\n",
+               depth, numNodesByDepth[depth], numTerminalsByDepth[depth],
+               maxBranchingFactorByDepth[depth]);
+      text += line;
+    }
+    for (size_t b = 0; b < numInteriorNodesByBranchingFactor.size(); ++b) {
+      if (numInteriorNodesByBranchingFactor[b] > 0) {
+        snprintf(line, sizeof(line), "branching %4zu: %16.0lf nodes\n", b,
+                 numInteriorNodesByBranchingFactor[b]);
+        text += line;
+      }
+    }
+    return text;
+  }
+
+ protected:
+  static double sum(const std::vector<double>& v) {
+    double s = 0.0;
+    for (const auto x : v) {
+      s += x;
+    }
+    return s;
+  }
+};
+
+namespace Detail {
+/**
+ * One thread's counts, merged into the others' once every thread is done.
+ */
+class Accumulator {
+ public:
+  void visit(size_t depth, size_t numSuccessors, double weight) {
+    if (stats_.numNodesByDepth.size() <= depth) {
+      stats_.numNodesByDepth.resize(depth + 1, 0.0);
+      stats_.numTerminalsByDepth.resize(depth + 1, 0.0);
+      stats_.maxBranchingFactorByDepth.resize(depth + 1, 0);
+    }
+    stats_.numNodesByDepth[depth] += weight;
+    if (numSuccessors == 0) {
+      stats_.numTerminalsByDepth[depth] += weight;
+      return;
+    }
+    auto& maxB = stats_.maxBranchingFactorByDepth[depth];
+    maxB = std::max(maxB, numSuccessors);
+    auto& histogram = stats_.numInteriorNodesByBranchingFactor;
+    if (histogram.size() <= numSuccessors) {
+      histogram.resize(numSuccessors + 1, 0.0);
+    }
+    histogram[numSuccessors] += weight;
+  }
+
+  void visitInfoSet(size_t player,
+                    std::string&& infoSet,
+                    size_t numActions) {
+    if (numActionsByInfoSet_.size() <= player) {
+      numActionsByInfoSet_.resize(player + 1);
+    }
+    numActionsByInfoSet_[player].emplace(std::move(infoSet), numActions);
+  }
+
+  void merge(const Accumulator& other) {
+    auto& s = stats_;
+    const auto& o = other.stats_;
+    const auto depths = std::max(s.numNodesByDepth.size(),
+                                 o.numNodesByDepth.size());
+    s.numNodesByDepth.resize(depths, 0.0);
+    s.numTerminalsByDepth.resize(depths, 0.0);
+    s.maxBranchingFactorByDepth.resize(depths, 0);
+    for (size_t depth = 0; depth < o.numNodesByDepth.size(); ++depth) {
+      s.numNodesByDepth[depth] += o.numNodesByDepth[depth];
+      s.numTerminalsByDepth[depth] += o.numTerminalsByDepth[depth];
+      s.maxBranchingFactorByDepth[depth] =
+          std::max(s.maxBranchingFactorByDepth[depth],
+                   o.maxBranchingFactorByDepth[depth]);
+    }
+    auto& histogram = s.numInteriorNodesByBranchingFactor;
+    const auto& otherHistogram = o.numInteriorNodesByBranchingFactor;
+    histogram.resize(std::max(histogram.size(), otherHistogram.size()), 0.0);
+    for (size_t b = 0; b < otherHistogram.size(); ++b) {
+      histogram[b] += otherHistogram[b];
+    }
+    if (numActionsByInfoSet_.size() < other.numActionsByInfoSet_.size()) {
+      numActionsByInfoSet_.resize(other.numActionsByInfoSet_.size());
+    }
+    for (size_t player = 0; player < other.numActionsByInfoSet_.size();
+         ++player) {
+      numActionsByInfoSet_[player].insert(
+          other.numActionsByInfoSet_[player].begin(),
+          other.numActionsByInfoSet_[player].end());
+    }
+  }
+
+  /**
+   * Counts are divided by numSamples when there are any.
+   */
+  Statistics statistics(size_t numSamples) const {
+    Statistics s = stats_;
+    s.numSamples = numSamples;
+    if (numSamples > 0) {
+      for (auto* v : {&s.numNodesByDepth, &s.numTerminalsByDepth,
+                      &s.numInteriorNodesByBranchingFactor}) {
+        for (auto& x : *v) {
+          x /= numSamples;
+        }
+      }
+    }
+    for (const auto& infoSets : numActionsByInfoSet_) {
+      s.numInfoSets.push_back(infoSets.size());
+      size_t numSequences = 0;
+      for (const auto& entry : infoSets) {
+        numSequences += entry.second;
+      }
+      s.numSequences.push_back(numSequences);
+    }
+    return s;
+  }
+
+ protected:
+  Statistics stats_;
+  // By player
+  std::vector<std::unordered_map<std::string, size_t>> numActionsByInfoSet_;
+};
+
+/**
+ * Plain histories have no information sets.
+ */
+template <typename Symbol>
+void visitInfoSet(const History::History<Symbol>&, size_t, Accumulator*) {}
+
+template <typename HistoryType>
+void visitInfoSet(const Game::GameHistory<HistoryType>& h,
+                  size_t numActions,
+                  Accumulator* accumulator) {
+  const auto actor = h.actor();
+  if (actor != Game::CHANCE) {
+    accumulator->visitInfoSet(actor, h.informationSet(), numActions);
+  }
+}
+
+/**
+ * Walks the histories above the split depth, like every other thread, and
+ * the subtrees at the split depth that it claims from nextSubtree. Only
+ * thread zero counts the histories above the split.
+ */
+template <typename HistoryType>
+class Walk : public HistoryTreeNode::PreorderHistoryTreeTraversal<
+                 typename std::decay<decltype(
+                     std::declval<HistoryType>().last())>::type> {
+ public:
+  typedef typename std::decay<decltype(
+      std::declval<HistoryType>().last())>::type Symbol;
+
+  Walk(HistoryType*&& root,
+       size_t thread,
+       size_t splitDepth,
+       std::atomic<size_t>* nextSubtree,
+       Accumulator* accumulator)
+      : HistoryTreeNode::PreorderHistoryTreeTraversal<Symbol>(
+            static_cast<History::History<Symbol>*>(root)),
+        root_(root),
+        thread_(thread),
+        splitDepth_(splitDepth),
+        nextSubtree_(nextSubtree),
+        accumulator_(accumulator),
+        depth_(0),
+        numSubtreesSeen_(0),
+        claimedSubtree_(nextSubtree->fetch_add(1)) {}
+  virtual ~Walk() {}
+
+ protected:
+  virtual void computeTerminalValue() override {
+    if (depth_ == splitDepth_) {
+      if (!claim()) {
+        return;
+      }
+      accumulator_->visit(depth_, 0, 1.0);
+      release();
+    } else if (depth_ > splitDepth_ || thread_ == 0) {
+      accumulator_->visit(depth_, 0, 1.0);
+    }
+  }
+  virtual void computeInteriorValue() override {
+    if (depth_ == splitDepth_ && !claim()) {
+      return;
+    }
+    if (depth_ >= splitDepth_ || thread_ == 0) {
+      const size_t numSuccessors = root_->numSuccessors();
+      accumulator_->visit(depth_, numSuccessors, 1.0);
+      visitInfoSet(*root_, numSuccessors, accumulator_);
+    }
+    ++depth_;
+    HistoryTreeNode::PreorderHistoryTreeTraversal<
+        Symbol>::computeInteriorValue();
+    --depth_;
+    if (depth_ == splitDepth_) {
+      release();
+    }
+  }
+
+  // Every thread numbers the subtrees at the split depth in the same
+  // preorder.
+  bool claim() { return numSubtreesSeen_++ == claimedSubtree_; }
+  void release() { claimedSubtree_ = nextSubtree_->fetch_add(1); }
+
+ protected:
+  // The history being walked, which history_ also points to
+  HistoryType* root_;
+  const size_t thread_;
+  const size_t splitDepth_;
+  std::atomic<size_t>* nextSubtree_;
+  Accumulator* accumulator_;
+  size_t depth_;
+  size_t numSubtreesSeen_;
+  size_t claimedSubtree_;
+};
+
+/**
+ * Knuth's estimator: follows one uniformly random path, weighting each
+ * node by the product of the branching factors above it, which is the
+ * inverse of the chance of reaching it.
+ */
+template <typename HistoryType>
+void samplePath(HistoryType* h,
+                uint64_t seed,
+                size_t sample,
+                size_t depth,
+                double weight,
+                Accumulator* accumulator) {
+  const size_t numSuccessors = h->numSuccessors();
+  accumulator->visit(depth, numSuccessors, weight);
+  if (numSuccessors == 0) {
+    return;
+  }
+  visitInfoSet(*h, numSuccessors, accumulator);
+  const size_t chosen = std::min(
+      numSuccessors - 1,
+      static_cast<size_t>(Utils::randomUniform(seed, sample, depth) *
+                          numSuccessors));
+  h->eachSuccessor([&](size_t, size_t legalSuffixIndex) {
+    if (legalSuffixIndex != chosen) {
+      return false;
+    }
+    samplePath(h, seed, sample, depth + 1, weight * numSuccessors,
+               accumulator);
+    return true;
+  });
+}
+}
+
+/**
+ * Gathers statistics of the tree below root, which may be any history in a
+ * larger tree. Each thread walks its own clone, and root is left as it
+ * was. Game histories also have their information sets counted.
+ */
+template <typename HistoryType>
+Statistics profile(const HistoryType& root,
+                   const Options& options = Options()) {
+  const size_t numThreads = std::max(options.numThreads, size_t(1));
+  std::vector<Detail::Accumulator> accumulators(numThreads);
+  std::atomic<size_t> nextSubtree(0);
+  const auto run = [&](size_t thread) {
+    if (options.numSamples > 0) {
+      std::unique_ptr<HistoryType> h(root.clone());
+      for (size_t sample = thread * options.numSamples / numThreads;
+           sample < (thread + 1) * options.numSamples / numThreads;
+           ++sample) {
+        Detail::samplePath(h.get(), options.seed, sample, 0, 1.0,
+                           &accumulators[thread]);
+      }
+      return;
+    }
+    Detail::Walk<HistoryType>(root.clone(), thread, options.splitDepth,
+                              &nextSubtree, &accumulators[thread])
+        .computeValue();
+  };
+  std::vector<std::thread> others;
+  for (size_t thread = 1; thread < numThreads; ++thread) {
+    others.emplace_back(run, thread);
+  }
+  run(0);
+  for (auto& other : others) {
+    other.join();
+  }
+  for (size_t thread = 1; thread < numThreads; ++thread) {
+    accumulators[0].merge(accumulators[thread]);
+  }
+  return accumulators[0].statistics(options.numSamples);
+}
+}
+}
@@ -1,10 +1,23 @@
 #pragma once
 
+#include <array>
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <random>
 #include <functional>
 
+#if !defined(TREE_AND_HISTORY_TRAVERSAL_NO_SIMD) && \
+    (defined(__x86_64__) || defined(__i386__)) &&   \
+    (defined(__GNUC__) || defined(__clang__))
+#define TREE_AND_HISTORY_TRAVERSAL_X86_SIMD 1
+#include <immintrin.h>
+#define TREE_AND_HISTORY_TRAVERSAL_AVX2 __attribute__((target("avx2")))
+#define TREE_AND_HISTORY_TRAVERSAL_AVX512 __attribute__((target("avx512f")))
+#endif
+
 namespace TreeAndHistoryTraversal {
 namespace Utils {
 template <typename T>
@@ -13,38 +26,480 @@ T copyAndReturnAfter(T valueToSaveAndRestore, std::function<void()> doFn) {
   return valueToSaveAndRestore;
 }
 
-template <typename Numeric = double>
-std::vector<Numeric> normalized(const std::vector<Numeric>& v) {
-  Numeric sum = 0.0;
-  std::vector<Numeric> n(v.size(), 1.0 / v.size());
-  for (auto elem : v) {
-    sum += elem;
+/**
+ * Dense numeric kernels shared by the policy generators and traversals.
+ *
+ * Every kernel has a portable scalar implementation. For float and double
+ * on x86, AVX2 and AVX-512 versions are selected at runtime from what the
+ * host CPU supports. Define TREE_AND_HISTORY_TRAVERSAL_NO_SIMD to compile
+ * the scalar versions only.
+ */
+namespace Kernels {
+enum class SimdLevel { SCALAR, AVX2, AVX512 };
+
+inline SimdLevel detectSimdLevel() {
+#ifdef TREE_AND_HISTORY_TRAVERSAL_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::AVX512;
   }
-  if (sum > 0) {
-    for (size_t i = 0; i < v.size(); ++i) {
-      n[i] = v[i] > 0.0 ? exp(log(v[i]) - log(sum)) : 0.0;
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+#endif
+  return SimdLevel::SCALAR;
+}
+
+inline SimdLevel simdLevel() {
+  static const SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+namespace Scalar {
+template <typename Numeric>
+Numeric sum(const Numeric* x, size_t n) {
+  Numeric s = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    s += x[i];
+  }
+  return s;
+}
+
+template <typename Numeric>
+Numeric positivePartSum(const Numeric* x, size_t n) {
+  Numeric s = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    s += x[i] > 0.0 ? x[i] : 0.0;
+  }
+  return s;
+}
+
+template <typename Numeric>
+void dividePositivePart(const Numeric* x,
+                        size_t n,
+                        Numeric divisor,
+                        Numeric* out) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = x[i] > 0.0 ? x[i] / divisor : 0.0;
+  }
+}
+
+template <typename Numeric>
+Numeric dot(const Numeric* x, const Numeric* y, size_t n) {
+  Numeric s = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    s += x[i] * y[i];
+  }
+  return s;
+}
+
+template <typename Numeric>
+void axpy(Numeric a, const Numeric* x, size_t n, Numeric* y) {
+  for (size_t i = 0; i < n; ++i) {
+    y[i] += a * x[i];
+  }
+}
+
+template <typename Numeric>
+Numeric max(const Numeric* x, size_t n) {
+  assert(n > 0);
+  Numeric m = x[0];
+  for (size_t i = 1; i < n; ++i) {
+    if (x[i] > m) {
+      m = x[i];
     }
   }
-  return n;
+  return m;
+}
 }
 
-template <typename Numeric = double>
-void normalize(const std::vector<Numeric>& from, std::vector<Numeric>* to) {
-  Numeric sum = 0.0;
-  for (auto elem : from) {
-    sum += elem;
+#ifdef TREE_AND_HISTORY_TRAVERSAL_X86_SIMD
+/**
+ * Register-level operations for each instruction set and element type. The
+ * SIMD kernels below are written once against this interface.
+ */
+struct Avx2Double {
+  typedef double Scalar;
+  typedef __m256d Register;
+  static const size_t WIDTH = 4;
+
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register zero() {
+    return _mm256_setzero_pd();
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register set1(Scalar a) {
+    return _mm256_set1_pd(a);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register load(const Scalar* p) {
+    return _mm256_loadu_pd(p);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static void store(Scalar* p, Register a) {
+    _mm256_storeu_pd(p, a);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register add(Register a, Register b) {
+    return _mm256_add_pd(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register mul(Register a, Register b) {
+    return _mm256_mul_pd(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register div(Register a, Register b) {
+    return _mm256_div_pd(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register max(Register a, Register b) {
+    return _mm256_max_pd(a, b);
+  }
+};
+
+struct Avx2Float {
+  typedef float Scalar;
+  typedef __m256 Register;
+  static const size_t WIDTH = 8;
+
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register zero() {
+    return _mm256_setzero_ps();
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register set1(Scalar a) {
+    return _mm256_set1_ps(a);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register load(const Scalar* p) {
+    return _mm256_loadu_ps(p);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static void store(Scalar* p, Register a) {
+    _mm256_storeu_ps(p, a);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register add(Register a, Register b) {
+    return _mm256_add_ps(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register mul(Register a, Register b) {
+    return _mm256_mul_ps(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register div(Register a, Register b) {
+    return _mm256_div_ps(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX2 static Register max(Register a, Register b) {
+    return _mm256_max_ps(a, b);
+  }
+};
+
+struct Avx512Double {
+  typedef double Scalar;
+  typedef __m512d Register;
+  static const size_t WIDTH = 8;
+
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register zero() {
+    return _mm512_setzero_pd();
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register set1(Scalar a) {
+    return _mm512_set1_pd(a);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register load(const Scalar* p) {
+    return _mm512_loadu_pd(p);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static void store(Scalar* p, Register a) {
+    _mm512_storeu_pd(p, a);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register add(Register a,
+                                                        Register b) {
+    return _mm512_add_pd(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register mul(Register a,
+                                                        Register b) {
+    return _mm512_mul_pd(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register div(Register a,
+                                                        Register b) {
+    return _mm512_div_pd(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register max(Register a,
+                                                        Register b) {
+    return _mm512_max_pd(a, b);
+  }
+};
+
+struct Avx512Float {
+  typedef float Scalar;
+  typedef __m512 Register;
+  static const size_t WIDTH = 16;
+
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register zero() {
+    return _mm512_setzero_ps();
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register set1(Scalar a) {
+    return _mm512_set1_ps(a);
   }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register load(const Scalar* p) {
+    return _mm512_loadu_ps(p);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static void store(Scalar* p, Register a) {
+    _mm512_storeu_ps(p, a);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register add(Register a,
+                                                        Register b) {
+    return _mm512_add_ps(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register mul(Register a,
+                                                        Register b) {
+    return _mm512_mul_ps(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register div(Register a,
+                                                        Register b) {
+    return _mm512_div_ps(a, b);
+  }
+  TREE_AND_HISTORY_TRAVERSAL_AVX512 static Register max(Register a,
+                                                        Register b) {
+    return _mm512_max_ps(a, b);
+  }
+};
+
+/**
+ * Kernel bodies shared by every instruction set. They are stamped out once
+ * per target attribute so the register operations inline into code
+ * compiled for that instruction set.
+ */
+#define TREE_AND_HISTORY_TRAVERSAL_DEFINE_SIMD_KERNELS(TARGET)                \
+  template <typename V>                                                       \
+  TARGET typename V::Scalar horizontalSum(typename V::Register a) {           \
+    typename V::Scalar lanes[V::WIDTH];                                       \
+    V::store(lanes, a);                                                       \
+    return Scalar::sum(lanes, V::WIDTH);                                      \
+  }                                                                           \
+  template <typename V>                                                       \
+  TARGET typename V::Scalar sum(const typename V::Scalar* x, size_t n) {      \
+    auto acc = V::zero();                                                     \
+    size_t i = 0;                                                             \
+    for (; i + V::WIDTH <= n; i += V::WIDTH) {                                \
+      acc = V::add(acc, V::load(x + i));                                      \
+    }                                                                         \
+    return horizontalSum<V>(acc) + Scalar::sum(x + i, n - i);                 \
+  }                                                                           \
+  template <typename V>                                                       \
+  TARGET typename V::Scalar positivePartSum(const typename V::Scalar* x,      \
+                                            size_t n) {                       \
+    const auto zero = V::zero();                                              \
+    auto acc = V::zero();                                                     \
+    size_t i = 0;                                                             \
+    for (; i + V::WIDTH <= n; i += V::WIDTH) {                                \
+      acc = V::add(acc, V::max(V::load(x + i), zero));                        \
+    }                                                                         \
+    return horizontalSum<V>(acc) + Scalar::positivePartSum(x + i, n - i);     \
+  }                                                                           \
+  template <typename V>                                                       \
+  TARGET void dividePositivePart(const typename V::Scalar* x, size_t n,       \
+                                 typename V::Scalar divisor,                  \
+                                 typename V::Scalar* out) {                   \
+    const auto zero = V::zero();                                              \
+    const auto d = V::set1(divisor);                                          \
+    size_t i = 0;                                                             \
+    for (; i + V::WIDTH <= n; i += V::WIDTH) {                                \
+      V::store(out + i, V::div(V::max(V::load(x + i), zero), d));             \
+    }                                                                         \
+    Scalar::dividePositivePart(x + i, n - i, divisor, out + i);               \
+  }                                                                           \
+  template <typename V>                                                       \
+  TARGET typename V::Scalar dot(const typename V::Scalar* x,                  \
+                                const typename V::Scalar* y, size_t n) {      \
+    auto acc = V::zero();                                                     \
+    size_t i = 0;                                                             \
+    for (; i + V::WIDTH <= n; i += V::WIDTH) {                                \
+      acc = V::add(acc, V::mul(V::load(x + i), V::load(y + i)));              \
+    }                                                                         \
+    return horizontalSum<V>(acc) + Scalar::dot(x + i, y + i, n - i);          \
+  }                                                                           \
+  template <typename V>                                                       \
+  TARGET void axpy(typename V::Scalar a, const typename V::Scalar* x,         \
+                   size_t n, typename V::Scalar* y) {                         \
+    const auto av = V::set1(a);                                               \
+    size_t i = 0;                                                             \
+    for (; i + V::WIDTH <= n; i += V::WIDTH) {                                \
+      V::store(y + i, V::add(V::load(y + i), V::mul(av, V::load(x + i))));    \
+    }                                                                         \
+    Scalar::axpy(a, x + i, n - i, y + i);                                     \
+  }                                                                           \
+  template <typename V>                                                       \
+  TARGET typename V::Scalar max(const typename V::Scalar* x, size_t n) {      \
+    if (n < V::WIDTH) {                                                       \
+      return Scalar::max(x, n);                                               \
+    }                                                                         \
+    auto acc = V::load(x);                                                    \
+    size_t i = V::WIDTH;                                                      \
+    for (; i + V::WIDTH <= n; i += V::WIDTH) {                                \
+      acc = V::max(acc, V::load(x + i));                                      \
+    }                                                                         \
+    typename V::Scalar lanes[V::WIDTH];                                       \
+    V::store(lanes, acc);                                                     \
+    auto m = Scalar::max(lanes, V::WIDTH);                                    \
+    for (; i < n; ++i) {                                                      \
+      if (x[i] > m) {                                                         \
+        m = x[i];                                                             \
+      }                                                                       \
+    }                                                                         \
+    return m;                                                                 \
+  }
+
+namespace Avx2 {
+TREE_AND_HISTORY_TRAVERSAL_DEFINE_SIMD_KERNELS(TREE_AND_HISTORY_TRAVERSAL_AVX2)
+}
+namespace Avx512 {
+TREE_AND_HISTORY_TRAVERSAL_DEFINE_SIMD_KERNELS(
+    TREE_AND_HISTORY_TRAVERSAL_AVX512)
+}
+#undef TREE_AND_HISTORY_TRAVERSAL_DEFINE_SIMD_KERNELS
+
+template <typename Numeric>
+struct SimdTraits {};
+template <>
+struct SimdTraits<double> {
+  typedef Avx2Double Avx2;
+  typedef Avx512Double Avx512;
+};
+template <>
+struct SimdTraits<float> {
+  typedef Avx2Float Avx2;
+  typedef Avx512Float Avx512;
+};
+
+#define TREE_AND_HISTORY_TRAVERSAL_DISPATCH(Numeric, kernel, ...)         \
+  switch (simdLevel()) {                                                  \
+    case SimdLevel::AVX512:                                               \
+      return Avx512::kernel<typename SimdTraits<Numeric>::Avx512>(        \
+          __VA_ARGS__);                                                   \
+    case SimdLevel::AVX2:                                                 \
+      return Avx2::kernel<typename SimdTraits<Numeric>::Avx2>(__VA_ARGS__); \
+    default:                                                              \
+      return Scalar::kernel(__VA_ARGS__);                                 \
+  }
+#else
+#define TREE_AND_HISTORY_TRAVERSAL_DISPATCH(Numeric, kernel, ...) \
+  return Scalar::kernel(__VA_ARGS__);
+#endif
+
+/**
+ * Runtime-dispatched entry points. Element types other than float and
+ * double always use the scalar implementations.
+ */
+template <typename Numeric>
+struct Dispatch {
+  static Numeric sum(const Numeric* x, size_t n) { return Scalar::sum(x, n); }
+  static Numeric positivePartSum(const Numeric* x, size_t n) {
+    return Scalar::positivePartSum(x, n);
+  }
+  static void dividePositivePart(const Numeric* x,
+                                 size_t n,
+                                 Numeric divisor,
+                                 Numeric* out) {
+    Scalar::dividePositivePart(x, n, divisor, out);
+  }
+  static Numeric dot(const Numeric* x, const Numeric* y, size_t n) {
+    return Scalar::dot(x, y, n);
+  }
+  static void axpy(Numeric a, const Numeric* x, size_t n, Numeric* y) {
+    Scalar::axpy(a, x, n, y);
+  }
+  static Numeric max(const Numeric* x, size_t n) { return Scalar::max(x, n); }
+};
+
+template <typename Numeric>
+struct SimdDispatch {
+  static Numeric sum(const Numeric* x, size_t n) {
+    TREE_AND_HISTORY_TRAVERSAL_DISPATCH(Numeric, sum, x, n)
+  }
+  static Numeric positivePartSum(const Numeric* x, size_t n) {
+    TREE_AND_HISTORY_TRAVERSAL_DISPATCH(Numeric, positivePartSum, x, n)
+  }
+  static void dividePositivePart(const Numeric* x,
+                                 size_t n,
+                                 Numeric divisor,
+                                 Numeric* out) {
+    TREE_AND_HISTORY_TRAVERSAL_DISPATCH(Numeric, dividePositivePart, x, n,
+                                        divisor, out)
+  }
+  static Numeric dot(const Numeric* x, const Numeric* y, size_t n) {
+    TREE_AND_HISTORY_TRAVERSAL_DISPATCH(Numeric, dot, x, y, n)
+  }
+  static void axpy(Numeric a, const Numeric* x, size_t n, Numeric* y) {
+    TREE_AND_HISTORY_TRAVERSAL_DISPATCH(Numeric, axpy, a, x, n, y)
+  }
+  static Numeric max(const Numeric* x, size_t n) {
+    TREE_AND_HISTORY_TRAVERSAL_DISPATCH(Numeric, max, x, n)
+  }
+};
+#undef TREE_AND_HISTORY_TRAVERSAL_DISPATCH
+
+template <>
+struct Dispatch<double> : public SimdDispatch<double> {};
+template <>
+struct Dispatch<float> : public SimdDispatch<float> {};
+}
+
+template <typename Numeric>
+Numeric sum(const Numeric* x, size_t n) {
+  return Kernels::Dispatch<Numeric>::sum(x, n);
+}
+
+/**
+ * Sum of max(x[i], 0).
+ */
+template <typename Numeric>
+Numeric positivePartSum(const Numeric* x, size_t n) {
+  return Kernels::Dispatch<Numeric>::positivePartSum(x, n);
+}
+
+template <typename Numeric>
+Numeric dot(const Numeric* x, const Numeric* y, size_t n) {
+  return Kernels::Dispatch<Numeric>::dot(x, y, n);
+}
+
+/**
+ * y <- y + a * x
+ */
+template <typename Numeric>
+void axpy(Numeric a, const Numeric* x, size_t n, Numeric* y) {
+  Kernels::Dispatch<Numeric>::axpy(a, x, n, y);
+}
+
+/**
+ * Index of the first largest element of x, which must be non-empty.
+ */
+template <typename Numeric>
+size_t argmax(const Numeric* x, size_t n) {
+  const Numeric m = Kernels::Dispatch<Numeric>::max(x, n);
+  size_t i = 0;
+  while (i + 1 < n && x[i] < m) {
+    ++i;
+  }
+  return i;
+}
+
+/**
+ * Writes the positive part of from, divided by its sum, to to. When no
+ * element is positive, to becomes the uniform distribution. from and to
+ * may alias.
+ */
+template <typename Numeric>
+void normalize(const Numeric* from, size_t n, Numeric* to) {
+  const Numeric sum = positivePartSum(from, n);
   if (sum > 0) {
-    for (size_t i = 0; i < from.size(); ++i) {
-      (*to)[i] = from[i] > 0.0 ? exp(log(from[i]) - log(sum)) : 0.0;
-    }
+    Kernels::Dispatch<Numeric>::dividePositivePart(from, n, sum, to);
   } else {
-    for (size_t i = 0; i < from.size(); ++i) {
-      (*to)[i] = 1.0 / from.size();
+    for (size_t i = 0; i < n; ++i) {
+      to[i] = Numeric(1.0) / n;
     }
   }
 }
 
+template <typename Numeric = double>
+std::vector<Numeric> normalized(const std::vector<Numeric>& v) {
+  std::vector<Numeric> n(v.size());
+  normalize(v.data(), v.size(), n.data());
+  return n;
+}
+
+template <typename Numeric = double>
+void normalize(const std::vector<Numeric>& from, std::vector<Numeric>* to) {
+  assert(to);
+  assert(to->size() == from.size());
+  normalize(from.data(), from.size(), to->data());
+}
+
 template <typename Numeric = double, typename RandomEngine = std::mt19937>
 bool flipCoin(Numeric probTrue, RandomEngine* randomEngine) {
   assert(randomEngine);
@@ -52,6 +507,89 @@ bool flipCoin(Numeric probTrue, RandomEngine* randomEngine) {
   return coin(*randomEngine);
 }
 
+/**
+ * Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+ * numbers: as easy as 1, 2, 3", 2011). Each output block is a pure function
+ * of its counter and key, so draws can be made in any order, from any
+ * thread, and still be reproduced exactly.
+ */
+class Philox4x32 {
+ public:
+  typedef std::array<uint32_t, 4> Counter;
+  typedef std::array<uint32_t, 2> Key;
+
+  static Counter generate(Counter counter, Key key) {
+    for (size_t round = 0; round < NUM_ROUNDS; ++round) {
+      if (round > 0) {
+        key[0] += WEYL_0;
+        key[1] += WEYL_1;
+      }
+      const uint64_t product0 =
+          static_cast<uint64_t>(MULTIPLIER_0) * counter[0];
+      const uint64_t product1 =
+          static_cast<uint64_t>(MULTIPLIER_1) * counter[2];
+      counter = {{static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                  static_cast<uint32_t>(product1),
+                  static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                  static_cast<uint32_t>(product0)}};
+    }
+    return counter;
+  }
+
+ private:
+  static const size_t NUM_ROUNDS = 10;
+  static const uint32_t MULTIPLIER_0 = 0xD2511F53;
+  static const uint32_t MULTIPLIER_1 = 0xCD9E8D57;
+  static const uint32_t WEYL_0 = 0x9E3779B9;
+  static const uint32_t WEYL_1 = 0xBB67AE85;
+};
+
+/**
+ * Fills signs with n independent, uniformly random +1/-1 values determined
+ * entirely by (seed, iteration, streamIndex). Each Philox block supplies 128
+ * signs. Only the low 32 bits of streamIndex are used.
+ */
+template <typename Numeric>
+void randomSigns(uint64_t seed,
+                 uint64_t iteration,
+                 uint64_t streamIndex,
+                 size_t n,
+                 Numeric* signs) {
+  const Philox4x32::Key key{
+      {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}};
+  const size_t BITS_PER_BLOCK = 128;
+  for (size_t block = 0; block * BITS_PER_BLOCK < n; ++block) {
+    const auto bits = Philox4x32::generate(
+        {{static_cast<uint32_t>(block), static_cast<uint32_t>(streamIndex),
+          static_cast<uint32_t>(iteration),
+          static_cast<uint32_t>(iteration >> 32)}},
+        key);
+    const size_t end = std::min(n, (block + 1) * BITS_PER_BLOCK);
+    for (size_t i = block * BITS_PER_BLOCK; i < end; ++i) {
+      const size_t bit = i % BITS_PER_BLOCK;
+      signs[i] = ((bits[bit / 32] >> (bit % 32)) & 1) ? 1.0 : -1.0;
+    }
+  }
+}
+
+/**
+ * A uniformly random value in [0, 1), with 53 random bits, determined
+ * entirely by (seed, iteration, streamIndex). Only the low 32 bits of
+ * streamIndex are used.
+ */
+inline double randomUniform(uint64_t seed,
+                            uint64_t iteration,
+                            uint64_t streamIndex) {
+  const auto bits = Philox4x32::generate(
+      {{0, static_cast<uint32_t>(streamIndex),
+        static_cast<uint32_t>(iteration),
+        static_cast<uint32_t>(iteration >> 32)}},
+      {{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}});
+  const uint64_t mantissa =
+      ((static_cast<uint64_t>(bits[0]) << 32) | bits[1]) >> 11;
+  return mantissa * (1.0 / (UINT64_C(1) << 53));
+}
+
 typedef double Numeric;
 }
 }
@@ -0,0 +1,559 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "game_history.hpp"
+#include "instrumentation.hpp"
+#include "memory_accounting.hpp"
+#include "policy_generator.hpp"
+#include "utils.hpp"
+
+namespace TreeAndHistoryTraversal {
+/**
+ * Solvers that traverse only a game's public tree, carrying a vector over
+ * every private state the way SequenceForm's solvers carry a single
+ * probability. A node visit does the work of one visit per deal, as dense
+ * vector arithmetic.
+ */
+namespace VectorForm {
+/**
+ * A Game::PublicGameHistory flattened like SequenceForm::CompiledGame, with
+ * nodes in preorder. Information sets and sequences use the same per-player
+ * layout, so the same regret matching tables apply and profiles can be
+ * compared by information set name.
+ */
+struct PublicTree {
+  enum : size_t { TERMINAL = SIZE_MAX, CHANCE = Game::CHANCE };
+
+  // By player
+  std::vector<size_t> numPrivateStates;
+
+  // By node: the acting player, CHANCE, or TERMINAL
+  std::vector<size_t> actor;
+  // By node, plus one past the last
+  std::vector<size_t> childrenBegin;
+  std::vector<size_t> children;
+  // By node: at player nodes, where the actor's information set for each of
+  // its private states starts in infoSets; at terminals, where the
+  // terminal's payoff matrices start in payoffs
+  std::vector<size_t> begin;
+  std::vector<size_t> infoSets;
+  // By terminal, then player: a row-major matrix over player 0's and player
+  // 1's private states of the player's utility times the chance
+  // probability
+  std::vector<double> payoffs;
+
+  // By player, then information set
+  std::vector<std::vector<std::string>> infoSetNames;
+  std::vector<std::vector<size_t>> numActionsAtEachInfoSet;
+  std::vector<std::vector<size_t>> numSequencesBeforeEachInfoSet;
+
+  size_t numNodes() const { return actor.size(); }
+  bool isTerminal(size_t node) const { return actor[node] == TERMINAL; }
+  bool isChance(size_t node) const { return actor[node] == CHANCE; }
+  size_t numChildren(size_t node) const {
+    return childrenBegin[node + 1] - childrenBegin[node];
+  }
+  size_t child(size_t node, size_t action) const {
+    return children[childrenBegin[node] + action];
+  }
+  size_t infoSet(size_t node, size_t privateState) const {
+    assert(actor[node] < numPrivateStates.size());
+    return infoSets[begin[node] + privateState];
+  }
+  const double* payoffMatrix(size_t node, size_t player) const {
+    assert(isTerminal(node));
+    return &payoffs[begin[node] +
+                    player * numPrivateStates[0] * numPrivateStates[1]];
+  }
+
+  size_t numInfoSets(size_t player) const {
+    return numActionsAtEachInfoSet[player].size();
+  }
+  size_t numSequences(size_t player) const {
+    return numInfoSets(player) == 0
+               ? 0
+               : numSequencesBeforeEachInfoSet[player].back() +
+                     numActionsAtEachInfoSet[player].back();
+  }
+  size_t maxNumPrivateStates() const {
+    return std::max(numPrivateStates[0], numPrivateStates[1]);
+  }
+};
+
+namespace Detail {
+template <typename HistoryType>
+class Compiler {
+ public:
+  Compiler(Game::PublicGameHistory<HistoryType>* root) : history_(root) {
+    for (size_t player = 0; player < 2; ++player) {
+      tree_.numPrivateStates.push_back(root->numPrivateStates(player));
+    }
+    tree_.infoSetNames.resize(2);
+    tree_.numActionsAtEachInfoSet.resize(2);
+    tree_.numSequencesBeforeEachInfoSet.resize(2);
+    infoSetIndices_.resize(2);
+    visit();
+    tree_.childrenBegin.push_back(tree_.children.size());
+  }
+
+  PublicTree& tree() { return tree_; }
+
+ protected:
+  void visit() {
+    const auto node = tree_.numNodes();
+    const auto n0 = tree_.numPrivateStates[0];
+    const auto n1 = tree_.numPrivateStates[1];
+    tree_.childrenBegin.push_back(tree_.children.size());
+    if (!history_->hasSuccessors()) {
+      tree_.actor.push_back(PublicTree::TERMINAL);
+      tree_.begin.push_back(tree_.payoffs.size());
+      for (size_t player = 0; player < 2; ++player) {
+        for (size_t s0 = 0; s0 < n0; ++s0) {
+          for (size_t s1 = 0; s1 < n1; ++s1) {
+            const double prob = history_->chanceProbability(s0, s1);
+            tree_.payoffs.push_back(
+                prob > 0 ? prob * history_->utility(player, s0, s1) : 0.0);
+          }
+        }
+      }
+      return;
+    }
+    const auto player = history_->actor();
+    const auto numActions = history_->numSuccessors();
+    const auto childrenBegin = tree_.children.size();
+    tree_.children.resize(childrenBegin + numActions);
+    tree_.actor.push_back(player);
+    tree_.begin.push_back(tree_.infoSets.size());
+    if (player < 2) {
+      for (size_t s = 0; s < tree_.numPrivateStates[player]; ++s) {
+        tree_.infoSets.push_back(infoSetIndex(
+            player, history_->informationSet(s), node, numActions));
+      }
+    } else if (player != Game::CHANCE) {
+      throw std::runtime_error("Actor out of range");
+    }
+
+    history_->eachSuccessor([&](size_t, size_t legalSuffixIndex) {
+      tree_.children[childrenBegin + legalSuffixIndex] = tree_.numNodes();
+      visit();
+      return false;
+    });
+  }
+
+  size_t infoSetIndex(size_t player,
+                      const std::string& name,
+                      size_t node,
+                      size_t numActions) {
+    const auto found = infoSetIndices_[player].find(name);
+    if (found != infoSetIndices_[player].end()) {
+      if (found->second.second != node) {
+        throw std::runtime_error("Information set, \"" + name +
+                                 "\", spans more than one public node");
+      }
+      return found->second.first;
+    }
+    auto& numActionsAtEachInfoSet = tree_.numActionsAtEachInfoSet[player];
+    auto& numSequencesBefore = tree_.numSequencesBeforeEachInfoSet[player];
+    const auto I = numActionsAtEachInfoSet.size();
+    numSequencesBefore.push_back(
+        I == 0 ? 0
+               : numSequencesBefore.back() + numActionsAtEachInfoSet.back());
+    numActionsAtEachInfoSet.push_back(numActions);
+    tree_.infoSetNames[player].push_back(name);
+    infoSetIndices_[player].emplace(name, std::make_pair(I, node));
+    return I;
+  }
+
+  Game::PublicGameHistory<HistoryType>* history_;
+  PublicTree tree_;
+  // By player, then name: the information set's index and public node
+  std::vector<std::unordered_map<std::string, std::pair<size_t, size_t>>>
+      infoSetIndices_;
+};
+
+// Payoffs are stored as doubles, so only double solvers get the SIMD
+// kernels.
+template <typename Numeric>
+Numeric dot(const double* x, const Numeric* y, size_t n) {
+  Numeric s = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    s += x[i] * y[i];
+  }
+  return s;
+}
+inline double dot(const double* x, const double* y, size_t n) {
+  return Utils::dot(x, y, n);
+}
+template <typename Numeric>
+void axpy(Numeric a, const double* x, size_t n, Numeric* y) {
+  for (size_t i = 0; i < n; ++i) {
+    y[i] += a * x[i];
+  }
+}
+inline void axpy(double a, const double* x, size_t n, double* y) {
+  Utils::axpy(a, x, n, y);
+}
+
+/**
+ * Player i's values over its private states at a terminal, given the
+ * opponent's reach probabilities over theirs.
+ */
+template <typename Numeric>
+void terminalValues(const PublicTree& tree,
+                    size_t node,
+                    size_t i,
+                    const Numeric* opponentReach,
+                    Numeric* values) {
+  const auto n0 = tree.numPrivateStates[0];
+  const auto n1 = tree.numPrivateStates[1];
+  const double* payoffs = tree.payoffMatrix(node, i);
+  if (i == 0) {
+    for (size_t s0 = 0; s0 < n0; ++s0) {
+      values[s0] = dot(payoffs + s0 * n1, opponentReach, n1);
+    }
+  } else {
+    std::fill(values, values + n1, Numeric(0.0));
+    for (size_t s0 = 0; s0 < n0; ++s0) {
+      if (opponentReach[s0] != 0) {
+        axpy(opponentReach[s0], payoffs + s0 * n1, n1, values);
+      }
+    }
+  }
+}
+}
+
+/**
+ * Walks every public history below root once. root is restored before
+ * returning.
+ */
+template <typename HistoryType>
+PublicTree compile(Game::PublicGameHistory<HistoryType>* root) {
+  return std::move(Detail::Compiler<HistoryType>(root).tree());
+}
+
+/**
+ * Best responses to a profile laid out as in SequenceForm::BestResponse.
+ * Each information set must lie at a single public node, which compile
+ * ensures.
+ */
+template <typename Numeric = Utils::Numeric>
+class BestResponse {
+ public:
+  BestResponse(const PublicTree& tree,
+               const std::vector<std::vector<Numeric>>& stratProfile)
+      : tree_(&tree), strategyProfile_(&stratProfile) {}
+  virtual ~BestResponse() {}
+
+  virtual std::vector<Numeric> valueProfile() const {
+    std::vector<Numeric> brValues(2);
+    for (size_t i = 0; i < 2; ++i) {
+      const auto n = tree_->numPrivateStates[i];
+      std::vector<Numeric> values(n);
+      std::vector<Numeric> opponentReach(tree_->numPrivateStates[1 - i], 1.0);
+      value(0, i, opponentReach.data(), values.data());
+      brValues[i] = Utils::sum(values.data(), n);
+    }
+    return brValues;
+  }
+
+  virtual Numeric averageExploitability() const {
+    const auto brValues = valueProfile();
+    return Utils::sum(brValues.data(), brValues.size()) / brValues.size();
+  }
+
+ protected:
+  void value(size_t node,
+             size_t i,
+             const Numeric* opponentReach,
+             Numeric* values) const {
+    const auto& tree = *tree_;
+    const auto n = tree.numPrivateStates[i];
+    if (tree.isTerminal(node)) {
+      Detail::terminalValues(tree, node, i, opponentReach, values);
+      return;
+    }
+    const auto actor = tree.actor[node];
+    const auto numActions = tree.numChildren(node);
+    if (actor != i) {
+      std::vector<Numeric> childReach;
+      if (actor != PublicTree::CHANCE) {
+        childReach.resize(tree.numPrivateStates[actor]);
+      }
+      std::vector<Numeric> childValues(n);
+      std::fill(values, values + n, Numeric(0.0));
+      for (size_t a = 0; a < numActions; ++a) {
+        const Numeric* reach = opponentReach;
+        if (actor != PublicTree::CHANCE) {
+          for (size_t s = 0; s < childReach.size(); ++s) {
+            childReach[s] = opponentReach[s] * sigma(actor, node, s)[a];
+          }
+          reach = childReach.data();
+        }
+        value(tree.child(node, a), i, reach, childValues.data());
+        Utils::axpy(Numeric(1.0), childValues.data(), n, values);
+      }
+      return;
+    }
+
+    // By action, then private state
+    std::vector<Numeric> actionValues(numActions * n);
+    for (size_t a = 0; a < numActions; ++a) {
+      value(tree.child(node, a), i, opponentReach, &actionValues[a * n]);
+    }
+    // Every private state in an information set takes the action that is
+    // best for the set as a whole.
+    std::unordered_map<size_t, size_t> bestActions;
+    for (size_t s = 0; s < n; ++s) {
+      const auto I = tree.infoSet(node, s);
+      if (bestActions.count(I) > 0) {
+        continue;
+      }
+      std::vector<Numeric> infoSetValues(numActions, 0.0);
+      for (size_t s2 = s; s2 < n; ++s2) {
+        if (tree.infoSet(node, s2) == I) {
+          for (size_t a = 0; a < numActions; ++a) {
+            infoSetValues[a] += actionValues[a * n + s2];
+          }
+        }
+      }
+      bestActions[I] = Utils::argmax(infoSetValues.data(), numActions);
+    }
+    for (size_t s = 0; s < n; ++s) {
+      values[s] = actionValues[bestActions[tree.infoSet(node, s)] * n + s];
+    }
+  }
+
+  const Numeric* sigma(size_t player, size_t node, size_t s) const {
+    const auto I = tree_->infoSet(node, s);
+    return &(*strategyProfile_)[player][
+        tree_->numSequencesBeforeEachInfoSet[player][I]];
+  }
+
+  const PublicTree* tree_;
+  const std::vector<std::vector<Numeric>>* strategyProfile_;
+};
+
+/**
+ * Alternating-update CFR on a public tree, with the same interface as
+ * SequenceForm::Cfr. Takes ownership of the policy generators.
+ *
+ * Every node has its own slice of scratch space for its reach and values,
+ * so an iteration allocates nothing.
+ */
+template <typename Numeric = Utils::Numeric>
+class Cfr {
+ public:
+  typedef PolicyGenerator::PolicyGenerator<size_t,
+                                           std::pair<size_t, size_t>,
+                                           Numeric>
+      Generator;
+
+  Cfr(const PublicTree& tree,
+      std::vector<Generator*>&& policyGeneratorProfile,
+      std::vector<Generator*>&& averageGeneratorProfile)
+      : tree_(&tree),
+        policyGeneratorProfile_(std::move(policyGeneratorProfile)),
+        cumulativeAverageStrategyProfile_(std::move(averageGeneratorProfile)),
+        currentProfile_(2),
+        averageStrategyProfile_(2),
+        stride_(tree.maxNumPrivateStates()),
+        reachProbs_(tree.numNodes() * stride_),
+        values_(tree.numNodes() * stride_),
+        t_(0) {
+    for (size_t player = 0; player < 2; ++player) {
+      currentProfile_[player].resize(tree.numSequences(player));
+      rootReachProbs_.emplace_back(tree.numPrivateStates[player], 1.0);
+    }
+  }
+  Cfr(const Cfr&) = delete;
+  Cfr& operator=(const Cfr&) = delete;
+  virtual ~Cfr() {
+    for (auto& policyGenerator : policyGeneratorProfile_) {
+      if (policyGenerator) {
+        delete policyGenerator;
+      }
+    }
+    for (auto& policyGenerator : cumulativeAverageStrategyProfile_) {
+      if (policyGenerator) {
+        delete policyGenerator;
+      }
+    }
+  }
+
+  virtual void doIterations(size_t numIterations) {
+    for (size_t t = 0; t < numIterations; ++t) {
+      doIteration();
+    }
+  }
+
+  virtual void doIteration() {
+    for (auto policyGenerator : policyGeneratorProfile_) {
+      policyGenerator->setIteration(t_);
+    }
+    for (size_t i = 0; i < 2; ++i) {
+      fixProfile(policyGeneratorProfile_, &currentProfile_);
+      value(0, i, rootReachProbs_[0].data(), rootReachProbs_[1].data());
+    }
+    ++t_;
+  }
+
+  virtual Numeric averageExploitability() const {
+    return BestResponse<Numeric>(*tree_, strategyProfile())
+        .averageExploitability();
+  }
+
+  /**
+   * The average strategy profile, by player and sequence.
+   */
+  virtual const std::vector<std::vector<Numeric>>& strategyProfile() const {
+    fixProfile(cumulativeAverageStrategyProfile_, &averageStrategyProfile_);
+    return averageStrategyProfile_;
+  }
+
+  /**
+   * Tables, by kind, and this solver's own profiles and traversal scratch
+   * space. Every node has a slice of scratch space for as long as the
+   * solver lives, so it grows with the public tree and its peak is what
+   * it holds now.
+   */
+  virtual MemoryAccounting::Breakdown memoryBreakdown() const {
+    MemoryAccounting::Usage regretTables;
+    MemoryAccounting::Usage averageTables;
+    for (size_t player = 0; player < policyGeneratorProfile_.size();
+         ++player) {
+      regretTables += policyGeneratorProfile_[player]->memoryUsage() +
+                      MemoryAccounting::Usage(0, 1);
+      averageTables +=
+          cumulativeAverageStrategyProfile_[player]->memoryUsage() +
+          MemoryAccounting::Usage(0, 1);
+    }
+    const auto profiles =
+        MemoryAccounting::Usage(sizeof(*this)) +
+        MemoryAccounting::ofNested(currentProfile_) +
+        MemoryAccounting::ofNested(averageStrategyProfile_) +
+        MemoryAccounting::ofNested(rootReachProbs_) +
+        MemoryAccounting::ofContainer(policyGeneratorProfile_) +
+        MemoryAccounting::ofContainer(cumulativeAverageStrategyProfile_);
+    return {{"regret tables", regretTables},
+            {"average tables", averageTables},
+            {"profiles", profiles},
+            {"traversal scratch", MemoryAccounting::ofContainer(reachProbs_) +
+                                      MemoryAccounting::ofContainer(values_)}};
+  }
+  virtual MemoryAccounting::Usage memoryUsage() const {
+    return MemoryAccounting::total(memoryBreakdown());
+  }
+
+ protected:
+  void fixProfile(const std::vector<Generator*>& generators,
+                  std::vector<std::vector<Numeric>>* profile) const {
+    for (size_t player = 0; player < 2; ++player) {
+      (*profile)[player].resize(tree_->numSequences(player));
+      for (size_t I = 0; I < tree_->numInfoSets(player); ++I) {
+        const auto sigma_I = generators[player]->policy(I);
+        std::copy(sigma_I.begin(), sigma_I.end(),
+                  (*profile)[player].begin() +
+                      tree_->numSequencesBeforeEachInfoSet[player][I]);
+      }
+    }
+  }
+
+  /**
+   * Writes player i's counterfactual values over its private states below
+   * node to node's slice of values_.
+   */
+  void value(size_t node,
+             size_t i,
+             const Numeric* reach0,
+             const Numeric* reach1) {
+    const auto& tree = *tree_;
+    Instrumentation::countNodeVisit(tree.isTerminal(node));
+    const auto n = tree.numPrivateStates[i];
+    Numeric* values = &values_[node * stride_];
+    if (tree.isTerminal(node)) {
+      Detail::terminalValues(tree, node, i, i == 0 ? reach1 : reach0, values);
+      return;
+    }
+    const auto actor = tree.actor[node];
+    const auto numActions = tree.numChildren(node);
+    std::fill(values, values + n, Numeric(0.0));
+    if (actor == PublicTree::CHANCE) {
+      for (size_t a = 0; a < numActions; ++a) {
+        const auto child = tree.child(node, a);
+        value(child, i, reach0, reach1);
+        Utils::axpy(Numeric(1.0), &values_[child * stride_], n, values);
+      }
+      return;
+    }
+
+    const auto numActorStates = tree.numPrivateStates[actor];
+    const Numeric* actorReach = actor == 0 ? reach0 : reach1;
+    for (size_t a = 0; a < numActions; ++a) {
+      const auto child = tree.child(node, a);
+      Numeric* childReach = &reachProbs_[child * stride_];
+      for (size_t s = 0; s < numActorStates; ++s) {
+        childReach[s] = actorReach[s] * sigma(actor, node, s)[a];
+      }
+      if (actor == 0) {
+        value(child, i, childReach, reach1);
+      } else {
+        value(child, i, reach0, childReach);
+      }
+      const Numeric* childValues = &values_[child * stride_];
+      if (actor != i) {
+        Utils::axpy(Numeric(1.0), childValues, n, values);
+      } else {
+        for (size_t s = 0; s < n; ++s) {
+          values[s] += sigma(i, node, s)[a] * childValues[s];
+        }
+      }
+    }
+    if (actor != i) {
+      return;
+    }
+    for (size_t s = 0; s < n; ++s) {
+      const auto I = tree.infoSet(node, s);
+      const Numeric* sigma_I = sigma(i, node, s);
+      for (size_t a = 0; a < numActions; ++a) {
+        const Numeric actionValue = values_[tree.child(node, a) * stride_ + s];
+        policyGeneratorProfile_[i]->update(std::make_pair(I, a),
+                                           actionValue - values[s]);
+        cumulativeAverageStrategyProfile_[i]->update(
+            std::make_pair(I, a), actorReach[s] * sigma_I[a]);
+      }
+    }
+  }
+
+  const Numeric* sigma(size_t player, size_t node, size_t s) const {
+    const auto I = tree_->infoSet(node, s);
+    return &currentProfile_[player]
+                           [tree_->numSequencesBeforeEachInfoSet[player][I]];
+  }
+
+ protected:
+  const PublicTree* tree_;
+  std::vector<Generator*> policyGeneratorProfile_;
+  std::vector<Generator*> cumulativeAverageStrategyProfile_;
+  // Player / sequence
+  std::vector<std::vector<Numeric>> currentProfile_;
+  mutable std::vector<std::vector<Numeric>> averageStrategyProfile_;
+  std::vector<std::vector<Numeric>> rootReachProbs_;
+  // Entries per node in reachProbs_ and values_
+  const size_t stride_;
+  // By node, then private state of the parent's actor: the reach
+  // probabilities after the parent's action
+  std::vector<Numeric> reachProbs_;
+  // By node, then private state of the player being updated
+  std::vector<Numeric> values_;
+  size_t t_;
+};
+}
+}
@@ -1,50 +1,118 @@
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <lib/utils.hpp>
 #include <lib/policy_generator.hpp>
 #include <lib/matrix_game.hpp>
+#include <lib/profiling.hpp>
+#include <lib/telemetry.hpp>
 
 using namespace TreeAndHistoryTraversal;
 using namespace PolicyGenerator;
 using namespace MatrixGame;
 
-static void runPerturbedCfrWithNoiseAndExploitabilityThreshold(double noise, size_t randomSeed, double exploitability = 1e-4) {
+/**
+ * Prints per-call averages over the last profiling block as a comment line.
+ */
+static void printProfile(const char* name, size_t t,
+                         const Profiling::Sample& sample) {
+  if (sample.hasHardwareCounters) {
+    printf("# %-18s%20zu%14.1lf us%14.0lf cycles%8.2lf IPC"
+           "%12.2lf cache-misses%12.2lf branch-misses\n",
+           name, t, sample.perCall(sample.seconds * 1e6),
+           sample.perCall(sample.cycles), sample.instructionsPerCycle(),
+           sample.perCall(sample.cacheMisses),
+           sample.perCall(sample.branchMisses));
+  } else {
+    printf("# %-18s%20zu%14.1lf us\n", name, t,
+           sample.perCall(sample.seconds * 1e6));
+  }
+}
+
+/**
+ * When telemetry is given, every iteration is recorded there as run
+ * number, run, instead of printing progress lines.
+ */
+static void runPerturbedCfrWithNoiseAndExploitabilityThreshold(double noise, size_t randomSeed, size_t profileBlockSize = 0, Telemetry::Sink* telemetry = nullptr, uint32_t run = 0, double exploitability = 1e-4) {
   const std::vector<size_t> numActionsAtEachInfoSet{2};
   std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
   const auto altPolicyGeneratorProfileFactory = [&]() {
     return std::vector<
         PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric> *>{
-      new PerturbedPolicyRegretMatchingTable(
+      new PerturbedPolicyRegretMatchingTable<Numeric>(
           NUM_SEQUENCES, numActionsAtEachInfoSet,
           NUM_SEQUENCES_BEFORE_EACH_INFO_SET, noise, randomSeed),
-              new PerturbedPolicyRegretMatchingTable(
+              new PerturbedPolicyRegretMatchingTable<Numeric>(
                   NUM_SEQUENCES, numActionsAtEachInfoSet,
                   NUM_SEQUENCES_BEFORE_EACH_INFO_SET, noise, randomSeed)};
   };
   const auto averageGeneratorProfileFactory = [&]() {
     return std::vector<
         PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
-        new AverageStrategyTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                 NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
-        new AverageStrategyTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                 NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
   };
+  auto policyGeneratorProfile = altPolicyGeneratorProfileFactory();
+  std::vector<const PerturbedPolicyRegretMatchingTable<Numeric>*> tables;
+  for (auto policyGenerator : policyGeneratorProfile) {
+    tables.push_back(
+        static_cast<const PerturbedPolicyRegretMatchingTable<Numeric>*>(
+            policyGenerator));
+  }
   Cfr<size_t, std::pair<size_t, size_t>, Numeric> patient(
-      utilsForPlayer1, altPolicyGeneratorProfileFactory(),
+      utilsForPlayer1, std::move(policyGeneratorProfile),
       averageGeneratorProfileFactory());
+  const auto start = std::chrono::steady_clock::now();
+  Profiling::Profiler cfrProfiler;
+  Profiling::Profiler bestResponseProfiler;
   size_t t = 1;
   while (true) {
-    patient.doIteration();
-    if (patient.averageExploitability() < exploitability) {
-      printf("%20lg%20zu%20lg\n", noise, t, patient.averageExploitability());
-      fflush(NULL);
-
-      if (patient.averageExploitability() < exploitability) {
-        return;
+    double averageExploitability;
+    if (profileBlockSize > 0) {
+      cfrProfiler.measure([&]() { patient.doIteration(); });
+      bestResponseProfiler.measure([&]() {
+        averageExploitability = patient.averageExploitability();
+      });
+      if (t % profileBlockSize == 0) {
+        printProfile("Cfr::doIteration", t, cfrProfiler.total());
+        printProfile("averageExploit.", t, bestResponseProfiler.total());
+        cfrProfiler.clearTotal();
+        bestResponseProfiler.clearTotal();
       }
+    } else {
+      patient.doIteration();
+      averageExploitability = patient.averageExploitability();
     }
-    else if (t % 100000 == 0) {
-      printf("#%19lg%20zu%20lg\n", noise, t, patient.averageExploitability());
+    if (telemetry) {
+      Telemetry::Record record;
+      record.run = run;
+      record.iteration = t;
+      record.seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      record.exploitability = averageExploitability;
+      record.numRegretsSmallerThanNoise = 0;
+      for (auto table : tables) {
+        record.numRegretsSmallerThanNoise +=
+            table->numRegretsSmallerThanNoise();
+      }
+      telemetry->record(record);
+    }
+    if (averageExploitability < exploitability) {
+      printf("%20lg%20zu%20lg\n", noise, t, averageExploitability);
+      printf("%s",
+             MemoryAccounting::format(patient.memoryBreakdown(), "# ").c_str());
+      fflush(NULL);
+      return;
+    }
+    else if (!telemetry && t % 100000 == 0) {
+      printf("#%19lg%20zu%20lg\n", noise, t, averageExploitability);
       fflush(NULL);
     }
     ++t;
@@ -53,12 +121,31 @@ static void runPerturbedCfrWithNoiseAndExploitabilityThreshold(double noise, siz
 
 int main(int argc, char** argv) {
   size_t seed = (argc < 2) ? 3839203241 : std::stoul(std::string(argv[1]));
-  runPerturbedCfrWithNoiseAndExploitabilityThreshold(0, 0);
+  // Print hardware counters (or wall-clock time where they are unavailable)
+  // for every block of this many iterations. Zero disables profiling.
+  size_t profileBlockSize =
+      (argc < 3) ? 0 : std::stoul(std::string(argv[2]));
+  // Record every iteration to this CSV file rather than printing progress.
+  std::unique_ptr<Telemetry::Sink> telemetry(
+      (argc < 4) ? nullptr : new Telemetry::Sink(argv[3]));
+  Profiling::Profiler probe;
+  if (profileBlockSize > 0 && !probe.hasHardwareCounters()) {
+    printf("# Hardware counters unavailable; profiling wall-clock time only\n");
+  }
+  uint32_t run = 0;
+  runPerturbedCfrWithNoiseAndExploitabilityThreshold(
+      0, 0, profileBlockSize, telemetry.get(), run++);
   double noise = 0.1;
   for (size_t i = 0; i < 4; ++i) {
-    runPerturbedCfrWithNoiseAndExploitabilityThreshold(noise, seed);
+    runPerturbedCfrWithNoiseAndExploitabilityThreshold(
+        noise, seed, profileBlockSize, telemetry.get(), run++);
     noise *= 5;
-    runPerturbedCfrWithNoiseAndExploitabilityThreshold(noise, seed);
+    runPerturbedCfrWithNoiseAndExploitabilityThreshold(
+        noise, seed, profileBlockSize, telemetry.get(), run++);
     noise *= 2;
   }
+  if (telemetry && telemetry->numDropped() > 0) {
+    fprintf(stderr, "Dropped %zu telemetry records\n",
+            telemetry->numDropped());
+  }
 }
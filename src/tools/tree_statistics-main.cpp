@@ -0,0 +1,43 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include <lib/memory_accounting.hpp>
+#include <lib/poker.hpp>
+#include <lib/tree_statistics.hpp>
+
+using namespace TreeAndHistoryTraversal;
+
+template <typename HistoryType>
+void printStatistics(const HistoryType& root,
+                     const TreeStatistics::Options& options) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto stats = TreeStatistics::profile(root, options);
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  printf("%s", stats.report().c_str());
+  printf("CFR memory with double tables:\n%s",
+         MemoryAccounting::format(stats.memoryBreakdown(), "  ").c_str());
+  printf("# %zu threads, %zu samples, %.3lf s\n", options.numThreads,
+         options.numSamples, seconds);
+}
+
+int main(int argc, char** argv) {
+  const std::string game = (argc < 2) ? "leduc" : argv[1];
+  TreeStatistics::Options options;
+  options.numThreads = (argc < 3) ? 1 : std::stoul(std::string(argv[2]));
+  // Zero walks every history.
+  options.numSamples = (argc < 4) ? 0 : std::stoul(std::string(argv[3]));
+  options.splitDepth = (argc < 5) ? 2 : std::stoul(std::string(argv[4]));
+
+  if (game == "kuhn") {
+    printStatistics(Poker::KuhnPokerHistory(), options);
+  } else if (game == "leduc") {
+    printStatistics(Poker::LeducHoldemHistory(), options);
+  } else {
+    fprintf(stderr, "Usage: %s [kuhn|leduc] [threads] [samples] [split]\n",
+            argv[0]);
+    return 1;
+  }
+}
@@ -8,4 +8,51 @@
                           // in one cpp file
 #include <catch.hpp>
 
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <lib/policy_generator.hpp>
+
+namespace TreeAndHistoryTraversal {
+namespace Test {
+/**
+ * One regret matching table per player, laid out by game's information
+ * sets. game may be a SequenceForm::CompiledGame or a VectorForm::PublicTree.
+ */
+template <typename Numeric, typename Game>
+std::vector<PolicyGenerator::PolicyGenerator<size_t,
+                                             std::pair<size_t, size_t>,
+                                             Numeric>*>
+newRegretTables(const Game& game) {
+  std::vector<PolicyGenerator::PolicyGenerator<
+      size_t, std::pair<size_t, size_t>, Numeric>*>
+      profile;
+  for (size_t player = 0; player < game.numActionsAtEachInfoSet.size();
+       ++player) {
+    profile.push_back(new PolicyGenerator::RegretMatchingTable<Numeric>(
+        game.numSequences(player), game.numActionsAtEachInfoSet[player],
+        game.numSequencesBeforeEachInfoSet[player]));
+  }
+  return profile;
+}
+
+/**
+ * A Solver, such as SequenceForm::Cfr or VectorForm::Cfr, with fresh regret
+ * and average strategy tables. args follow the tables in Solver's
+ * constructor.
+ */
+template <template <typename> class Solver,
+          typename Numeric = double,
+          typename Game,
+          typename... Args>
+std::unique_ptr<Solver<Numeric>> newCfr(const Game& game, Args&&... args) {
+  return std::unique_ptr<Solver<Numeric>>(
+      new Solver<Numeric>(game, newRegretTables<Numeric>(game),
+                          newRegretTables<Numeric>(game),
+                          std::forward<Args>(args)...));
+}
+}
+}
+
 #endif
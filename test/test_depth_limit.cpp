@@ -0,0 +1,160 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/depth_limit.hpp>
+#include <lib/history_tree_node.hpp>
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+/**
+ * Player 0's mean utility over every legal successor.
+ */
+class MeanUtility : public HistoryTreeNode::HistoryTreeNode<double,
+                                                             std::string> {
+ public:
+  MeanUtility(Poker::KuhnPokerHistory* history)
+      : HistoryTreeNode::HistoryTreeNode<double, std::string>(
+            static_cast<History::History<std::string>*>(history)),
+        kuhn_(history) {}
+
+ protected:
+  virtual double terminalValue() override { return kuhn_->utility(0); }
+  virtual double interiorValue() override {
+    double total = 0.0;
+    size_t n = 0;
+    history_->eachSuccessor([&](size_t, size_t) {
+      total += value();
+      ++n;
+      return false;
+    });
+    return total / n;
+  }
+
+  const Poker::KuhnPokerHistory* kuhn_;
+};
+
+SCENARIO("Depth-limited history traversals") {
+  MeanUtility traversal(new Poker::KuhnPokerHistory());
+  const auto fullValue = traversal.value();
+  size_t numEstimates = 0;
+  const DepthLimit::FunctionEstimator<History::History<std::string>, double>
+      zero([&](const History::History<std::string>&) {
+        ++numEstimates;
+        return 0.0;
+      });
+
+  GIVEN("Limits that are never reached") {
+    traversal.limitTraversals(DepthLimit::Limits(100), &zero);
+    THEN("The value is unchanged") {
+      CHECK(traversal.value() == Approx(fullValue));
+      CHECK(numEstimates == 0);
+    }
+  }
+  GIVEN("A depth limit below the deal") {
+    traversal.limitTraversals(DepthLimit::Limits(2), &zero);
+    THEN("Each of the six deals is estimated instead of expanded") {
+      CHECK(traversal.value() == 0.0);
+      CHECK(numEstimates == 6);
+      CHECK(traversal.history()->isEmpty());
+    }
+  }
+  GIVEN("A node budget") {
+    traversal.limitTraversals(DepthLimit::Limits(SIZE_MAX, 3), &zero);
+    THEN("Every pass expands the first three nodes in preorder") {
+      // The root, J, and J-Q are expanded. J-Q's two actions, J-K, Q, and K
+      // are estimated.
+      traversal.value();
+      CHECK(numEstimates == 5);
+      traversal.value();
+      CHECK(numEstimates == 10);
+    }
+  }
+  GIVEN("Limits without an estimator") {
+    THEN("They are rejected") {
+      CHECK_THROWS_AS(traversal.limitTraversals(DepthLimit::Limits(2),
+                                                nullptr),
+                      std::invalid_argument);
+    }
+  }
+}
+
+SCENARIO("Depth-limited CFR and best responses on Leduc hold'em") {
+  Poker::LeducHoldemHistory root;
+  const auto game = SequenceForm::compile(&root);
+  auto blueprint = Test::newCfr<SequenceForm::Cfr>(game);
+  blueprint->doIterations(100);
+  const auto blueprintProfile = blueprint->strategyProfile();
+  const DepthLimit::TableEstimator<std::vector<double>> estimator(
+      SequenceForm::nodeValues(game, blueprintProfile));
+
+  GIVEN("The blueprint's values at every node") {
+    THEN("The root's are the blueprint's expected utilities") {
+      const auto expected =
+          SequenceForm::expectedUtilities(game, blueprintProfile);
+      CHECK(estimator.estimate(0)[0] == Approx(expected[0]));
+      CHECK(estimator.estimate(0)[1] == Approx(expected[1]));
+      CHECK(estimator.estimate(0, 0) == Approx(expected[0]));
+      CHECK(estimator.estimate(0, 1) == Approx(expected[1]));
+    }
+  }
+  GIVEN("A depth limit at the first round's betting") {
+    // The deal takes two edges, and the first round at most four.
+    const DepthLimit::Limits limits(4);
+    THEN("Limited best responses lie between the profile's value and the "
+         "full best responses") {
+      const auto value =
+          SequenceForm::expectedUtilities(game, blueprintProfile);
+      const auto limited =
+          SequenceForm::BestResponse<>(game, blueprintProfile, limits,
+                                       &estimator)
+              .valueProfile();
+      const auto full =
+          SequenceForm::BestResponse<>(game, blueprintProfile).valueProfile();
+      for (size_t i = 0; i < 2; ++i) {
+        CHECK(limited[i] >= value[i] - 1e-9);
+        CHECK(limited[i] <= full[i] + 1e-9);
+      }
+      CHECK(limited[0] < full[0]);
+    }
+    THEN("CFR only updates information sets above the limit") {
+      auto cfr = Test::newCfr<SequenceForm::Cfr>(game, limits, &estimator);
+      cfr->doIterations(50);
+      const auto profile = cfr->strategyProfile();
+      size_t numUpdated = 0;
+      for (size_t I = 0; I < game.numInfoSets(0); ++I) {
+        const auto& name = game.infoSetNames[0][I];
+        const auto* sigma_I =
+            &profile[0][game.numSequencesBeforeEachInfoSet[0][I]];
+        const bool isUniform =
+            sigma_I[0] == Approx(1.0 / game.numActionsAtEachInfoSet[0][I]);
+        if (name.find('/') != std::string::npos) {
+          CHECK(isUniform);
+        } else if (!isUniform) {
+          ++numUpdated;
+        }
+      }
+      CHECK(numUpdated > 0);
+      CHECK(cfr->averageExploitability() < 0.1);
+    }
+  }
+  GIVEN("Limits that are never reached") {
+    auto limited = Test::newCfr<SequenceForm::Cfr>(
+        game, DepthLimit::Limits(100), &estimator);
+    auto full = Test::newCfr<SequenceForm::Cfr>(game);
+    limited->doIterations(10);
+    full->doIterations(10);
+    THEN("CFR matches the unlimited solver") {
+      CHECK(limited->strategyProfile() == full->strategyProfile());
+    }
+  }
+}
@@ -1,7 +1,10 @@
 #include <cstdio>
 #include <cstring>
 #include <unistd.h>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <test_helper.hpp>
 
@@ -22,6 +25,9 @@ class TestStringHistory : public StringHistory {
       : StringHistory::StringHistory(std::move(allLegalStrings)),
         isLegal_(isLegal) {}
   virtual ~TestStringHistory() {}
+  virtual TestStringHistory* clone() const override {
+    return new TestStringHistory(*this);
+  }
 
   virtual bool suffixIsLegal(const std::string& candidate) const override {
     return isLegal_(*this, candidate);
@@ -152,3 +158,120 @@ SCENARIO("Walking a string history") {
     }
   }
 }
+
+SCENARIO("Cloning a string history") {
+  GIVEN("A history partway down the tree") {
+    TestStringHistory patient(
+        {"a", "b", "c"},
+        [](const TestStringHistory& prefix, const std::string&) {
+          return prefix.toString().size() < 12;
+        });
+    patient.push("a");
+    patient.push("b");
+    std::unique_ptr<TestStringHistory> clone(patient.clone());
+    THEN("The clone starts where the original is") {
+      REQUIRE("a -> b" == clone->toString());
+      REQUIRE("b" == clone->last());
+    }
+    THEN("Each is pushed and popped independently of the other") {
+      clone->push("c");
+      patient.pop();
+      patient.push("a");
+      REQUIRE("a -> b -> c" == clone->toString());
+      REQUIRE("a -> a" == patient.toString());
+      clone->pop();
+      clone->pop();
+      clone->push("c");
+      REQUIRE("a -> c" == clone->toString());
+      REQUIRE("a -> a" == patient.toString());
+    }
+    THEN("The original outlives its clone") {
+      patient.pop();
+      clone.reset();
+      patient.push("c");
+      REQUIRE("a -> c" == patient.toString());
+      patient.pop();
+      patient.pop();
+      REQUIRE(patient.isEmpty());
+    }
+    THEN("Clones are pushed and popped on other threads") {
+      std::unique_ptr<TestStringHistory> other(clone->clone());
+      const auto walk = [](TestStringHistory* h, const std::string& symbol) {
+        for (size_t i = 0; i < 1000; ++i) {
+          h->push(symbol);
+          h->pop();
+          h->pop();
+          h->push(symbol);
+        }
+      };
+      std::thread first(walk, clone.get(), "a");
+      std::thread second(walk, other.get(), "c");
+      walk(&patient, "b");
+      first.join();
+      second.join();
+      REQUIRE("a -> a" == clone->toString());
+      REQUIRE("a -> c" == other->toString());
+      REQUIRE("a -> b" == patient.toString());
+    }
+    THEN("Clones traverse the same subtree") {
+      size_t numFromOriginal = 0;
+      size_t numFromClone = 0;
+      patient.eachSuccessor([&](size_t, size_t) {
+        ++numFromOriginal;
+        return false;
+      });
+      clone->eachSuccessor([&](size_t, size_t) {
+        ++numFromClone;
+        return false;
+      });
+      REQUIRE(numFromOriginal == 3);
+      REQUIRE(numFromClone == numFromOriginal);
+    }
+  }
+}
+
+SCENARIO("Pulling legal suffixes") {
+  GIVEN("A history with some illegal suffixes") {
+    TestStringHistory patient(
+        {"a", "b", "c"},
+        [](const TestStringHistory& prefix, const std::string& candidate) {
+          return prefix.isEmpty() ? candidate != "b" : candidate == "c";
+        });
+    THEN("They match the legal suffixes given by callback") {
+      std::vector<size_t> fromCallback;
+      patient.eachLegalSuffix([&](std::string&&, size_t suffixIndex, size_t) {
+        fromCallback.push_back(suffixIndex);
+        return false;
+      });
+      const auto legal = patient.legalSuffixes();
+      REQUIRE(legal.size() == 2);
+      REQUIRE(std::vector<size_t>(legal.begin(), legal.end()) ==
+              fromCallback);
+      REQUIRE(patient.suffix(legal[1]) == "c");
+    }
+    THEN("Pushing them by index walks the same successors") {
+      std::vector<std::string> visited;
+      for (const auto suffixIndex : patient.legalSuffixes()) {
+        patient.pushSuffix(suffixIndex);
+        for (const auto childSuffixIndex : patient.legalSuffixes()) {
+          patient.pushSuffix(childSuffixIndex);
+          visited.push_back(patient.toString());
+          patient.pop();
+        }
+        patient.pop();
+      }
+      REQUIRE(visited == std::vector<std::string>{"a -> c", "c -> c"});
+      REQUIRE(patient.isEmpty());
+    }
+  }
+  GIVEN("More legal suffixes than fit") {
+    std::vector<std::string> alphabet;
+    for (size_t i = 0; i <= LegalSuffixes::CAPACITY; ++i) {
+      alphabet.push_back(std::to_string(i));
+    }
+    TestStringHistory patient(
+        std::move(alphabet),
+        [](const TestStringHistory&, const std::string&) { return true; });
+    THEN("Pulling them throws") { REQUIRE_THROWS(patient.legalSuffixes()); }
+  }
+}
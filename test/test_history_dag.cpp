@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/history_dag.hpp>
+#include <lib/poker.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+/**
+ * numFlips coin flips, worth the number of heads.
+ */
+class CoinFlipHistory : public History::StringHistory {
+ public:
+  CoinFlipHistory(size_t numFlips)
+      : StringHistory({"H", "T"}),
+        numFlips_(numFlips) {}
+  virtual ~CoinFlipHistory() {}
+
+  virtual bool suffixIsLegal(const std::string&) const override {
+    return state_.size() < numFlips_;
+  }
+  double numHeads() const {
+    return std::count(state_.begin(), state_.end(), "H");
+  }
+
+ protected:
+  const size_t numFlips_;
+};
+
+static double sum(size_t, const std::vector<double>& childValues) {
+  double total = 0.0;
+  for (const auto v : childValues) {
+    total += v;
+  }
+  return total;
+}
+
+SCENARIO("Merging identical subtrees") {
+  GIVEN("Four coin flips") {
+    CoinFlipHistory root(4);
+    const auto dag = HistoryDag::build<std::string, double>(
+        &root, [&root](History::History<std::string>*) {
+          return root.numHeads();
+        });
+    THEN("Only the number of heads so far distinguishes subtrees") {
+      CHECK(root.isEmpty());
+      CHECK(dag.numTreeNodes == 31);
+      CHECK(dag.numNodes() == 15);
+      CHECK(dag.children.size() == 20);
+      CHECK(dag.compressionRatio() == Approx(31.0 / 15));
+      CHECK(dag.report() ==
+            "31 tree nodes and 30 edges in 15 DAG nodes and 20 edges "
+            "(2.07x)");
+    }
+    THEN("Children precede their parents and keep their suffixes") {
+      const auto top = dag.root();
+      CHECK(dag.numChildren(top) == 2);
+      CHECK(dag.suffix(top, 0) == "H");
+      CHECK(dag.suffix(top, 1) == "T");
+      CHECK(dag.child(top, 0) < top);
+      CHECK(dag.child(dag.child(top, 0), 1) ==
+            dag.child(dag.child(top, 1), 0));
+    }
+    THEN("Evaluation visits each distinct subtree once") {
+      size_t numInteriorVisits = 0;
+      const auto total = dag.evaluate(
+          [&](size_t node, const std::vector<double>& childValues) {
+            ++numInteriorVisits;
+            return sum(node, childValues);
+          });
+      CHECK(total == 4 * 8);
+      CHECK(numInteriorVisits == 10);
+    }
+  }
+  GIVEN("Kuhn poker") {
+    Poker::KuhnPokerHistory root;
+    const auto dag = HistoryDag::build<std::string, double>(
+        &root, [&root](History::History<std::string>*) {
+          return root.utility(0);
+        });
+    THEN("Deals with the same winner share their betting subtrees") {
+      CHECK(dag.numTreeNodes == 58);
+      CHECK(dag.compressionRatio() > 2);
+      // Betting after J-Q, J-K, and Q-K is identical.
+      const auto jack = dag.child(dag.root(), 0);
+      const auto queen = dag.child(dag.root(), 1);
+      CHECK(dag.child(jack, 0) == dag.child(jack, 1));
+      CHECK(dag.child(jack, 0) == dag.child(queen, 1));
+    }
+    THEN("It has the same value as the tree") {
+      const auto mean = [](size_t, const std::vector<double>& childValues) {
+        return sum(0, childValues) / childValues.size();
+      };
+      std::function<double()> treeValue = [&]() {
+        if (!root.hasSuccessors()) {
+          return root.utility(0);
+        }
+        std::vector<double> childValues;
+        root.eachSuccessor([&](size_t, size_t) {
+          childValues.push_back(treeValue());
+          return false;
+        });
+        return mean(0, childValues);
+      };
+      CHECK(dag.evaluate(mean) == Approx(treeValue()));
+    }
+  }
+}
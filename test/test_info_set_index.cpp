@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/info_set_index.hpp>
+#include <lib/poker.hpp>
+#include <lib/sequence_form.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+SCENARIO("Indexing information sets with a perfect hash") {
+  GIVEN("Leduc hold'em's information sets") {
+    Poker::LeducHoldemHistory root;
+    const auto game = SequenceForm::compile(&root);
+    const auto patient = InfoSetIndex::indexInfoSets(game);
+    THEN("Each name maps to its compiled index") {
+      REQUIRE(patient.size() == 2);
+      for (size_t player = 0; player < 2; ++player) {
+        const auto& names = game.infoSetNames[player];
+        REQUIRE(patient[player].size() == names.size());
+        size_t numMismatches = 0;
+        for (size_t I = 0; I < names.size(); ++I) {
+          numMismatches += patient[player][names[I]] != I ||
+                           patient[player].find(names[I]) != I ||
+                           patient[player].key(I) != names[I];
+        }
+        CHECK(numMismatches == 0);
+      }
+    }
+    THEN("Unknown names are not found") {
+      CHECK(patient[0].find("not an information set") ==
+            InfoSetIndex::NOT_FOUND);
+      CHECK(patient[0].find(game.infoSetNames[1][0]) ==
+            InfoSetIndex::NOT_FOUND);
+    }
+  }
+  GIVEN("An empty index") {
+    const InfoSetIndex::PerfectHashIndex patient;
+    THEN("Nothing is found") {
+      CHECK(patient.size() == 0);
+      CHECK(patient.find("") == InfoSetIndex::NOT_FOUND);
+    }
+  }
+  GIVEN("Repeated keys") {
+    THEN("The build fails") {
+      CHECK_THROWS_AS(InfoSetIndex::PerfectHashIndex({"a", "b", "a"}),
+                      std::runtime_error);
+    }
+  }
+}
+
+SCENARIO("Indexing information sets as they are discovered") {
+  GIVEN("Threads that look up overlapping keys") {
+    InfoSetIndex::ShardedIndex patient(8);
+    const size_t numKeys = 1000;
+    std::vector<std::vector<size_t>> rowsByThread(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < rowsByThread.size(); ++t) {
+      threads.emplace_back([&patient, &rowsByThread, t, numKeys]() {
+        for (size_t k = 0; k < numKeys; ++k) {
+          // Each thread starts at a different key
+          const auto key = (k + t * numKeys / 4) % numKeys;
+          rowsByThread[t].push_back(patient[std::to_string(key)]);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    THEN("Every key has one dense row") {
+      REQUIRE(patient.size() == numKeys);
+      std::vector<size_t> numKeysAtRow(numKeys, 0);
+      size_t numMismatches = 0;
+      for (size_t key = 0; key < numKeys; ++key) {
+        const auto row = patient.find(std::to_string(key));
+        REQUIRE(row < numKeys);
+        ++numKeysAtRow[row];
+        for (size_t t = 0; t < rowsByThread.size(); ++t) {
+          numMismatches +=
+              rowsByThread[t][(key + numKeys - t * numKeys / 4) % numKeys] !=
+              row;
+        }
+      }
+      CHECK(numMismatches == 0);
+      CHECK(std::count(numKeysAtRow.begin(), numKeysAtRow.end(), 1) ==
+            static_cast<long>(numKeys));
+      CHECK(patient.find("unseen") == InfoSetIndex::NOT_FOUND);
+    }
+    THEN("Freezing keeps the rows") {
+      const auto frozen = patient.freeze();
+      REQUIRE(frozen.size() == numKeys);
+      size_t numMismatches = 0;
+      for (size_t key = 0; key < numKeys; ++key) {
+        const auto k = std::to_string(key);
+        numMismatches += frozen[k] != patient.find(k);
+      }
+      CHECK(numMismatches == 0);
+      CHECK(patient.memoryUsage().liveBytes > frozen.memoryUsage().liveBytes);
+    }
+  }
+}
@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TREE_AND_HISTORY_TRAVERSAL_INSTRUMENT
+#include <test_helper.hpp>
+
+#include <lib/history_tree_node.hpp>
+#include <lib/matrix_game.hpp>
+#include <lib/tree_node.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+static TreeNode::TreeNode<int>* binaryTree(size_t depth) {
+  if (depth == 0) {
+    return new TreeNode::StoredTerminalNode<int>(1);
+  }
+  return new TreeNode::StoredInteriorNode<int>(
+      {binaryTree(depth - 1), binaryTree(depth - 1)},
+      [](int childValue) { return childValue; });
+}
+
+SCENARIO("Counting traversal work") {
+  REQUIRE(Instrumentation::enabled);
+  GIVEN("A complete binary tree of depth three") {
+    TreeNode::TreeNode<int>* root = binaryTree(3);
+    Instrumentation::reset();
+    root->value();
+    THEN("Every node and level is counted") {
+      const auto c = Instrumentation::snapshot();
+      CHECK(c.nodesVisited == 15);
+      CHECK(c.terminalEvaluations == 8);
+      CHECK(c.interiorEvaluations == 7);
+      CHECK(c.maxDepth == 4);
+      CHECK(c.successorEnumerations == 0);
+    }
+    THEN("Resetting clears the counters") {
+      Instrumentation::reset();
+      const auto c = Instrumentation::snapshot();
+      CHECK(c.nodesVisited == 0);
+      CHECK(c.maxDepth == 0);
+    }
+    THEN("Counts from other threads are merged, even after they exit") {
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < 3; ++i) {
+        threads.emplace_back([root]() { root->value(); });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      const auto c = Instrumentation::snapshot();
+      CHECK(c.nodesVisited == 4 * 15);
+      CHECK(c.maxDepth == 4);
+    }
+    delete root;
+  }
+  GIVEN("CFR on matching pennies") {
+    typedef PolicyGenerator::PolicyGenerator<size_t, std::pair<size_t, size_t>>
+        Generator;
+    const std::vector<size_t> numActionsAtEachInfoSet{2};
+    const std::vector<std::vector<int>> utilsForPlayer1{{1, -1}, {-1, 1}};
+    std::vector<Generator*> policyGeneratorProfile;
+    std::vector<Generator*> averageGeneratorProfile;
+    for (size_t i = 0; i < 2; ++i) {
+      policyGeneratorProfile.push_back(
+          new PolicyGenerator::RegretMatchingTable<>(
+              MatrixGame::NUM_SEQUENCES, numActionsAtEachInfoSet,
+              MatrixGame::NUM_SEQUENCES_BEFORE_EACH_INFO_SET));
+      averageGeneratorProfile.push_back(
+          new PolicyGenerator::AverageStrategyTable<>(
+              MatrixGame::NUM_SEQUENCES, numActionsAtEachInfoSet,
+              MatrixGame::NUM_SEQUENCES_BEFORE_EACH_INFO_SET));
+    }
+    THEN("An alternating iteration evaluates each terminal once per "
+         "opponent decision") {
+      MatrixGame::Cfr<size_t, std::pair<size_t, size_t>, double> patient(
+          utilsForPlayer1, std::move(policyGeneratorProfile),
+          std::move(averageGeneratorProfile));
+      Instrumentation::reset();
+      patient.doIteration();
+      const auto c = Instrumentation::snapshot();
+      CHECK(c.nodesVisited == 5);
+      CHECK(c.terminalEvaluations == 2);
+      CHECK(c.interiorEvaluations == 3);
+      CHECK(c.maxDepth == 3);
+      CHECK(c.successorEnumerations == 3);
+      CHECK(c.policyCalls == 3);
+      CHECK(c.updateCalls > 0);
+    }
+    THEN("A simultaneous iteration visits every history once") {
+      MatrixGame::Cfr<size_t, std::pair<size_t, size_t>, double> patient(
+          utilsForPlayer1, std::move(policyGeneratorProfile),
+          std::move(averageGeneratorProfile),
+          MatrixGame::UpdateMode::SIMULTANEOUS);
+      Instrumentation::reset();
+      patient.doIteration();
+      const auto c = Instrumentation::snapshot();
+      CHECK(c.nodesVisited == 7);
+      CHECK(c.terminalEvaluations == 4);
+      CHECK(c.interiorEvaluations == 3);
+      CHECK(c.maxDepth == 3);
+      CHECK(c.successorEnumerations == 3);
+      CHECK(c.policyCalls == 2);
+    }
+  }
+}
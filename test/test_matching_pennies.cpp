@@ -29,18 +29,20 @@ SCENARIO("CFR on matching pennies") {
   const auto averageGeneratorProfileFactory = [&]() {
     return std::vector<
         PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
-        new AverageStrategyTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                 NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
-        new AverageStrategyTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                 NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
   };
   const auto policyGeneratorProfileFactory = [&]() {
     return std::vector<
         PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
-        new RegretMatchingTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
-        new RegretMatchingTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+        new RegretMatchingTable<Numeric>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                         NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new RegretMatchingTable<Numeric>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                         NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
   };
   GIVEN("Traditional terminal values") {
     std::vector<std::vector<int>> utilsForPlayer1{{1, -1}, {-1, 1}};
@@ -110,18 +112,22 @@ SCENARIO("CFR+ on matching pennies") {
   const auto averageGeneratorProfileFactory = [&]() {
     return std::vector<
         PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
-        new AverageStrategyTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                 NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
-        new AverageStrategyTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                 NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
   };
   const auto policyGeneratorProfileFactory = [&]() {
     return std::vector<
         PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
-        new RegretMatchingPlusTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                    NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
-        new RegretMatchingPlusTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                    NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+        new RegretMatchingPlusTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new RegretMatchingPlusTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
   };
   GIVEN("Traditional terminal values") {
     std::vector<std::vector<int>> utilsForPlayer1{{1, -1}, {-1, 1}};
@@ -191,18 +197,20 @@ SCENARIO("perturbed CFR on matching pennies") {
   const auto averageGeneratorProfileFactory = [&]() {
     return std::vector<
         PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
-        new AverageStrategyTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                 NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
-        new AverageStrategyTable(NUM_SEQUENCES, numActionsAtEachInfoSet,
-                                 NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
   };
   const auto policyGeneratorProfileFactory = [&]() {
     return std::vector<
         PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
-        new PerturbedPolicyRegretMatchingTable(
+        new PerturbedPolicyRegretMatchingTable<Numeric>(
             NUM_SEQUENCES, numActionsAtEachInfoSet,
             NUM_SEQUENCES_BEFORE_EACH_INFO_SET, 0.1),
-        new PerturbedPolicyRegretMatchingTable(
+        new PerturbedPolicyRegretMatchingTable<Numeric>(
             NUM_SEQUENCES, numActionsAtEachInfoSet,
             NUM_SEQUENCES_BEFORE_EACH_INFO_SET, 0.1)};
   };
@@ -262,10 +270,10 @@ SCENARIO("perturbed CFR on matching pennies") {
         const auto altPolicyGeneratorProfileFactory = [&]() {
           return std::vector<
               PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
-              new PerturbedPolicyRegretMatchingTable(
+              new PerturbedPolicyRegretMatchingTable<Numeric>(
                   NUM_SEQUENCES, numActionsAtEachInfoSet,
                   NUM_SEQUENCES_BEFORE_EACH_INFO_SET, 1),
-              new PerturbedPolicyRegretMatchingTable(
+              new PerturbedPolicyRegretMatchingTable<Numeric>(
                   NUM_SEQUENCES, numActionsAtEachInfoSet,
                   NUM_SEQUENCES_BEFORE_EACH_INFO_SET, 1)};
         };
@@ -284,3 +292,199 @@ SCENARIO("perturbed CFR on matching pennies") {
     }
   }
 }
+
+SCENARIO("Single precision CFR on matching pennies") {
+  const auto averageGeneratorProfileFactory = [&]() {
+    return std::vector<
+        PolicyGenerator<size_t, std::pair<size_t, size_t>, float>*>{
+        new AverageStrategyTable<float>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                        NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new AverageStrategyTable<float>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                        NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+  };
+  const auto policyGeneratorProfileFactory = [&]() {
+    return std::vector<
+        PolicyGenerator<size_t, std::pair<size_t, size_t>, float>*>{
+        new RegretMatchingPlusTable<float>(NUM_SEQUENCES,
+                                           numActionsAtEachInfoSet,
+                                           NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new RegretMatchingPlusTable<float>(NUM_SEQUENCES,
+                                           numActionsAtEachInfoSet,
+                                           NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+  };
+  GIVEN("Alternative terminal values #3") {
+    std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
+    THEN("CFR finds the equilibrium properly") {
+      Cfr<size_t, std::pair<size_t, size_t>, float> patient(
+          utilsForPlayer1, policyGeneratorProfileFactory(),
+          averageGeneratorProfileFactory());
+      patient.doIterations(5e4);
+      CHECK(patient.strategyProfile()[0][0] == Approx(7.0 / 11).epsilon(0.001));
+      CHECK(patient.strategyProfile()[1][0] == Approx(5 / 11.0).epsilon(0.001));
+      CHECK(patient.averageExploitability() < 1e-3);
+    }
+  }
+}
+
+SCENARIO("Best response on matching pennies") {
+  std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
+  const std::vector<std::vector<Numeric>> uniformProfile{{0.5, 0.5},
+                                                         {0.5, 0.5}};
+  GIVEN("A uniform strategy profile") {
+    THEN("Each player's best response value is correct") {
+      BestResponse<Numeric> patient(utilsForPlayer1, uniformProfile);
+      const auto brValues = patient.valueProfile();
+      CHECK(brValues[0] == Approx(0.0));
+      CHECK(brValues[1] == Approx(1.0));
+      CHECK(patient.averageExploitability() == Approx(0.5));
+
+      const auto brProfile = patient.strategyProfile();
+      CHECK(brProfile[0][0] == 1.0);
+      CHECK(brProfile[0][1] == 0.0);
+      CHECK(brProfile[1][0] == 1.0);
+      CHECK(brProfile[1][1] == 0.0);
+    }
+    THEN("Computing both best responses concurrently gives the same answer") {
+      BestResponse<Numeric> sequential(utilsForPlayer1, uniformProfile);
+      BestResponse<Numeric> concurrent(utilsForPlayer1, uniformProfile, true);
+      CHECK(concurrent.valueProfile() == sequential.valueProfile());
+      CHECK(concurrent.strategyProfile() == sequential.strategyProfile());
+    }
+  }
+}
+
+SCENARIO("Sampled best response on matching pennies") {
+  std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
+  GIVEN("A uniform strategy profile") {
+    const std::vector<std::vector<Numeric>> uniformProfile{{0.5, 0.5},
+                                                           {0.5, 0.5}};
+    THEN("The confidence interval covers the exact exploitability") {
+      Game::SampledBestResponse<MatrixGameHistory, Numeric> patient(
+          MatrixGameHistory(utilsForPlayer1), policyOf(uniformProfile),
+          SamplingOptions(20000));
+      const auto e = patient.averageExploitability();
+      CHECK(e.numSamples == 40000);
+      CHECK(e.standardError > 0.0);
+      CHECK(e.standardError < 0.02);
+      CHECK(e.lower < e.value);
+      CHECK(e.upper > e.value);
+      CHECK(std::abs(e.value - 0.5) < 5 * e.standardError);
+    }
+    THEN("Sampling on several threads gives the same estimate") {
+      const auto sequential =
+          Game::SampledBestResponse<MatrixGameHistory, Numeric>(
+              MatrixGameHistory(utilsForPlayer1), policyOf(uniformProfile),
+              SamplingOptions(1001, 1, 7))
+              .averageExploitability();
+      const auto concurrent =
+          Game::SampledBestResponse<MatrixGameHistory, Numeric>(
+              MatrixGameHistory(utilsForPlayer1), policyOf(uniformProfile),
+              SamplingOptions(1001, 4, 7))
+              .averageExploitability();
+      CHECK(concurrent.value == sequential.value);
+      CHECK(concurrent.standardError == sequential.standardError);
+    }
+  }
+  GIVEN("A pure strategy profile") {
+    const std::vector<std::vector<Numeric>> pureProfile{{1.0, 0.0},
+                                                        {0.0, 1.0}};
+    THEN("Every sample agrees with the exact best response") {
+      const auto e = Game::SampledBestResponse<MatrixGameHistory, Numeric>(
+                         MatrixGameHistory(utilsForPlayer1),
+                         policyOf(pureProfile), SamplingOptions(10))
+                         .averageExploitability();
+      CHECK(e.value ==
+            Approx(BestResponse<Numeric>(utilsForPlayer1, pureProfile)
+                       .averageExploitability()));
+      CHECK(e.standardError == 0.0);
+    }
+  }
+}
+
+SCENARIO("Simultaneous update CFR on matching pennies") {
+  const auto averageGeneratorProfileFactory = [&]() {
+    return std::vector<
+        PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new AverageStrategyTable<Numeric>(
+            NUM_SEQUENCES, numActionsAtEachInfoSet,
+            NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+  };
+  const auto policyGeneratorProfileFactory = [&]() {
+    return std::vector<
+        PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
+        new RegretMatchingTable<Numeric>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                         NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new RegretMatchingTable<Numeric>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                         NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+  };
+  GIVEN("Traditional terminal values") {
+    std::vector<std::vector<int>> utilsForPlayer1{{1, -1}, {-1, 1}};
+    THEN("CFR finds the equilibrium properly") {
+      Cfr<size_t, std::pair<size_t, size_t>, Numeric> patient(
+          utilsForPlayer1, policyGeneratorProfileFactory(),
+          averageGeneratorProfileFactory(), UpdateMode::SIMULTANEOUS);
+      patient.doIterations(10);
+      CHECK(patient.strategyProfile()[0][0] == Approx(0.5));
+      CHECK(patient.strategyProfile()[1][0] == Approx(0.5));
+      CHECK(patient.averageExploitability() < 1e-3);
+    }
+  }
+  GIVEN("Alternative terminal values #3") {
+    std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
+    THEN("CFR finds the equilibrium properly") {
+      Cfr<size_t, std::pair<size_t, size_t>, Numeric> patient(
+          utilsForPlayer1, policyGeneratorProfileFactory(),
+          averageGeneratorProfileFactory(), UpdateMode::SIMULTANEOUS);
+      // Simultaneous regret matching converges more slowly than alternating
+      patient.doIterations(5e4);
+      CHECK(patient.strategyProfile()[0][0] == Approx(7.0 / 11).epsilon(0.01));
+      CHECK(patient.strategyProfile()[1][0] == Approx(5 / 11.0).epsilon(0.01));
+      CHECK(patient.averageExploitability() < 1e-2);
+    }
+  }
+}
+
+SCENARIO("Warm starting CFR on matching pennies") {
+  const auto tablesFactory = [&]() {
+    return std::vector<
+        PolicyGenerator<size_t, std::pair<size_t, size_t>, Numeric>*>{
+        new RegretMatchingTable<Numeric>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                         NUM_SEQUENCES_BEFORE_EACH_INFO_SET),
+        new RegretMatchingTable<Numeric>(NUM_SEQUENCES, numActionsAtEachInfoSet,
+                                         NUM_SEQUENCES_BEFORE_EACH_INFO_SET)};
+  };
+  std::vector<std::vector<int>> utilsForPlayer1{{20, -20}, {-40, 30}};
+  Cfr<size_t, std::pair<size_t, size_t>, Numeric> prior(
+      utilsForPlayer1, tablesFactory(), tablesFactory());
+  prior.doIterations(1000);
+  const auto priorProfile = prior.strategyProfile();
+
+  GIVEN("A prior solution") {
+    THEN("Warm starting from it reproduces its average strategy") {
+      Cfr<size_t, std::pair<size_t, size_t>, Numeric> patient(
+          utilsForPlayer1, tablesFactory(), tablesFactory());
+      patient.warmStart(priorProfile, 100);
+      for (size_t player = 0; player < 2; ++player) {
+        CHECK(patient.strategyProfile()[player][0] ==
+              Approx(priorProfile[player][0]));
+      }
+    }
+  }
+  GIVEN("Slightly changed terminal values") {
+    std::vector<std::vector<int>> changedUtils{{20, -20}, {-40, 31}};
+    THEN("A warm started re-solve converges in a tenth of the iterations") {
+      Cfr<size_t, std::pair<size_t, size_t>, Numeric> cold(
+          changedUtils, tablesFactory(), tablesFactory());
+      cold.doIterations(100);
+      Cfr<size_t, std::pair<size_t, size_t>, Numeric> warm(
+          changedUtils, tablesFactory(), tablesFactory());
+      warm.warmStart(priorProfile, 100);
+      warm.doIterations(10);
+      CHECK(warm.averageExploitability() <
+            cold.averageExploitability() / 2);
+    }
+  }
+}
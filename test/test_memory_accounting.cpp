@@ -0,0 +1,109 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/memory_accounting.hpp>
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+#include <lib/tree_node.hpp>
+#include <lib/vector_form.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+SCENARIO("Accounting for the memory of components") {
+  GIVEN("A regret table") {
+    const std::vector<size_t> numActions{2, 3};
+    const std::vector<size_t> numSequencesBefore{0, 2};
+    PolicyGenerator::RegretMatchingTable<> patient(5, numActions,
+                                                   numSequencesBefore);
+    THEN("It counts its table") {
+      const auto usage = patient.memoryUsage();
+      CHECK(usage.liveBytes >= 5 * sizeof(double));
+      CHECK(usage.peakBytes == usage.liveBytes);
+      CHECK(usage.numAllocations == 1);
+    }
+  }
+  GIVEN("A history") {
+    Poker::KuhnPokerHistory patient;
+    const auto before = patient.memoryUsage();
+    THEN("It grows with its suffixes") {
+      for (size_t i = 0; i < 2; ++i) {
+        std::string first;
+        patient.eachSuffix([&first](std::string&& suffix, size_t) {
+          first = suffix;
+          return true;
+        });
+        patient.push(first);
+      }
+      CHECK(patient.memoryUsage().liveBytes > before.liveBytes);
+    }
+  }
+  GIVEN("A stored tree") {
+    TreeNode::StoredInteriorNode<int> patient(
+        {new TreeNode::StoredTerminalNode<int>(1),
+         new TreeNode::StoredTerminalNode<int>(2)},
+        [](int childValue) { return childValue; });
+    THEN("It counts every node") {
+      const auto usage = patient.memoryUsage();
+      CHECK(usage.numAllocations == 3);
+      CHECK(usage.liveBytes >=
+            sizeof(patient) +
+                2 * sizeof(TreeNode::StoredTerminalNode<int>) +
+                2 * sizeof(TreeNode::TreeNode<int>*));
+    }
+  }
+}
+
+SCENARIO("Accounting for the memory of a solver") {
+  Poker::KuhnPokerHistory root;
+  const auto game = SequenceForm::compile(&root);
+  GIVEN("CFR on Kuhn poker") {
+    auto patient = Test::newCfr<SequenceForm::Cfr, double>(game);
+    THEN("Its tables are counted by kind") {
+      const auto breakdown = patient->memoryBreakdown();
+      REQUIRE(breakdown.size() == 4);
+      CHECK(breakdown[0].name == "regret tables");
+      CHECK(breakdown[0].usage.liveBytes >=
+            (game.numSequences(0) + game.numSequences(1)) * sizeof(double));
+      CHECK(breakdown[3].usage.peakBytes == 0);
+      CHECK(patient->memoryUsage().liveBytes ==
+            MemoryAccounting::total(breakdown).liveBytes);
+    }
+    THEN("Traversals leave a peak of scratch space behind") {
+      patient->doIterations(1);
+      const auto scratch = patient->memoryBreakdown()[3].usage;
+      CHECK(scratch.liveBytes == 0);
+      CHECK(scratch.peakBytes > 0);
+      CHECK(MemoryAccounting::format(patient->memoryBreakdown())
+                .find("total") != std::string::npos);
+    }
+    THEN("Single precision tables are smaller") {
+      auto single = Test::newCfr<SequenceForm::Cfr, float>(game);
+      CHECK(single->memoryBreakdown()[0].usage.liveBytes <
+            patient->memoryBreakdown()[0].usage.liveBytes);
+    }
+  }
+  GIVEN("Vector-form CFR on Leduc hold'em's public tree") {
+    Poker::LeducHoldemPublicHistory publicRoot;
+    const auto tree = VectorForm::compile(&publicRoot);
+    auto patient = Test::newCfr<VectorForm::Cfr>(tree);
+    THEN("Its scratch space grows with the tree and is always held") {
+      const auto breakdown = patient->memoryBreakdown();
+      REQUIRE(breakdown.size() == 4);
+      CHECK(breakdown[3].name == "traversal scratch");
+      const auto scratch = breakdown[3].usage;
+      CHECK(scratch.liveBytes >=
+            2 * tree.numNodes() * tree.maxNumPrivateStates() * sizeof(double));
+      CHECK(scratch.peakBytes == scratch.liveBytes);
+      CHECK(patient->memoryUsage().liveBytes ==
+            MemoryAccounting::total(breakdown).liveBytes);
+    }
+  }
+}
@@ -0,0 +1,79 @@
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <test_helper.hpp>
+
+#include <lib/matrix_game.hpp>
+#include <lib/multi_process.hpp>
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+static std::string regionName(const std::string& suffix) {
+  return "/tree_and_history_traversal_test_" + std::to_string(getpid()) +
+         "_" + suffix;
+}
+
+static void checkSameProfile(const std::vector<std::vector<double>>& actual,
+                             const std::vector<std::vector<double>>& expected) {
+  REQUIRE(actual.size() == expected.size());
+  for (size_t player = 0; player < expected.size(); ++player) {
+    REQUIRE(actual[player].size() == expected[player].size());
+    for (size_t k = 0; k < expected[player].size(); ++k) {
+      CHECK(actual[player][k] == Approx(expected[player][k]));
+    }
+  }
+}
+
+SCENARIO("Multi-process CFR on Kuhn poker") {
+  Poker::KuhnPokerHistory root;
+  const auto game = SequenceForm::compile(&root);
+  auto cfr = Test::newCfr<SequenceForm::Cfr>(game);
+  cfr->doIterations(200);
+
+  GIVEN("Three workers for the six deals") {
+    MultiProcess::Cfr patient(game, 3, regionName("a"));
+    patient.doIterations(200);
+    THEN("It matches a single process solver") {
+      checkSameProfile(patient.strategyProfile(), cfr->strategyProfile());
+      CHECK(patient.numRestarts() == 0);
+    }
+    THEN("A killed worker is replaced without losing the tables") {
+      kill(patient.workerPid(1), SIGKILL);
+      patient.doIterations(100);
+      cfr->doIterations(100);
+      CHECK(patient.numRestarts() == 1);
+      checkSameProfile(patient.strategyProfile(), cfr->strategyProfile());
+    }
+    THEN("A solver resumed from saved tables continues the same run") {
+      std::stringstream snapshot;
+      patient.saveTables(snapshot);
+      MultiProcess::Cfr resumed(game, 2, regionName("b"));
+      resumed.loadTables(snapshot);
+      resumed.doIterations(100);
+      cfr->doIterations(100);
+      checkSameProfile(resumed.strategyProfile(), cfr->strategyProfile());
+    }
+  }
+
+  GIVEN("A game whose root is not a chance node") {
+    const std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
+    MatrixGame::MatrixGameHistory matrixRoot(utilsForPlayer1);
+    const auto matrixGame = SequenceForm::compile(&matrixRoot);
+    THEN("Construction fails") {
+      CHECK_THROWS_AS(MultiProcess::Cfr(matrixGame, 2, regionName("c")),
+                      std::invalid_argument);
+    }
+  }
+}
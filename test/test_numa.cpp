@@ -0,0 +1,81 @@
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/numa.hpp>
+#include <lib/policy_generator.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+SCENARIO("Reading the NUMA topology") {
+  GIVEN("A sysfs list") {
+    THEN("Ranges and single values are expanded") {
+      CHECK(Numa::Detail::parseList("0-3,8,10-11\n") ==
+            std::vector<size_t>({0, 1, 2, 3, 8, 10, 11}));
+      CHECK(Numa::Detail::parseList("").empty());
+    }
+  }
+  GIVEN("This machine") {
+    THEN("Every node has CPUs and pinned threads run on each") {
+      CHECK(Numa::numNodes() > 0);
+      for (const auto& cpus : Numa::cpusByNode()) {
+        CHECK_FALSE(cpus.empty());
+      }
+      std::atomic<size_t> numRuns(0);
+      Numa::runPinned(2, [&](size_t node, size_t) {
+        if (node < Numa::numNodes()) {
+          ++numRuns;
+        }
+      });
+      CHECK(numRuns == 2 * Numa::numNodes());
+    }
+  }
+}
+
+SCENARIO("Placing regret tables") {
+  // Information sets with 3, 2, 2, 1, and 4 actions
+  const std::vector<size_t> numActions{3, 2, 2, 1, 4};
+  const std::vector<size_t> numSequencesBefore{0, 3, 5, 7, 8};
+  const size_t numSequences = 12;
+
+  GIVEN("Partitions across different numbers of nodes") {
+    THEN("Ranges are contiguous and never split an information set") {
+      CHECK(Numa::partitionInfoSets(numSequencesBefore, numSequences, 1) ==
+            std::vector<size_t>({0, 5}));
+      CHECK(Numa::partitionInfoSets(numSequencesBefore, numSequences, 2) ==
+            std::vector<size_t>({0, 3, 5}));
+      CHECK(Numa::partitionInfoSets(numSequencesBefore, numSequences, 3) ==
+            std::vector<size_t>({0, 2, 4, 5}));
+      CHECK(Numa::partitionInfoSets(numSequencesBefore, numSequences, 8) ==
+            std::vector<size_t>({0, 1, 1, 2, 3, 3, 5, 5, 5}));
+    }
+  }
+  GIVEN("The same updates applied to tables with each placement") {
+    const std::vector<Numa::Placement> placements{
+        Numa::Placement::DEFAULT, Numa::Placement::INTERLEAVED,
+        Numa::Placement::PARTITIONED};
+    std::vector<std::vector<double>> policies(placements.size());
+    for (size_t p = 0; p < placements.size(); ++p) {
+      PolicyGenerator::RegretMatchingPlusTable<> table(
+          numSequences, numActions, numSequencesBefore, placements[p]);
+      for (size_t I = 0; I < numActions.size(); ++I) {
+        for (size_t a = 0; a < numActions[I]; ++a) {
+          table.update({I, a}, static_cast<double>(a * I) - 1.0);
+        }
+        const auto policy = table.policy(I);
+        policies[p].insert(policies[p].end(), policy.begin(), policy.end());
+      }
+    }
+    THEN("Placement does not change the policies") {
+      CHECK(policies[0].size() == numSequences);
+      CHECK(policies[1] == policies[0]);
+      CHECK(policies[2] == policies[0]);
+    }
+  }
+}
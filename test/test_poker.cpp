@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/info_set_index.hpp>
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+using namespace SequenceForm;
+
+/**
+ * Plays profile, which is laid out like game's sequences, by information
+ * set name.
+ */
+static Game::Policy policyOf(const CompiledGame& game,
+                             const std::vector<std::vector<double>>& profile) {
+  const auto indices =
+      std::make_shared<std::vector<InfoSetIndex::PerfectHashIndex>>(
+          InfoSetIndex::indexInfoSets(game));
+  return [&game, profile, indices](size_t player, const std::string& name) {
+    const size_t I = (*indices)[player][name];
+    const auto* sigma_I =
+        &profile[player][game.numSequencesBeforeEachInfoSet[player][I]];
+    return std::vector<double>(
+        sigma_I, sigma_I + game.numActionsAtEachInfoSet[player][I]);
+  };
+}
+
+SCENARIO("Kuhn poker") {
+  Poker::KuhnPokerHistory root;
+
+  GIVEN("The empty history") {
+    THEN("Chance deals two different cards, then player 0 acts") {
+      CHECK(root.actor() == Game::CHANCE);
+      CHECK(root.numSuccessors() == 3);
+      root.push("Q");
+      CHECK(root.actor() == Game::CHANCE);
+      CHECK(root.numSuccessors() == 2);
+      CHECK_FALSE(root.suffixIsLegal("Q"));
+      root.push("K");
+      CHECK(root.actor() == 0);
+      CHECK(root.informationSet() == "Q:");
+      root.push("p");
+      CHECK(root.actor() == 1);
+      CHECK(root.informationSet() == "K:p");
+      root.push("b");
+      root.push("b");
+      CHECK_FALSE(root.hasSuccessors());
+      CHECK(root.utility(0) == -2);
+      CHECK(root.utility(1) == 2);
+    }
+  }
+
+  GIVEN("The compiled game") {
+    const auto game = compile(&root);
+    THEN("Each player has six information sets") {
+      CHECK(root.isEmpty());
+      CHECK(game.numNodes() == 58);
+      CHECK(game.numInfoSets(0) == 6);
+      CHECK(game.numInfoSets(1) == 6);
+      CHECK(game.numSequences(0) == 12);
+    }
+    THEN("CFR finds the game's value") {
+      auto cfr = Test::newCfr<Cfr>(game);
+      cfr->doIterations(1e4);
+      const auto profile = cfr->strategyProfile();
+      CHECK(expectedUtilities(game, profile)[0] ==
+            Approx(-1.0 / 18).epsilon(0.01));
+      CHECK(cfr->averageExploitability() < 1e-3);
+    }
+    THEN("Saved copies with invalid chance probabilities fail to load") {
+      REQUIRE(game.isChance(0));
+      const auto loads = [](const CompiledGame& corrupt) {
+        std::stringstream image;
+        corrupt.save(image);
+        CompiledGame::load(image);
+      };
+      auto corrupt = game;
+      corrupt.chanceProbabilities[corrupt.childrenBegin[0]] = -0.1;
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+      corrupt.chanceProbabilities[corrupt.childrenBegin[0]] = std::nan("");
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+    }
+  }
+}
+
+SCENARIO("Leduc hold'em") {
+  Poker::LeducHoldemHistory root;
+
+  GIVEN("A history that reaches the second round") {
+    root.push("K0");
+    root.push("Q1");
+    root.push("r");
+    CHECK(root.actor() == 1);
+    CHECK(root.suffixIsLegal("f"));
+    root.push("c");
+    THEN("Chance deals the board from the remaining cards") {
+      CHECK(root.actor() == Game::CHANCE);
+      CHECK(root.numSuccessors() == 4);
+      CHECK_FALSE(root.suffixIsLegal("K0"));
+      root.push("Q0");
+      CHECK(root.actor() == 0);
+      CHECK_FALSE(root.suffixIsLegal("f"));
+      CHECK(root.informationSet() == "K:rc/Q:");
+      root.push("r");
+      root.push("f");
+      CHECK_FALSE(root.hasSuccessors());
+      CHECK(root.utility(0) == 3);
+      CHECK(root.utility(1) == -3);
+    }
+    THEN("A pair beats a higher card") {
+      root.push("Q0");
+      root.push("c");
+      root.push("c");
+      CHECK_FALSE(root.hasSuccessors());
+      CHECK(root.utility(0) == -3);
+    }
+  }
+
+  GIVEN("The compiled game") {
+    const auto game = compile(&root);
+    THEN("Each player has 144 information sets") {
+      CHECK(root.isEmpty());
+      CHECK(game.numInfoSets(0) == 144);
+      CHECK(game.numInfoSets(1) == 144);
+    }
+    THEN("CFR approaches the game's value") {
+      auto cfr = Test::newCfr<Cfr>(game);
+      cfr->doIterations(10);
+      const auto early = cfr->averageExploitability();
+      cfr->doIterations(490);
+      CHECK(cfr->averageExploitability() < early / 4);
+      CHECK(expectedUtilities(game, cfr->strategyProfile())[0] ==
+            Approx(-0.0856).epsilon(0.1));
+    }
+  }
+}
+
+SCENARIO("Sampling chance outcomes") {
+  Poker::KuhnPokerHistory root;
+
+  GIVEN("Draws across the unit interval") {
+    THEN("Each card is dealt over its third of the interval") {
+      const std::vector<double> draws{0.0, 0.3, 0.34, 0.66, 0.67, 0.999};
+      const std::vector<std::string> cards{"J", "J", "Q", "Q", "K", "K"};
+      for (size_t i = 0; i < draws.size(); ++i) {
+        root.sampleSuccessor(draws[i], [&](size_t outcome, double prob) {
+          CHECK(root.last() == cards[i]);
+          CHECK(outcome == i / 2);
+          CHECK(prob == Approx(1.0 / 3));
+          return false;
+        });
+        CHECK(root.isEmpty());
+      }
+    }
+  }
+}
+
+SCENARIO("Vectorized private chance on Kuhn poker") {
+  Poker::KuhnPokerHistory root;
+  const auto game = compile(&root);
+  auto cfr = Test::newCfr<Cfr>(game);
+  cfr->doIterations(100);
+  const auto profile = cfr->strategyProfile();
+
+  GIVEN("The average profile after a few iterations") {
+    const auto policy = policyOf(game, profile);
+    THEN("One public tree pass matches a pass over every deal") {
+      Poker::KuhnPokerPublicHistory publicRoot;
+      const auto values = Game::expectedUtilities(&publicRoot, policy);
+      const auto expected = expectedUtilities(game, profile);
+      CHECK(publicRoot.isEmpty());
+      CHECK(values[0] == Approx(expected[0]));
+      CHECK(values[1] == Approx(expected[1]));
+      CHECK(values[0] + values[1] == Approx(0.0));
+    }
+  }
+}
+
+SCENARIO("Sampled best response on Kuhn poker") {
+  Poker::KuhnPokerHistory root;
+  const auto game = compile(&root);
+  std::vector<std::vector<double>> uniformProfile(game.numPlayers);
+  for (size_t player = 0; player < game.numPlayers; ++player) {
+    for (size_t I = 0; I < game.numInfoSets(player); ++I) {
+      const auto numActions = game.numActionsAtEachInfoSet[player][I];
+      uniformProfile[player].insert(uniformProfile[player].end(), numActions,
+                                    1.0 / numActions);
+    }
+  }
+  auto cfr = Test::newCfr<Cfr>(game);
+  cfr->doIterations(100);
+  const auto averageProfile = cfr->strategyProfile();
+
+  GIVEN("A uniform profile") {
+    const Game::SampledBestResponse<Poker::KuhnPokerHistory> patient(
+        root, policyOf(game, uniformProfile), Game::SamplingOptions(20000));
+    THEN("It chooses the exact best response at every information set") {
+      const auto exact =
+          BestResponse<>(game, uniformProfile).strategyProfile()[0];
+      const auto choices = patient.bestResponse(0);
+      REQUIRE(choices.size() == game.numInfoSets(0));
+      size_t numMismatches = 0;
+      for (size_t I = 0; I < game.numInfoSets(0); ++I) {
+        numMismatches +=
+            exact[game.numSequencesBeforeEachInfoSet[0][I] +
+                  choices.at(game.infoSetNames[0][I])] != 1.0;
+      }
+      CHECK(numMismatches == 0);
+    }
+    THEN("The confidence interval covers the exact exploitability") {
+      const auto exact =
+          BestResponse<>(game, uniformProfile).averageExploitability();
+      const auto e = patient.averageExploitability();
+      CHECK(e.standardError > 0.0);
+      CHECK(e.standardError < 0.02);
+      CHECK(std::abs(e.value - exact) < 5 * e.standardError);
+    }
+  }
+  GIVEN("The average profile after a few iterations") {
+    THEN("The estimate does not exceed the exact exploitability") {
+      const auto exact =
+          BestResponse<>(game, averageProfile).averageExploitability();
+      const auto e = Game::SampledBestResponse<Poker::KuhnPokerHistory>(
+                         root, policyOf(game, averageProfile),
+                         Game::SamplingOptions(20000, 3, 5))
+                         .averageExploitability();
+      CHECK(e.value < exact + 5 * e.standardError);
+      CHECK(e.value > exact - 0.05);
+    }
+  }
+}
+
+SCENARIO("Warm starting CFR on Kuhn poker") {
+  Poker::KuhnPokerHistory root;
+  const auto game = compile(&root);
+  auto prior = Test::newCfr<Cfr>(game);
+  prior->doIterations(1000);
+
+  GIVEN("A prior solution") {
+    auto cold = Test::newCfr<Cfr>(game);
+    cold->doIterations(200);
+    auto warm = Test::newCfr<Cfr>(game);
+    warm->warmStart(prior->strategyProfile(), 100);
+    THEN("A re-solve from it needs a fraction of the iterations") {
+      warm->doIterations(10);
+      CHECK(warm->averageExploitability() < cold->averageExploitability());
+    }
+  }
+}
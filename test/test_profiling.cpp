@@ -0,0 +1,49 @@
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/profiling.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+SCENARIO("Profiling solver calls") {
+  GIVEN("A profiler") {
+    Profiling::Profiler patient;
+    volatile double sink = 0.0;
+    const auto work = [&sink]() {
+      for (size_t i = 0; i < 100000; ++i) {
+        sink = sink + 1.0;
+      }
+    };
+    THEN("Each measurement reports elapsed time and adds to the total") {
+      const auto first = patient.measure(work);
+      const auto second = patient.measure(work);
+      CHECK(first.numCalls == 1);
+      CHECK(first.seconds > 0.0);
+      CHECK(patient.total().numCalls == 2);
+      CHECK(patient.total().seconds ==
+            Approx(first.seconds + second.seconds));
+      CHECK(first.hasHardwareCounters == patient.hasHardwareCounters());
+      if (patient.hasHardwareCounters()) {
+        CHECK(first.instructions >= 100000);
+        CHECK(first.cycles > 0);
+      } else {
+        CHECK(first.cycles == 0);
+      }
+    }
+    THEN("Clearing the total starts a new block") {
+      patient.measure(work);
+      patient.clearTotal();
+      CHECK(patient.total().numCalls == 0);
+      CHECK(patient.total().seconds == 0.0);
+    }
+  }
+}
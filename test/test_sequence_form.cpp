@@ -0,0 +1,135 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/matrix_game.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+using namespace SequenceForm;
+
+SCENARIO("Compiling matching pennies") {
+  const std::vector<std::vector<int>> utilsForPlayer1{{2, -2}, {-4, 3}};
+  MatrixGame::MatrixGameHistory root(utilsForPlayer1);
+  const auto patient = compile(&root);
+
+  GIVEN("The compiled game") {
+    THEN("It has one information set with two actions per player") {
+      CHECK(patient.numPlayers == 2);
+      CHECK(patient.numNodes() == 7);
+      for (size_t player = 0; player < 2; ++player) {
+        CHECK(patient.numInfoSets(player) == 1);
+        CHECK(patient.numSequences(player) == 2);
+        CHECK(patient.numActionsAtEachInfoSet[player] ==
+              std::vector<size_t>{2});
+        CHECK(patient.numSequencesBeforeEachInfoSet[player] ==
+              MatrixGame::NUM_SEQUENCES_BEFORE_EACH_INFO_SET);
+      }
+    }
+    THEN("Both of player 2's decisions share an information set") {
+      CHECK(patient.actor[0] == 0);
+      const auto left = patient.child(0, 0);
+      const auto right = patient.child(0, 1);
+      CHECK(patient.actor[left] == 1);
+      CHECK(patient.actor[right] == 1);
+      CHECK(patient.infoSet[left] == patient.infoSet[right]);
+    }
+    THEN("Terminal utilities follow the matrix") {
+      const auto rightRight = patient.child(patient.child(0, 1), 1);
+      CHECK(patient.isTerminal(rightRight));
+      CHECK(patient.utility(rightRight, 0) == 3);
+      CHECK(patient.utility(rightRight, 1) == -3);
+    }
+    THEN("The history is restored") { CHECK(root.isEmpty()); }
+  }
+  GIVEN("A saved copy") {
+    std::stringstream image;
+    patient.save(image);
+    THEN("Loading it reproduces the game") {
+      CHECK(CompiledGame::load(image) == patient);
+    }
+    THEN("Loading a truncated copy fails") {
+      std::stringstream truncated(image.str().substr(0, 40));
+      CHECK_THROWS(CompiledGame::load(truncated));
+    }
+    THEN("Loading a copy with an absurd length fails without allocating it") {
+      auto bytes = image.str();
+      // The actor vector's length follows the magic and numPlayers
+      const uint64_t numNodes = UINT64_MAX / 2;
+      memcpy(&bytes[16], &numNodes, sizeof(numNodes));
+      std::stringstream corrupt(bytes);
+      CHECK_THROWS_AS(CompiledGame::load(corrupt), std::runtime_error);
+    }
+    THEN("Loading a copy with inconsistent structure fails") {
+      const auto loads = [](const CompiledGame& game) {
+        std::stringstream image;
+        game.save(image);
+        CompiledGame::load(image);
+      };
+      auto corrupt = patient;
+      corrupt.children[0] = corrupt.numNodes();
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+      corrupt = patient;
+      corrupt.children[1] = 0;
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+      corrupt = patient;
+      corrupt.childrenBegin.pop_back();
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+      corrupt = patient;
+      corrupt.actor[0] = 2;
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+      corrupt = patient;
+      corrupt.infoSet[corrupt.child(0, 0)] = 1;
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+      corrupt = patient;
+      corrupt.numSequencesBeforeEachInfoSet[1].push_back(2);
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+      // No nodes at all
+      corrupt = CompiledGame();
+      corrupt.numPlayers = 2;
+      corrupt.childrenBegin.push_back(0);
+      corrupt.infoSetNames.resize(2);
+      corrupt.numActionsAtEachInfoSet.resize(2);
+      corrupt.numSequencesBeforeEachInfoSet.resize(2);
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+      corrupt = patient;
+      corrupt.numActionsAtEachInfoSet[0][0] = 3;
+      corrupt.numSequencesBeforeEachInfoSet[0][0] = 0;
+      CHECK_THROWS_AS(loads(corrupt), std::runtime_error);
+    }
+  }
+  GIVEN("A strategy profile") {
+    const std::vector<std::vector<double>> profile{{0.5, 0.5}, {0.3, 0.7}};
+    THEN("The best response matches a traversal of the history") {
+      BestResponse<> br(patient, profile);
+      MatrixGame::BestResponse<> expected(utilsForPlayer1, profile);
+      const auto values = br.valueProfile();
+      const auto expectedValues = expected.valueProfile();
+      CHECK(values[0] == Approx(expectedValues[0]));
+      CHECK(values[1] == Approx(expectedValues[1]));
+      CHECK(br.strategyProfile() == expected.strategyProfile());
+    }
+  }
+  GIVEN("CFR on the compiled game") {
+    auto cfr = Test::newCfr<Cfr>(patient);
+    cfr->doIterations(1e4);
+    THEN("It finds the equilibrium") {
+      CHECK(cfr->strategyProfile()[0][0] == Approx(7.0 / 11).epsilon(0.001));
+      CHECK(cfr->strategyProfile()[1][0] == Approx(5.0 / 11).epsilon(0.001));
+      CHECK(cfr->averageExploitability() < 1e-3);
+    }
+  }
+}
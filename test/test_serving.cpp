@@ -0,0 +1,130 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <test_helper.hpp>
+
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+#include <lib/serving.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+SCENARIO("Serving a solved Leduc hold'em profile") {
+  Poker::LeducHoldemHistory root;
+  const auto game = SequenceForm::compile(&root);
+  auto cfr = Test::newCfr<SequenceForm::Cfr>(game);
+  cfr->doIterations(20);
+  const auto profile = cfr->strategyProfile();
+
+  GIVEN("An exported table") {
+    const auto table = cfr->servingTable();
+    THEN("Every policy matches the average strategy") {
+      CHECK(table.numPlayers() == 2);
+      for (size_t player = 0; player < 2; ++player) {
+        CHECK(table.numInfoSets(player) == game.numInfoSets(player));
+        for (size_t I = 0; I < game.numInfoSets(player); ++I) {
+          const auto sigma_I = table.policy(player, I);
+          CHECK(sigma_I.size() == game.numActionsAtEachInfoSet[player][I]);
+          for (size_t a = 0; a < sigma_I.size(); ++a) {
+            CHECK(sigma_I[a] ==
+                  Approx(profile[player][game.numSequencesBeforeEachInfoSet
+                                             [player][I] + a]));
+          }
+        }
+      }
+      CHECK(table.numBytes() % 64 == 0);
+    }
+    THEN("Many threads can read it at once") {
+      std::atomic<size_t> numMismatches(0);
+      std::vector<std::thread> readers;
+      for (size_t r = 0; r < 4; ++r) {
+        readers.emplace_back([&, r]() {
+          for (size_t I = r; I < game.numInfoSets(1); I += 2) {
+            const auto sigma_I = table.policy(1, I);
+            if (sigma_I[0] != table.policy(1, I)[0]) {
+              ++numMismatches;
+            }
+          }
+        });
+      }
+      for (auto& reader : readers) {
+        reader.join();
+      }
+      CHECK(numMismatches == 0);
+    }
+  }
+  GIVEN("Quantized tables") {
+    const auto table16 = cfr->servingTable(Serving::Quantization::UINT16);
+    const auto table8 = cfr->servingTable(Serving::Quantization::UINT8);
+    THEN("They are smaller, close, and still sum to one") {
+      const auto table = cfr->servingTable();
+      CHECK(table16.numBytes() < table.numBytes());
+      CHECK(table8.numBytes() < table16.numBytes());
+      for (size_t I = 0; I < game.numInfoSets(0); ++I) {
+        const auto exact = table.policy(0, I);
+        const auto sigma16 = table16.policy(0, I);
+        const auto sigma8 = table8.policy(0, I);
+        double total16 = 0.0;
+        double total8 = 0.0;
+        for (size_t a = 0; a < exact.size(); ++a) {
+          CHECK(std::abs(sigma16[a] - exact[a]) <= 1.0 / 65535);
+          CHECK(std::abs(sigma8[a] - exact[a]) <= 1.0 / 255);
+          total16 += sigma16[a];
+          total8 += sigma8[a];
+        }
+        CHECK(total16 == Approx(1.0));
+        CHECK(total8 == Approx(1.0));
+      }
+    }
+  }
+  GIVEN("A table saved to disk") {
+    const std::string path =
+        "/tmp/test_serving_" + std::to_string(getpid()) + ".bin";
+    {
+      std::ofstream out(path, std::ios::binary);
+      cfr->servingTable(Serving::Quantization::UINT16).save(out);
+    }
+    THEN("Mapping it serves the same policies") {
+      const auto mapped = Serving::PolicyTable::map(path);
+      const auto table = cfr->servingTable(Serving::Quantization::UINT16);
+      CHECK(mapped.numBytes() == table.numBytes());
+      CHECK(mapped.quantization() == Serving::Quantization::UINT16);
+      for (size_t I = 0; I < game.numInfoSets(1); ++I) {
+        CHECK(mapped.policy(1, I)[0] == table.policy(1, I)[0]);
+        CHECK(mapped.policy(1, I).sample(0.999) ==
+              table.policy(1, I).sample(0.999));
+      }
+    }
+    THEN("Truncated images are rejected") {
+      CHECK(truncate(path.c_str(), 100) == 0);
+      CHECK_THROWS_AS(Serving::PolicyTable::map(path), std::runtime_error);
+    }
+    THEN("Images with offsets out of order are rejected") {
+      // Player 0's offsets follow the header and the player entries, each
+      // on their own cache line.
+      const long offsetsBegin = 2 * Serving::Detail::CACHE_LINE;
+      const uint64_t offset = UINT64_MAX / 2;
+      {
+        std::fstream file(path,
+                          std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offsetsBegin + 3 * sizeof(uint64_t));
+        file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+      }
+      CHECK_THROWS_AS(Serving::PolicyTable::map(path), std::runtime_error);
+    }
+    unlink(path.c_str());
+  }
+}
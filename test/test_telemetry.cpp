@@ -0,0 +1,101 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/telemetry.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+SCENARIO("Streaming convergence telemetry") {
+  GIVEN("A ring buffer") {
+    Telemetry::SpscRingBuffer<int> patient(4);
+    THEN("It rejects pushes when full and pops in FIFO order") {
+      for (int i = 0; i < 4; ++i) {
+        REQUIRE(patient.tryPush(i));
+      }
+      CHECK_FALSE(patient.tryPush(4));
+      int x = -1;
+      REQUIRE(patient.tryPop(&x));
+      CHECK(x == 0);
+      REQUIRE(patient.tryPush(4));
+      for (int i = 1; i <= 4; ++i) {
+        REQUIRE(patient.tryPop(&x));
+        CHECK(x == i);
+      }
+      CHECK_FALSE(patient.tryPop(&x));
+    }
+    THEN("Its capacity must be a power of two") {
+      CHECK_THROWS(Telemetry::SpscRingBuffer<int>(6));
+    }
+  }
+  GIVEN("A producer and consumer on different threads") {
+    Telemetry::SpscRingBuffer<size_t> patient(16);
+    const size_t n = 100000;
+    std::vector<size_t> received;
+    std::thread consumer([&]() {
+      size_t x;
+      while (received.size() < n) {
+        if (patient.tryPop(&x)) {
+          received.push_back(x);
+        }
+      }
+    });
+    for (size_t i = 0; i < n; ++i) {
+      while (!patient.tryPush(i)) {
+      }
+    }
+    consumer.join();
+    THEN("Every item arrives once and in order") {
+      bool inOrder = true;
+      for (size_t i = 0; i < n; ++i) {
+        inOrder = inOrder && received[i] == i;
+      }
+      CHECK(inOrder);
+    }
+  }
+  GIVEN("A CSV sink") {
+    char path[] = "/tmp/telemetry_test_XXXXXX";
+    close(mkstemp(path));
+    const size_t n = 1000;
+    {
+      Telemetry::Sink patient(path, Telemetry::Format::CSV, 2048);
+      for (size_t i = 0; i < n; ++i) {
+        Telemetry::Record r;
+        r.run = 1;
+        r.iteration = i;
+        r.seconds = i * 1e-3;
+        r.exploitability = 1.0 / (i + 1);
+        r.numRegretsSmallerThanNoise = 2 * i;
+        REQUIRE(patient.record(r));
+      }
+    }
+    THEN("Closing it writes a header and every record") {
+      std::ifstream in(path);
+      std::string line;
+      std::getline(in, line);
+      CHECK(line ==
+            "run,iteration,seconds,exploitability,"
+            "num_regrets_smaller_than_noise");
+      size_t numLines = 0;
+      std::string last;
+      while (std::getline(in, line)) {
+        ++numLines;
+        last = line;
+      }
+      CHECK(numLines == n);
+      CHECK(last == "1,999,0.999,0.001,1998");
+    }
+    unlink(path);
+  }
+}
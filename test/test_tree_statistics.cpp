@@ -0,0 +1,117 @@
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/history.hpp>
+#include <lib/poker.hpp>
+#include <lib/sequence_form.hpp>
+#include <lib/tree_statistics.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+/**
+ * Every string of up to maxDepth symbols from an alphabet of alphabetSize.
+ */
+class CompleteHistory : public History::StringHistory {
+ public:
+  CompleteHistory(size_t alphabetSize, size_t maxDepth)
+      : StringHistory(alphabet(alphabetSize)), maxDepth_(maxDepth) {}
+  virtual ~CompleteHistory() {}
+  virtual CompleteHistory* clone() const override {
+    return new CompleteHistory(*this);
+  }
+
+  virtual bool suffixIsLegal(const std::string&) const override {
+    return state_.size() < maxDepth_;
+  }
+
+ protected:
+  static std::vector<std::string> alphabet(size_t alphabetSize) {
+    std::vector<std::string> symbols;
+    for (size_t i = 0; i < alphabetSize; ++i) {
+      symbols.push_back(std::to_string(i));
+    }
+    return symbols;
+  }
+
+ protected:
+  const size_t maxDepth_;
+};
+
+SCENARIO("Profiling a complete tree") {
+  const CompleteHistory root(3, 4);
+  GIVEN("A walk of every history") {
+    const auto patient = TreeStatistics::profile(root);
+    THEN("Each depth has the powers of the branching factor") {
+      REQUIRE(patient.maxDepth() == 4);
+      double n = 1.0;
+      for (size_t depth = 0; depth <= 4; ++depth) {
+        CHECK(patient.numNodesByDepth[depth] == n);
+        n *= 3;
+      }
+      CHECK(patient.numNodes() == 121);
+      CHECK(patient.numTerminals() == 81);
+      CHECK(patient.meanBranchingFactor() == Approx(3.0));
+      CHECK(patient.numInteriorNodesByBranchingFactor[3] == 40);
+      CHECK(patient.numInfoSets.empty());
+    }
+  }
+  GIVEN("Sampled paths") {
+    const auto patient =
+        TreeStatistics::profile(root, TreeStatistics::Options(2, 1, 10));
+    THEN("Every path gives the exact counts") {
+      CHECK(patient.numSamples == 10);
+      CHECK(patient.numNodes() == Approx(121));
+      CHECK(patient.numTerminals() == Approx(81));
+    }
+  }
+}
+
+SCENARIO("Profiling Kuhn poker") {
+  Poker::KuhnPokerHistory root;
+  const auto game = SequenceForm::compile(&root);
+
+  GIVEN("Walks by different numbers of threads and split depths") {
+    THEN("They agree with the compiled game") {
+      for (size_t numThreads : {1, 3}) {
+        for (size_t splitDepth : {0, 1, 2, 9}) {
+          const auto patient = TreeStatistics::profile(
+              root, TreeStatistics::Options(numThreads, splitDepth));
+          CHECK(patient.numNodes() == game.numNodes());
+          REQUIRE(patient.numInfoSets.size() == 2);
+          for (size_t player = 0; player < 2; ++player) {
+            CHECK(patient.numInfoSets[player] == game.numInfoSets(player));
+            CHECK(patient.numSequences[player] == game.numSequences(player));
+          }
+          const auto bytes = patient.memoryBreakdown(sizeof(float));
+          CHECK(bytes[0].usage.liveBytes ==
+                (game.numSequences(0) + game.numSequences(1)) *
+                    sizeof(float));
+          CHECK(bytes[2].usage.peakBytes > 0);
+        }
+      }
+    }
+  }
+  GIVEN("Sampled paths") {
+    const auto exact = TreeStatistics::profile(root);
+    const auto patient = TreeStatistics::profile(
+        root, TreeStatistics::Options(1, 1, 20000, 7));
+    THEN("They estimate the counts") {
+      CHECK(patient.numNodes() ==
+            Approx(exact.numNodes()).epsilon(0.05));
+      CHECK(patient.numTerminals() ==
+            Approx(exact.numTerminals()).epsilon(0.05));
+      CHECK(patient.numInfoSets[0] <= exact.numInfoSets[0]);
+    }
+    THEN("The estimates are reproducible across thread counts") {
+      const auto other = TreeStatistics::profile(
+          root, TreeStatistics::Options(4, 1, 20000, 7));
+      CHECK(other.numNodes() == Approx(patient.numNodes()));
+    }
+  }
+}
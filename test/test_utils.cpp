@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <test_helper.hpp>
+
+#include <lib/utils.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+template <typename Numeric>
+static std::vector<Numeric> sawtooth(size_t n) {
+  std::vector<Numeric> v(n);
+  for (size_t i = 0; i < n; ++i) {
+    v[i] = static_cast<Numeric>((i * 7) % 11) - Numeric(4.0);
+  }
+  return v;
+}
+
+template <typename Numeric>
+static void checkKernelsAgainstScalar() {
+  // Lengths that cover empty input, partial registers, and several full
+  // AVX-512 registers plus a remainder.
+  for (size_t n = 0; n < 40; ++n) {
+    const auto x = sawtooth<Numeric>(n);
+    auto y = sawtooth<Numeric>(n);
+    std::reverse(y.begin(), y.end());
+
+    CHECK(Utils::sum(x.data(), n) ==
+          Approx(Utils::Kernels::Scalar::sum(x.data(), n)));
+    CHECK(Utils::positivePartSum(x.data(), n) ==
+          Approx(Utils::Kernels::Scalar::positivePartSum(x.data(), n)));
+    CHECK(Utils::dot(x.data(), y.data(), n) ==
+          Approx(Utils::Kernels::Scalar::dot(x.data(), y.data(), n)));
+
+    auto z = y;
+    auto zExpected = y;
+    Utils::axpy(Numeric(0.5), x.data(), n, z.data());
+    Utils::Kernels::Scalar::axpy(Numeric(0.5), x.data(), n, zExpected.data());
+    for (size_t i = 0; i < n; ++i) {
+      CHECK(z[i] == Approx(zExpected[i]));
+    }
+
+    if (n > 0) {
+      const auto i = Utils::argmax(x.data(), n);
+      CHECK(x[i] == Utils::Kernels::Scalar::max(x.data(), n));
+      for (size_t j = 0; j < i; ++j) {
+        CHECK(x[j] < x[i]);
+      }
+
+      std::vector<Numeric> p(n);
+      Utils::normalize(x.data(), n, p.data());
+      const auto s = Utils::Kernels::Scalar::positivePartSum(x.data(), n);
+      for (size_t j = 0; j < n; ++j) {
+        if (s > 0) {
+          CHECK(p[j] == Approx(x[j] > 0 ? x[j] / s : 0.0));
+        } else {
+          CHECK(p[j] == Approx(1.0 / n));
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Numeric kernels") {
+  GIVEN("Double precision vectors") {
+    THEN("The dispatched kernels agree with the scalar kernels") {
+      checkKernelsAgainstScalar<double>();
+    }
+  }
+  GIVEN("Single precision vectors") {
+    THEN("The dispatched kernels agree with the scalar kernels") {
+      checkKernelsAgainstScalar<float>();
+    }
+  }
+  GIVEN("A vector with no positive elements") {
+    const std::vector<double> x{-1.0, 0.0, -3.0, -0.5};
+    THEN("It normalizes to the uniform distribution") {
+      const auto p = Utils::normalized(x);
+      for (auto p_i : p) {
+        CHECK(p_i == Approx(0.25));
+      }
+    }
+  }
+  GIVEN("A vector with positive and negative elements") {
+    const std::vector<double> x{3.0, -1.0, 1.0};
+    THEN("Only the positive part contributes to the distribution") {
+      std::vector<double> p(x.size());
+      Utils::normalize(x, &p);
+      CHECK(p[0] == Approx(0.75));
+      CHECK(p[1] == 0.0);
+      CHECK(p[2] == Approx(0.25));
+    }
+  }
+  GIVEN("Ties for the largest element") {
+    const std::vector<double> x{1.0, 5.0, 2.0, 5.0};
+    THEN("argmax returns the first of them") {
+      CHECK(Utils::argmax(x.data(), x.size()) == 1);
+    }
+  }
+}
+
+SCENARIO("Counter-based random numbers") {
+  GIVEN("The Philox4x32-10 known-answer vectors") {
+    THEN("Each block matches the reference implementation") {
+      auto block = Utils::Philox4x32::generate({{0, 0, 0, 0}}, {{0, 0}});
+      CHECK(block[0] == 0x6627e8d5);
+      CHECK(block[1] == 0xe169c58d);
+      CHECK(block[2] == 0xbc57ac4c);
+      CHECK(block[3] == 0x9b00dbd8);
+
+      block = Utils::Philox4x32::generate(
+          {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+          {{0xa4093822, 0x299f31d0}});
+      CHECK(block[0] == 0xd16cfe09);
+      CHECK(block[1] == 0x94fdcceb);
+      CHECK(block[2] == 0x5001e420);
+      CHECK(block[3] == 0x24126ea1);
+    }
+  }
+  GIVEN("A seed, iteration, and stream") {
+    const size_t n = 300;
+    std::vector<double> signs(n);
+    Utils::randomSigns(7, 3, 11, n, signs.data());
+    THEN("Every draw is a sign and both signs are common") {
+      size_t numPositive = 0;
+      for (auto sign : signs) {
+        REQUIRE((sign == 1.0 || sign == -1.0));
+        numPositive += sign > 0;
+      }
+      CHECK(numPositive > n / 3);
+      CHECK(numPositive < 2 * n / 3);
+    }
+    THEN("Drawing a prefix reproduces the same signs") {
+      std::vector<float> prefix(n / 2);
+      Utils::randomSigns(7, 3, 11, prefix.size(), prefix.data());
+      for (size_t i = 0; i < prefix.size(); ++i) {
+        CHECK(prefix[i] == signs[i]);
+      }
+    }
+    THEN("Changing any part of the key changes the draws") {
+      std::vector<double> other(n);
+      Utils::randomSigns(7, 4, 11, n, other.data());
+      CHECK(other != signs);
+      Utils::randomSigns(7, 3, 12, n, other.data());
+      CHECK(other != signs);
+      Utils::randomSigns(8, 3, 11, n, other.data());
+      CHECK(other != signs);
+    }
+  }
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <test_helper.hpp>
+
+#include <lib/poker.hpp>
+#include <lib/policy_generator.hpp>
+#include <lib/sequence_form.hpp>
+#include <lib/vector_form.hpp>
+
+extern "C" {
+#include <cpp_utilities/src/lib/print_debugger.h>
+}
+
+using namespace TreeAndHistoryTraversal;
+
+/**
+ * Lays out a public tree profile for the compiled full game, matching
+ * information sets by name.
+ */
+static std::vector<std::vector<double>> toSequenceForm(
+    const VectorForm::PublicTree& tree,
+    const std::vector<std::vector<double>>& profile,
+    const SequenceForm::CompiledGame& game) {
+  std::vector<std::vector<double>> relaidProfile(2);
+  for (size_t player = 0; player < 2; ++player) {
+    relaidProfile[player].resize(game.numSequences(player));
+    const auto& names = tree.infoSetNames[player];
+    for (size_t I = 0; I < game.numInfoSets(player); ++I) {
+      const size_t J =
+          std::find(names.begin(), names.end(),
+                    game.infoSetNames[player][I]) -
+          names.begin();
+      REQUIRE(J < names.size());
+      std::copy_n(
+          &profile[player][tree.numSequencesBeforeEachInfoSet[player][J]],
+          game.numActionsAtEachInfoSet[player][I],
+          &relaidProfile[player][game.numSequencesBeforeEachInfoSet[player]
+                                                                   [I]]);
+    }
+  }
+  return relaidProfile;
+}
+
+SCENARIO("Vector-form CFR on Kuhn poker") {
+  Poker::KuhnPokerPublicHistory publicRoot;
+  const auto tree = VectorForm::compile(&publicRoot);
+  Poker::KuhnPokerHistory root;
+  const auto game = SequenceForm::compile(&root);
+
+  GIVEN("The public tree") {
+    THEN("It has the full game's information sets at far fewer nodes") {
+      CHECK(publicRoot.isEmpty());
+      CHECK(tree.numNodes() == 9);
+      for (size_t player = 0; player < 2; ++player) {
+        CHECK(tree.numInfoSets(player) == game.numInfoSets(player));
+        CHECK(tree.numSequences(player) == game.numSequences(player));
+      }
+    }
+  }
+  GIVEN("CFR run on the public tree") {
+    auto cfr = Test::newCfr<VectorForm::Cfr>(tree);
+    cfr->doIterations(1e4);
+    const auto profile = toSequenceForm(tree, cfr->strategyProfile(), game);
+    THEN("It finds the game's value") {
+      CHECK(SequenceForm::expectedUtilities(game, profile)[0] ==
+            Approx(-1.0 / 18).epsilon(0.01));
+      CHECK(cfr->averageExploitability() < 1e-3);
+    }
+    THEN("Its best responses match those on the full game") {
+      const auto expected =
+          SequenceForm::BestResponse<>(game, profile).valueProfile();
+      const auto brValues =
+          VectorForm::BestResponse<>(tree, cfr->strategyProfile())
+              .valueProfile();
+      CHECK(brValues[0] == Approx(expected[0]));
+      CHECK(brValues[1] == Approx(expected[1]));
+    }
+  }
+}
+
+SCENARIO("Vector-form CFR on Leduc hold'em") {
+  Poker::LeducHoldemPublicHistory publicRoot;
+  const auto tree = VectorForm::compile(&publicRoot);
+  Poker::LeducHoldemHistory root;
+  const auto game = SequenceForm::compile(&root);
+
+  GIVEN("The public tree") {
+    THEN("It has the full game's information sets") {
+      CHECK(publicRoot.isEmpty());
+      CHECK(tree.numInfoSets(0) == 144);
+      CHECK(tree.numInfoSets(1) == 144);
+    }
+  }
+  GIVEN("CFR run on the public tree") {
+    auto cfr = Test::newCfr<VectorForm::Cfr>(tree);
+    cfr->doIterations(500);
+    const auto profile = toSequenceForm(tree, cfr->strategyProfile(), game);
+    THEN("Its best responses match those on the full game") {
+      const auto expected =
+          SequenceForm::BestResponse<>(game, profile).valueProfile();
+      const auto brValues =
+          VectorForm::BestResponse<>(tree, cfr->strategyProfile())
+              .valueProfile();
+      CHECK(brValues[0] == Approx(expected[0]));
+      CHECK(brValues[1] == Approx(expected[1]));
+    }
+    THEN("It approaches the game's value") {
+      CHECK(SequenceForm::expectedUtilities(game, profile)[0] ==
+            Approx(-0.0856).epsilon(0.1));
+    }
+  }
+}